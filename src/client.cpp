@@ -0,0 +1,186 @@
+/**
+ * @file client.cpp
+ * @brief Implementation of the thin game client.
+ *
+ * Classes:
+ * - GameClient: Sends keys to the game server and applies the frame deltas it sends back.
+ *
+ * Dependencies:
+ * - client.h: Declaration of the GameClient class.
+ * - frame.h: Frame deltas and message framing.
+ * - POSIX sockets (UNIX domain).
+ */
+
+#include <string>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "client.h"
+
+/**
+ * @brief Connects to a game server.
+ *
+ * @param path Path of the server's UNIX socket.
+ * @throws std::runtime_error If the server cannot be reached.
+ */
+GameClient::GameClient(const std::string &path)
+    : fd(-1), is_changed(false), is_ended(false), score(0), turn(0), casualty(0)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    std::strcpy(address.sun_path, path.c_str());
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        std::string reason = std::strerror(errno);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        throw std::runtime_error("Cannot connect to " + path + ": " + reason);
+    }
+}
+
+/**
+ * @brief Closes the connection, which ends the game on the server.
+ *
+ */
+GameClient::~GameClient(void)
+{
+    close(fd);
+}
+
+/**
+ * @brief Checks whether a frame arrived since the last call, and clears the flag.
+ *
+ * @return bool: True if the frame should be painted again.
+ */
+bool GameClient::check_changed(void)
+{
+    bool changed = is_changed;
+    is_changed = false;
+    return changed;
+}
+
+/**
+ * @brief Queues the message that starts a game on the server.
+ *
+ * @param level Difficulty level, from 1 to 3.
+ */
+void GameClient::start(int level)
+{
+    std::string payload;
+    Message::put_u8(payload, level);
+    outbox += Message::pack(MessageType::HELLO, payload);
+}
+
+/**
+ * @brief Queues a key press for the server.
+ *
+ * @param key Key code as returned by getch().
+ */
+void GameClient::press(int key)
+{
+    std::string payload;
+    Message::put_u32(payload, uint32_t(key));
+    outbox += Message::pack(MessageType::KEY, payload);
+}
+
+/**
+ * @brief Writes every queued message. Key messages are tiny, so this blocks only briefly.
+ *
+ * @return bool: False if the connection failed.
+ */
+bool GameClient::flush(void)
+{
+    size_t written = 0;
+    while (written < outbox.size())
+    {
+        ssize_t length = send(fd, outbox.data() + written, outbox.size() - written, MSG_NOSIGNAL);
+        if (length < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (length <= 0)
+        {
+            return false;
+        }
+        written += length;
+    }
+    outbox.clear();
+    return true;
+}
+
+/**
+ * @brief Reads everything the server sent without blocking and applies each complete message.
+ *
+ * @return bool: False if the server closed the connection or sent a malformed stream.
+ */
+bool GameClient::receive(void)
+{
+    char buffer[16384];
+    bool is_open = true;
+    while (true)
+    {
+        ssize_t length = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (length > 0)
+        {
+            inbox.append(buffer, length);
+        }
+        else if (length < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            // NOTE: the server closes after END, so the rest of the stream is still applied
+            is_open = length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            break;
+        }
+    }
+
+    try
+    {
+        MessageType type;
+        std::string payload;
+        while (Message::unpack(inbox, type, payload))
+        {
+            handle(type, payload);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        return false;
+    }
+    return is_open;
+}
+
+/**
+ * @brief Applies one message from the server.
+ *
+ * @param type Kind of the message.
+ * @param payload Message body.
+ */
+void GameClient::handle(MessageType type, const std::string &payload)
+{
+    if (type == MessageType::FRAME)
+    {
+        frame.apply(payload);
+        is_changed = true;
+    }
+    else if (type == MessageType::END && payload.size() == 12)
+    {
+        score = int32_t(Message::get_u32(payload, 0));
+        turn = int32_t(Message::get_u32(payload, 4));
+        casualty = int32_t(Message::get_u32(payload, 8));
+        is_ended = true;
+    }
+}
@@ -0,0 +1,55 @@
+/**
+ * @file client.h
+ * @brief Thin client of the game server
+ *
+ * A client runs no simulation: it sends the keys pressed to the server and applies the
+ * frame deltas it receives to the single frame it keeps. Its whole state is that frame
+ * and the socket buffers, so hundreds of clients fit where one full game would.
+ */
+
+#ifndef CLIENT_H
+#define CLIENT_H
+
+#include <string>
+#include "frame.h"
+
+/**
+ * @class GameClient
+ * @brief Connection to a game server holding the latest frame received.
+ */
+class GameClient
+{
+private:
+    int fd;
+    Frame frame;         ///< Screen as last sent by the server
+    bool is_changed;     ///< Whether a frame arrived since the last check
+    bool is_ended;       ///< Whether the server reported the end of the game
+    int score;
+    int turn;
+    int casualty;
+    std::string inbox;   ///< Received bytes not yet forming a whole message
+    std::string outbox;  ///< Bytes queued for the server
+
+    void handle(MessageType type, const std::string &payload);
+
+public:
+    GameClient(const std::string &path);
+    ~GameClient(void);
+    GameClient(const GameClient &) = delete;
+    GameClient &operator=(const GameClient &) = delete;
+
+    int get_fd(void) const { return fd; };
+    const Frame &get_frame(void) const { return frame; };
+    bool check_changed(void); ///< Whether a frame arrived since the last call
+    bool check_ended(void) const { return is_ended; };
+    int get_score(void) const { return score; };
+    int get_turn(void) const { return turn; };
+    int get_casualty(void) const { return casualty; };
+
+    void start(int level); ///< Queue the HELLO message that starts a game
+    void press(int key);   ///< Queue a key press
+    bool flush(void);      ///< Write queued messages, false if the server is gone
+    bool receive(void);    ///< Read and apply everything available, false if the server is gone
+};
+
+#endif
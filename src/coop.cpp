@@ -0,0 +1,407 @@
+/**
+ * @file coop.cpp
+ * @brief Implementation of the lockstep co-op session.
+ *
+ * Classes:
+ * - CoopSession: Queues the local player's orders, exchanges them with the other player
+ *   every turn and replays both bundles in the same order on both sides.
+ *
+ * Dependencies:
+ * - coop.h: Declaration of the CoopSession class.
+ * - frame.h: Message framing shared with the game server.
+ * - POSIX sockets (UNIX domain).
+ */
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "coop.h"
+
+/**
+ * @brief Connects the two players: the host waits for the guest on a UNIX socket.
+ *
+ * @param path Path of the UNIX socket.
+ * @param h Whether this side hosts the game.
+ * @param g Game simulated on this side.
+ * @param om Operation menu of the local player.
+ * @param tm Tech menu of the local player.
+ * @throws std::runtime_error If the players cannot be connected.
+ */
+CoopSession::CoopSession(const std::string &path, bool h, Game &g, OperationMenu &om, TechMenu &tm)
+    : fd(-1), is_host(h), game(g), operation_menu(om), tech_menu(tm),
+      hash(0), peer_hash(0), is_ready(false), is_peer_ready(false), is_desynced(false)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    std::strcpy(address.sun_path, path.c_str());
+
+    int s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (is_host)
+    {
+        unlink(path.c_str());
+        if (s >= 0 && bind(s, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0 && listen(s, 1) == 0)
+        {
+            fd = accept4(s, nullptr, nullptr, SOCK_CLOEXEC);
+        }
+        std::string reason = std::strerror(errno);
+        if (s >= 0)
+        {
+            close(s);
+        }
+        unlink(path.c_str()); // NOTE: one guest only, nobody else may join
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot host on " + path + ": " + reason);
+        }
+    }
+    else
+    {
+        if (s < 0 || connect(s, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0)
+        {
+            std::string reason = std::strerror(errno);
+            if (s >= 0)
+            {
+                close(s);
+            }
+            throw std::runtime_error("Cannot join " + path + ": " + reason);
+        }
+        fd = s;
+    }
+}
+
+/**
+ * @brief Closes the connection, which ends the game for the other player.
+ *
+ */
+CoopSession::~CoopSession(void)
+{
+    close(fd);
+}
+
+/**
+ * @brief Sends a message. Messages are a few bytes, so this blocks only briefly.
+ *
+ * @param type Kind of the message.
+ * @param payload Message body.
+ * @throws std::runtime_error If the other player is gone.
+ */
+void CoopSession::send(MessageType type, const std::string &payload)
+{
+    std::string bytes = Message::pack(type, payload);
+    size_t written = 0;
+    while (written < bytes.size())
+    {
+        ssize_t length = ::send(fd, bytes.data() + written, bytes.size() - written, MSG_NOSIGNAL);
+        if (length < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (length <= 0)
+        {
+            throw std::runtime_error("Connection to the other player lost");
+        }
+        written += length;
+    }
+}
+
+/**
+ * @brief Agrees on the game: the host sends its level and seed, the guest adopts them.
+ * Both games must have been reset from the same assets.
+ *
+ * @param level Difficulty level chosen by the host, ignored on the guest.
+ * @throws std::runtime_error If the connection fails before the game starts.
+ */
+void CoopSession::start(int level)
+{
+    uint64_t seed = game.get_missile_manager().get_seed();
+    if (is_host)
+    {
+        std::string payload;
+        Message::put_u8(payload, level);
+        Message::put_u32(payload, uint32_t(seed));
+        Message::put_u32(payload, uint32_t(seed >> 32));
+        send(MessageType::START, payload);
+    }
+    else
+    {
+        MessageType type;
+        std::string payload;
+        bool is_started = false;
+        while (!is_started)
+        {
+            if (Message::unpack(inbox, type, payload))
+            {
+                is_started = type == MessageType::START && payload.size() == 9;
+                continue;
+            }
+            char buffer[256];
+            ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+            if (length < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (length <= 0)
+            {
+                throw std::runtime_error("Host left before the game started");
+            }
+            inbox.append(buffer, length);
+        }
+        level = uint8_t(payload[0]);
+        seed = Message::get_u32(payload, 1) | uint64_t(Message::get_u32(payload, 5)) << 32;
+        game.get_missile_manager().set_seed(seed);
+    }
+    game.set_difficulty(level);
+    operation_menu.update_items();
+}
+
+/**
+ * @brief Queues an order of the local player with the current cursor.
+ *
+ * @param key Order key.
+ * @param item Selection the order applies to.
+ */
+void CoopSession::queue(uint8_t key, uint8_t item)
+{
+    if (is_ready)
+    {
+        game.insert_feedback("Turn ended, waiting for the other player", COLOR_PAIR(3));
+        return;
+    }
+    if (orders.size() == 255) // The count is sent as one byte
+    {
+        return;
+    }
+    CoopOrder order = {key, item, game.get_cursor()};
+    orders.push_back(order);
+    game.insert_feedback("Order queued for the end of the turn", A_NORMAL);
+}
+
+/**
+ * @brief Applies a key pressed on the game screen. Cursor and menu keys act at once on
+ * the local view; operations are queued; space ends the turn for the local player.
+ *
+ * @param key Key code as returned by getch().
+ * @return GameCommand RESEARCH to open the tech menu, QUIT to leave, NONE otherwise.
+ */
+GameCommand CoopSession::handle_key(int key)
+{
+    switch (key)
+    {
+    case '\n': // Enter key
+        if (operation_menu.get_item_id() == OPERATION_RESEARCH)
+        {
+            return GameCommand::RESEARCH;
+        }
+        queue('\n', operation_menu.get_item_id());
+        return GameCommand::NONE;
+    case 'f':
+    case 'b':
+    case 'l':
+        queue(key, 0);
+        return GameCommand::NONE;
+
+    case ' ': // Space key
+        if (!is_ready && !is_desynced)
+        {
+            hash = game.get_state_hash();
+            std::string payload;
+            Message::put_u32(payload, game.get_turn());
+            Message::put_u32(payload, uint32_t(hash));
+            Message::put_u32(payload, uint32_t(hash >> 32));
+            Message::put_u8(payload, orders.size());
+            for (auto &order : orders)
+            {
+                Message::put_u8(payload, order.key);
+                Message::put_u8(payload, order.item);
+                Message::put_u16(payload, order.cursor.y);
+                Message::put_u16(payload, order.cursor.x);
+            }
+            send(MessageType::TURN, payload);
+            is_ready = true;
+            advance();
+        }
+        return GameCommand::NONE;
+    case 'p': // NOTE: the game cannot be paused for the other player
+        return GameCommand::NONE;
+
+    default:
+        return operation_menu.handle_key(key); // Cursor, menu, quick-select, research and quit
+    }
+}
+
+/**
+ * @brief Queues research of the node selected in the tech menu.
+ *
+ */
+void CoopSession::order_research(void)
+{
+    if (tech_menu.check_tech_node())
+    {
+        queue('r', tech_menu.get_cursor());
+    }
+}
+
+/**
+ * @brief Reads the other player's bundle, if it arrived, and advances the turn when both ended it.
+ *
+ * @return bool: False if the other player left or sent a malformed stream.
+ */
+bool CoopSession::receive(void)
+{
+    char buffer[4096];
+    bool is_open = true;
+    while (true)
+    {
+        ssize_t length = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (length > 0)
+        {
+            inbox.append(buffer, length);
+        }
+        else if (length < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            // NOTE: the other side quits right after the last turn, which must still be played
+            is_open = length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+            break;
+        }
+    }
+
+    try
+    {
+        MessageType type;
+        std::string payload;
+        while (!is_peer_ready && Message::unpack(inbox, type, payload))
+        {
+            if (type != MessageType::TURN || payload.size() < 13)
+            {
+                continue;
+            }
+            size_t count = uint8_t(payload[12]);
+            if (payload.size() != 13 + count * 6)
+            {
+                return false;
+            }
+            int peer_turn = int(Message::get_u32(payload, 0));
+            if (!is_desynced && peer_turn != game.get_turn()) // NOTE: reported here, advance() stops at a known desync
+            {
+                is_desynced = true;
+                game.insert_feedback("Desync on turn " + std::to_string(game.get_turn()) + ", the other player is on turn " +
+                                         std::to_string(peer_turn) + ", game stopped",
+                                     COLOR_PAIR(2));
+            }
+            peer_hash = Message::get_u32(payload, 4) | uint64_t(Message::get_u32(payload, 8)) << 32;
+            for (size_t index = 0; index < count; index++)
+            {
+                size_t offset = 13 + index * 6;
+                uint32_t cursor = Message::get_u32(payload, offset + 2);
+                CoopOrder order = {uint8_t(payload[offset]), uint8_t(payload[offset + 1]),
+                                   Position(int(cursor & 0xFFFF), int(cursor >> 16))};
+                peer_orders.push_back(order);
+            }
+            is_peer_ready = true;
+            advance();
+        }
+    }
+    catch (const std::exception &e)
+    {
+        return false;
+    }
+    return is_open;
+}
+
+/**
+ * @brief Replays an order with the cursor and selection of the player who gave it.
+ *
+ * @param order Order to apply.
+ */
+void CoopSession::apply(const CoopOrder &order)
+{
+    game.move_cursor(order.cursor - game.get_cursor());
+    operation_menu.update_items();
+    if (order.key == '\n')
+    {
+        if (operation_menu.select_item(order.item)) // Not shown any more means not possible any more
+        {
+            operation_menu.handle_key('\n');
+        }
+    }
+    else if (order.key == 'r')
+    {
+        while (tech_menu.get_cursor() != order.item && tech_menu.get_cursor() < int(tech_menu.get_items().size()))
+        {
+            int cursor = tech_menu.get_cursor();
+            tech_menu.move_cursor(cursor < order.item ? 1 : -1);
+            if (tech_menu.get_cursor() == cursor)
+            {
+                break; // Out of range
+            }
+        }
+        if (tech_menu.get_cursor() == order.item && tech_menu.check_tech_node())
+        {
+            game.start_research(tech_menu.get_tech_node());
+            game.check_research();
+        }
+    }
+    else
+    {
+        operation_menu.handle_key(order.key);
+    }
+}
+
+/**
+ * @brief Ends the turn once both players have: checks the hashes, applies the host's
+ * orders then the guest's, and passes the turn. The local selection is restored after.
+ *
+ */
+void CoopSession::advance(void)
+{
+    if (!is_ready || !is_peer_ready || is_desynced)
+    {
+        return;
+    }
+    if (hash != peer_hash)
+    {
+        is_desynced = true;
+        game.insert_feedback("Desync on turn " + std::to_string(game.get_turn()) + ", game stopped", COLOR_PAIR(2));
+        return;
+    }
+
+    Position cursor = game.get_cursor();
+    int operation = operation_menu.get_item_id();
+    int tech = tech_menu.get_cursor();
+    for (auto &order : is_host ? orders : peer_orders)
+    {
+        apply(order);
+    }
+    for (auto &order : is_host ? peer_orders : orders)
+    {
+        apply(order);
+    }
+    game.pass_turn();
+
+    game.move_cursor(cursor - game.get_cursor());
+    operation_menu.update_items();
+    operation_menu.select_item(operation);
+    while (tech_menu.get_cursor() != tech)
+    {
+        tech_menu.move_cursor(tech_menu.get_cursor() < tech ? 1 : -1);
+    }
+
+    orders.clear();
+    peer_orders.clear();
+    is_ready = false;
+    is_peer_ready = false;
+}
@@ -0,0 +1,82 @@
+/**
+ * @file coop.h
+ * @brief Deterministic lockstep co-op between two players on local sockets
+ *
+ * Both players run the whole simulation. The game is deterministic given its seed, so
+ * it is enough to share the seed once and then, every turn, the orders each player gave:
+ * a few bytes per turn however many missiles fly. Orders are queued during the turn and
+ * applied on both sides in the same order (host first) when both players have ended it.
+ * Each bundle carries a hash of the state it was issued from, so a desync is caught on
+ * the turn it happens.
+ */
+
+#ifndef COOP_H
+#define COOP_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "game.h"
+#include "menu.h"
+#include "frame.h"
+#include "utils.h"
+
+/**
+ * @struct CoopOrder
+ * @brief A state-changing key together with the selection it applied to.
+ */
+struct CoopOrder
+{
+    uint8_t key;     ///< Game key, or 'r' to start a research
+    uint8_t item;    ///< Operation id for the Enter key, tech menu index for 'r'
+    Position cursor; ///< Map cursor of the player who gave the order
+};
+
+/**
+ * @class CoopSession
+ * @brief One side of a two-player game, exchanging per-turn order bundles with the other.
+ *
+ * Cursor, menu and view keys stay local; each player has their own cursor. Orders are
+ * replayed with the issuer's cursor and selection, through the same handle_key as the
+ * single-player game.
+ */
+class CoopSession
+{
+private:
+    int fd;
+    bool is_host;
+    Game &game;
+    OperationMenu &operation_menu;
+    TechMenu &tech_menu;
+
+    std::vector<CoopOrder> orders;      ///< Orders of the local player for this turn
+    std::vector<CoopOrder> peer_orders; ///< Orders of the other player for this turn
+    uint64_t hash;                      ///< State hash sent with the local bundle
+    uint64_t peer_hash;                 ///< State hash received with the other bundle
+    bool is_ready;                      ///< Whether the local player ended the turn
+    bool is_peer_ready;                 ///< Whether the other player ended the turn
+    bool is_desynced;
+    std::string inbox;                  ///< Received bytes not yet forming a whole message
+
+    void send(MessageType type, const std::string &payload);
+    void queue(uint8_t key, uint8_t item);
+    void apply(const CoopOrder &order);
+    void advance(void);
+
+public:
+    CoopSession(const std::string &path, bool h, Game &g, OperationMenu &om, TechMenu &tm);
+    ~CoopSession(void);
+    CoopSession(const CoopSession &) = delete;
+    CoopSession &operator=(const CoopSession &) = delete;
+
+    int get_fd(void) const { return fd; };
+    bool check_waiting(void) const { return is_ready && !is_peer_ready; }; ///< Turn ended locally only
+    bool check_desynced(void) const { return is_desynced; };
+
+    void start(int level);            ///< Agree on the level and seed (blocks until the host's START)
+    GameCommand handle_key(int key);  ///< Apply a key pressed on the game screen
+    void order_research(void);        ///< Queue research of the node selected in the tech menu
+    bool receive(void);               ///< Read the other bundle, false if the other player left
+};
+
+#endif
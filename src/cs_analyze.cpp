@@ -0,0 +1,339 @@
+/**
+ * @file cs_analyze.cpp
+ * @brief Entry point of the telemetry analyser
+ *
+ * Reads every telemetry file (see telemetry.h) of the given directories and prints
+ * aggregate statistics as one CSV table. Files are memory-mapped and spread over worker
+ * threads; each worker tallies its own files and the tallies are merged at the end, so
+ * the workers never share anything but the index of the next file.
+ *
+ * Tables, in the `table` column:
+ * - outcome: games won and lost per difficulty level, `mean_turn` is the mean last turn.
+ *   Games that were abandoned before the end count as `unfinished` instead.
+ * - first_fall: the city destroyed first (index in "cities.txt"), `mean_turn` is the turn it fell.
+ * - first_impact: games with an impact, `mean_turn` is the turn of the first one.
+ * - research: the order technologies were researched in, `mean_turn` is the mean last turn.
+ *
+ * Usage: `cs-analyze [-j JOBS] DIRECTORY...`
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "game.h"
+#include "telemetry.h"
+
+/**
+ * @struct Tally
+ * @brief Games counted under one key, with their wins and a mean turn.
+ */
+struct Tally
+{
+    long games = 0;
+    long wins = 0;
+    double turns = 0; ///< Sum of the turn being averaged
+
+    void add(bool is_win, int turn)
+    {
+        games++;
+        wins += is_win ? 1 : 0;
+        turns += turn;
+    }
+    void merge(const Tally &other)
+    {
+        games += other.games;
+        wins += other.wins;
+        turns += other.turns;
+    }
+};
+
+/**
+ * @struct Aggregate
+ * @brief Statistics of a set of games, keyed by difficulty level first.
+ */
+struct Aggregate
+{
+    std::map<int, Tally> outcome;
+    std::map<int, long> unfinished;
+    std::map<std::pair<int, int>, Tally> first_fall;
+    std::map<int, Tally> first_impact;
+    std::map<std::pair<int, std::vector<int>>, Tally> research; ///< Tech tree indices in research order
+    long files = 0;
+    long skipped = 0; ///< Not telemetry files, or of another version
+
+    void merge(const Aggregate &other)
+    {
+        for (auto &entry : other.outcome)
+        {
+            outcome[entry.first].merge(entry.second);
+        }
+        for (auto &entry : other.unfinished)
+        {
+            unfinished[entry.first] += entry.second;
+        }
+        for (auto &entry : other.first_fall)
+        {
+            first_fall[entry.first].merge(entry.second);
+        }
+        for (auto &entry : other.first_impact)
+        {
+            first_impact[entry.first].merge(entry.second);
+        }
+        for (auto &entry : other.research)
+        {
+            research[entry.first].merge(entry.second);
+        }
+        files += other.files;
+        skipped += other.skipped;
+    }
+};
+
+/**
+ * @brief Tallies one telemetry file in a single pass over its records.
+ *
+ * @param data Mapped file.
+ * @param size Size of the file.
+ * @param aggregate Receives the statistics of the game.
+ */
+void analyze(const char *data, size_t size, Aggregate &aggregate)
+{
+    TelemetryHeader header;
+    if (size < sizeof(header))
+    {
+        aggregate.skipped++;
+        return;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, "CATL", 4) != 0 || header.version != TelemetryWriter::VERSION || header.cities < 0 ||
+        header.record_size != sizeof(TelemetryRecord) + header.cities * sizeof(int32_t))
+    {
+        aggregate.skipped++;
+        return;
+    }
+    size_t count = (size - sizeof(header)) / header.record_size; // NOTE: a game still running may end in a partial record
+    if (count == 0)
+    {
+        aggregate.skipped++;
+        return;
+    }
+    aggregate.files++;
+
+    TelemetryRecord record;
+    std::vector<int32_t> hitpoints(header.cities);
+    int first_fall = -1;
+    int first_fall_turn = 0;
+    int first_impact_turn = -1;
+    uint32_t researched = 0;
+    std::vector<int> order;
+    bool is_alive = true;
+    for (size_t index = 0; index < count; index++)
+    {
+        const char *slot = data + sizeof(header) + index * header.record_size;
+        std::memcpy(&record, slot, sizeof(record));
+        std::memcpy(hitpoints.data(), slot + sizeof(record), header.cities * sizeof(int32_t));
+
+        if (first_impact_turn < 0 && record.impacted > 0)
+        {
+            first_impact_turn = record.turn;
+        }
+        is_alive = false;
+        for (int city = 0; city < header.cities; city++)
+        {
+            if (hitpoints[city] > 0)
+            {
+                is_alive = true;
+            }
+            else if (first_fall < 0)
+            {
+                first_fall = city;
+                first_fall_turn = record.turn;
+            }
+        }
+        for (uint32_t added = record.researched & ~researched; added; added &= added - 1)
+        {
+            order.push_back(__builtin_ctz(added));
+        }
+        researched = record.researched;
+    }
+
+    int level = header.level;
+    bool is_win = record.enemy_hp <= 0;
+    if (!is_win && is_alive)
+    {
+        aggregate.unfinished[level]++;
+        return;
+    }
+    aggregate.outcome[level].add(is_win, record.turn);
+    if (first_fall >= 0)
+    {
+        aggregate.first_fall[std::make_pair(level, first_fall)].add(is_win, first_fall_turn);
+    }
+    if (first_impact_turn >= 0)
+    {
+        aggregate.first_impact[level].add(is_win, first_impact_turn);
+    }
+    aggregate.research[std::make_pair(level, order)].add(is_win, record.turn);
+}
+
+/**
+ * @brief Maps a file read-only and tallies it.
+ *
+ * @param path File to read.
+ * @param aggregate Receives the statistics of the game.
+ */
+void analyze_file(const std::string &path, Aggregate &aggregate)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) < 0 || info.st_size == 0)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        aggregate.skipped++;
+        return;
+    }
+    void *data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        aggregate.skipped++;
+        return;
+    }
+    madvise(data, info.st_size, MADV_SEQUENTIAL);
+    analyze(static_cast<const char *>(data), info.st_size, aggregate);
+    munmap(data, info.st_size);
+}
+
+/**
+ * @brief Lists the telemetry files of a directory.
+ *
+ * @param directory Directory to scan.
+ * @param paths Receives the paths of the ".tlm" files.
+ */
+void list_files(const std::string &directory, std::vector<std::string> &paths)
+{
+    DIR *handle = opendir(directory.c_str());
+    if (handle == nullptr)
+    {
+        std::cerr << "Cannot open " << directory << '\n';
+        return;
+    }
+    while (dirent *entry = readdir(handle))
+    {
+        std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".tlm") == 0)
+        {
+            paths.push_back(directory + "/" + name);
+        }
+    }
+    closedir(handle);
+}
+
+/**
+ * @brief Prints one CSV row.
+ *
+ * @param table Name of the table.
+ * @param level Difficulty level.
+ * @param key Key within the table, quoted.
+ * @param tally Games counted under the key.
+ */
+void print_row(const std::string &table, int level, const std::string &key, const Tally &tally)
+{
+    std::cout << table << ',' << level << ",\"" << key << "\"," << tally.games << ',' << tally.wins << ','
+              << (tally.games ? double(tally.wins) / tally.games : 0) << ','
+              << (tally.games ? tally.turns / tally.games : 0) << '\n';
+}
+
+/**
+ * @brief Spreads the files over worker threads, merges their tallies and prints them.
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @return int Program exit status
+ */
+int main(int argc, char **argv)
+{
+    int jobs = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::string> paths;
+    int first = 1;
+    if (argc > 2 && std::string(argv[1]) == "-j")
+    {
+        jobs = std::max(1, std::atoi(argv[2]));
+        first = 3;
+    }
+    if (first >= argc)
+    {
+        std::cerr << "Usage: " << argv[0] << " [-j JOBS] DIRECTORY..." << '\n';
+        return 1;
+    }
+    for (int index = first; index < argc; index++)
+    {
+        list_files(argv[index], paths);
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<Aggregate> partials(jobs);
+    std::vector<std::thread> workers;
+    std::atomic<size_t> next(0);
+    for (int job = 0; job < jobs; job++)
+    {
+        workers.emplace_back([&paths, &partials, &next, job](void)
+                             {
+                                 for (size_t index = next++; index < paths.size(); index = next++)
+                                 {
+                                     analyze_file(paths[index], partials[job]);
+                                 }
+                             });
+    }
+    Aggregate total;
+    for (int job = 0; job < jobs; job++)
+    {
+        workers[job].join();
+        total.merge(partials[job]);
+    }
+
+    std::vector<std::string> techs = TechTree().get_tech_names();
+    std::cout << "table,level,key,games,wins,win_rate,mean_turn" << '\n';
+    for (auto &entry : total.unfinished)
+    {
+        total.outcome[entry.first]; // NOTE: levels where no game was finished are listed too
+    }
+    for (auto &entry : total.outcome)
+    {
+        print_row("outcome", entry.first, "finished", entry.second);
+        Tally unfinished;
+        unfinished.games = total.unfinished[entry.first];
+        print_row("outcome", entry.first, "unfinished", unfinished);
+    }
+    for (auto &entry : total.first_fall)
+    {
+        print_row("first_fall", entry.first.first, std::to_string(entry.first.second), entry.second);
+    }
+    for (auto &entry : total.first_impact)
+    {
+        print_row("first_impact", entry.first, "any", entry.second);
+    }
+    for (auto &entry : total.research)
+    {
+        std::string key;
+        for (auto tech : entry.first.second)
+        {
+            key += (key.empty() ? "" : " > ") + (tech < int(techs.size()) ? techs[tech] : std::to_string(tech));
+        }
+        print_row("research", entry.first.first, key.empty() ? "none" : key, entry.second);
+    }
+    std::cerr << total.files << " games read, " << total.skipped << " files skipped" << '\n';
+    return 0;
+}
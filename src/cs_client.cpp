@@ -0,0 +1,126 @@
+/**
+ * @file cs_client.cpp
+ * @brief Entry point of the thin terminal client for the game server
+ *
+ * Connects to a server started with `main --server`, forwards every key pressed and
+ * paints the frames sent back. The game itself runs on the server. With `--watch`, it
+ * connects to a game started with `main --broadcast` instead and only paints its frames.
+ *
+ * Usage: `cs-client SOCKET [LEVEL]`, where LEVEL is the difficulty from 1 to 3, or
+ * `cs-client --watch SOCKET`.
+ */
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include <ncurses.h>
+#include <poll.h>
+
+#include "screen.h"
+#include "client.h"
+
+/**
+ * @brief Initialize terminal interface settings, as the game does.
+ *
+ */
+void init(void)
+{
+    setlocale(LC_CTYPE, "");
+    initscr();
+    noecho();
+    curs_set(0);
+    start_color();
+    nodelay(stdscr, TRUE);
+    keypad(stdscr, TRUE);
+
+    init_pair(1, COLOR_BLACK, COLOR_CYAN);
+    init_pair(2, COLOR_WHITE, COLOR_RED);
+    init_pair(3, COLOR_WHITE, COLOR_YELLOW);
+    init_pair(4, COLOR_WHITE, COLOR_GREEN);
+}
+
+/**
+ * @brief Client loop: send keys, wait up to 10 ms for frames, paint the latest one.
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @return int Program exit status
+ */
+int main(int argc, char **argv)
+{
+    bool is_watching = argc > 1 && std::string(argv[1]) == "--watch";
+    if (argc < (is_watching ? 3 : 2))
+    {
+        std::cerr << "Usage: " << argv[0] << " SOCKET [LEVEL]" << '\n';
+        std::cerr << "       " << argv[0] << " --watch SOCKET" << '\n';
+        return 1;
+    }
+
+    try
+    {
+        GameClient client(argv[is_watching ? 2 : 1]);
+        if (!is_watching)
+        {
+            client.start(argc > 2 ? std::stoi(argv[2]) : 1);
+        }
+        init();
+
+        std::unique_ptr<FrameRenderer> renderer;
+        bool is_quitting = false;
+        bool is_open = true;
+        while (is_open && !is_quitting && !client.check_ended())
+        {
+            int key;
+            while ((key = getch()) != ERR)
+            {
+                if (is_watching)
+                {
+                    is_quitting = is_quitting || key == '\033' || key == 'q';
+                    continue; // Spectators send nothing
+                }
+                client.press(key);
+                is_quitting = is_quitting || key == '\033';
+            }
+            if (!client.flush())
+            {
+                break;
+            }
+
+            pollfd ready = {client.get_fd(), POLLIN, 0};
+            poll(&ready, 1, 10);
+            is_open = client.receive();
+
+            if (client.check_changed())
+            {
+                // NOTE: the layout only changes with a keyframe, so windows are rarely rebuilt
+                const FrameLayout &layout = client.get_frame().get_layout();
+                if (!renderer || !(renderer->get_layout() == layout))
+                {
+                    renderer.reset();
+                    renderer.reset(new FrameRenderer(layout));
+                    renderer->init();
+                }
+                renderer->paint(client.get_frame());
+                renderer->render();
+            }
+        }
+        endwin();
+
+        if (client.check_ended())
+        {
+            std::cout << "GAME OVER  score " << client.get_score() << "  turn " << client.get_turn()
+                      << "  casualty " << client.get_casualty() << '\n';
+        }
+        else if (!is_quitting)
+        {
+            std::cerr << "disconnected from server" << '\n';
+            return 1;
+        }
+        return 0;
+    }
+    catch (const std::exception &e)
+    {
+        endwin();
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
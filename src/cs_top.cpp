@@ -0,0 +1,146 @@
+/**
+ * @file cs_top.cpp
+ * @brief Entry point of the live statistics viewer
+ *
+ * Lists every game running with `live_stats:1` in "general.txt", one row per process,
+ * refreshed twice a second like `top`. The games are read through their shared memory
+ * segments only: the viewer never slows a game down, and a game never waits for it.
+ * Segments left behind by games that crashed are removed.
+ *
+ * Usage: `cs-top`, or `cs-top --once` to print the table once to standard output.
+ */
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <cerrno>
+#include <ncurses.h>
+#include <signal.h>
+#include <sys/mman.h>
+
+#include "stats.h"
+
+/**
+ * @brief Reads the last snapshot of every running game, removing stale segments.
+ *
+ * @return std::vector<LiveSnapshot>: One snapshot per game that finished a turn.
+ */
+std::vector<LiveSnapshot> collect(void)
+{
+    std::vector<LiveSnapshot> snapshots;
+    for (auto &name : LiveStats::list())
+    {
+        int pid = std::atoi(name.c_str() + name.rfind('.') + 1);
+        if (pid > 0 && kill(pid, 0) < 0 && errno == ESRCH)
+        {
+            shm_unlink(name.c_str()); // NOTE: the game died without removing its segment
+            continue;
+        }
+        try
+        {
+            LiveStats stats(name, false);
+            LiveSnapshot snapshot;
+            if (stats.read(snapshot))
+            {
+                snapshots.push_back(snapshot);
+            }
+        }
+        catch (const std::exception &e)
+        {
+            continue; // Being created, or of another version
+        }
+    }
+    return snapshots;
+}
+
+/**
+ * @brief Formats the table header.
+ *
+ * @return std::string: Column titles.
+ */
+std::string format_header(void)
+{
+    std::ostringstream line;
+    line << std::setw(7) << "PID" << std::setw(3) << "LV" << std::setw(6) << "TURN"
+         << std::setw(8) << "DEPOSIT" << std::setw(5) << "PROD" << std::setw(9) << "ENEMY HP"
+         << std::setw(7) << "CITIES" << std::setw(6) << "HP" << std::setw(5) << "ATK"
+         << std::setw(5) << "CRS" << std::setw(7) << "SCORE" << std::setw(8) << "TURN us"
+         << std::setw(6) << "MSL" << std::setw(6) << "HIT" << std::setw(6) << "ECO"
+         << std::setw(6) << "RES" << std::setw(6) << "DEF" << std::setw(6) << "WAVE";
+    return line.str();
+}
+
+/**
+ * @brief Formats one game as a table row.
+ *
+ * @param s Snapshot of the game.
+ * @return std::string: Row matching format_header().
+ */
+std::string format_row(const LiveSnapshot &s)
+{
+    std::ostringstream line;
+    line << std::setw(7) << s.pid << std::setw(3) << s.level << std::setw(6) << s.turn
+         << std::setw(8) << s.deposit << std::setw(5) << s.productivity << std::setw(9) << s.enemy_hp
+         << std::setw(7) << (std::to_string(s.cities_alive) + "/" + std::to_string(s.cities))
+         << std::setw(6) << s.city_hp << std::setw(5) << s.attack_missiles
+         << std::setw(5) << s.cruise_missiles << std::setw(7) << s.score
+         << std::setw(8) << s.turn_ns / 1000;
+    for (int phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        line << std::setw(6) << s.phase_ns[phase] / 1000;
+    }
+    return line.str();
+}
+
+/**
+ * @brief Viewer loop: collect, paint, wait 500 ms for a key.
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
+ * @return int Program exit status
+ */
+int main(int argc, char **argv)
+{
+    if (argc > 1 && std::string(argv[1]) == "--once")
+    {
+        std::cout << format_header() << '\n';
+        for (auto &snapshot : collect())
+        {
+            std::cout << format_row(snapshot) << '\n';
+        }
+        return 0;
+    }
+    if (argc > 1)
+    {
+        std::cerr << "Usage: " << argv[0] << " [--once]" << '\n';
+        return 1;
+    }
+
+    initscr();
+    noecho();
+    curs_set(0);
+    keypad(stdscr, TRUE);
+    timeout(500);
+
+    int key = ERR;
+    while (key != 'q' && key != '\033')
+    {
+        std::vector<LiveSnapshot> snapshots = collect();
+        erase();
+        mvprintw(0, 0, "cs-top  %d game(s)  q to quit", int(snapshots.size()));
+        attron(A_REVERSE);
+        mvprintw(2, 0, "%-*s", COLS, format_header().c_str());
+        attroff(A_REVERSE);
+        for (size_t index = 0; index < snapshots.size() && int(index) + 3 < LINES; index++)
+        {
+            mvprintw(index + 3, 0, "%s", format_row(snapshots[index]).c_str());
+        }
+        refresh();
+        key = getch();
+    }
+    endwin();
+    return 0;
+}
@@ -0,0 +1,436 @@
+/**
+ * @file frame.cpp
+ * @brief Implementation of game frame capture and delta encoding.
+ *
+ * Classes:
+ * - FrameReader: Bounds-checked little-endian reader over an encoded frame.
+ * - Frame: Captures the game screen and encodes or applies differences between frames.
+ * - Message: Length-prefixed message framing shared by the server and its clients.
+ *
+ * Dependencies:
+ * - frame.h: Declaration of the Frame and Message classes.
+ */
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include "frame.h"
+
+/**
+ * @class FrameReader
+ * @brief Reads little-endian integers and strings from an encoded frame, throwing on truncation.
+ */
+class FrameReader
+{
+private:
+    const std::string &in;
+    size_t offset;
+
+    void need(size_t n)
+    {
+        if (in.size() - offset < n)
+        {
+            throw std::runtime_error("Truncated frame");
+        }
+    };
+
+public:
+    FrameReader(const std::string &s) : in(s), offset(0) {};
+    bool is_end(void) const { return offset == in.size(); };
+    uint8_t get_u8(void)
+    {
+        need(1);
+        return uint8_t(in[offset++]);
+    };
+    uint16_t get_u16(void)
+    {
+        uint16_t low = get_u8();
+        return low | uint16_t(get_u8()) << 8;
+    };
+    uint32_t get_u32(void)
+    {
+        uint32_t low = get_u16();
+        return low | uint32_t(get_u16()) << 16;
+    };
+    std::string get_text(size_t n)
+    {
+        need(n);
+        offset += n;
+        return in.substr(offset - n, n);
+    };
+};
+
+/**
+ * @brief Resets to a blank frame of a layout, where every cell and line differs from any captured frame.
+ *
+ * @param l Layout of the frame.
+ */
+void Frame::reset(const FrameLayout &l)
+{
+    layout = l;
+    FrameCell blank = {0, 0};
+    map.assign(size_t(layout.view.h) * layout.view.w, blank);
+    panels.assign(PANEL_COUNT, std::vector<FrameLine>());
+    for (int panel = 0; panel < PANEL_OPERATION; panel++)
+    {
+        panels[panel].resize(panel < int(layout.fields.size()) ? layout.fields[panel] : 0);
+    }
+    panels[PANEL_OPERATION].resize(layout.side.h);
+    panels[PANEL_FEEDBACK].resize(layout.side.h);
+}
+
+/**
+ * @brief Sets one map cell, ignoring cells outside the view.
+ *
+ * @param p Position in view coordinates.
+ * @param glyph Unicode code point.
+ * @param color Colour pair number.
+ */
+void Frame::set_cell(Position p, uint32_t glyph, uint8_t color)
+{
+    if (p.y < 0 || p.y >= layout.view.h || p.x < 0 || p.x >= layout.view.w)
+    {
+        return;
+    }
+    FrameCell &cell = map[p.y * layout.view.w + p.x];
+    cell.glyph = glyph;
+    cell.color = color;
+}
+
+/**
+ * @brief Appends a span to a panel line, ignoring lines outside the panel.
+ *
+ * @param panel FramePanel of the line.
+ * @param line Line within the panel.
+ * @param align Placement of the span.
+ * @param s Text of the span.
+ * @param attr Attribute of the span.
+ */
+void Frame::print(int panel, int line, SpanAlign align, const std::string &s, attr_t attr)
+{
+    if (line < 0 || line >= int(panels.at(panel).size()))
+    {
+        return;
+    }
+    FrameSpan span;
+    span.align = align;
+    span.attr = attr;
+    span.text = s;
+    panels[panel][line].push_back(span);
+}
+
+/**
+ * @brief Encodes the cells and lines of `next` that differ from `prev`; both share a layout.
+ * Changed cells are grouped into runs of identical cells within a row, so a keyframe of a
+ * mostly uniform map stays small.
+ *
+ * @param prev Frame the receiver holds.
+ * @param next Frame to reach.
+ * @param out Receives the encoding.
+ */
+void Frame::encode_body(const Frame &prev, const Frame &next, std::string &out)
+{
+    std::string runs;
+    uint32_t run_count = 0;
+    const Size &view = next.layout.view;
+    for (int line = 0; line < view.h; line++)
+    {
+        for (int col = 0; col < view.w;)
+        {
+            const FrameCell &cell = next.get_cell(Position(line, col));
+            if (cell == prev.get_cell(Position(line, col)))
+            {
+                col++;
+                continue;
+            }
+            int length = 1;
+            while (col + length < view.w && length < 0xFFFF && next.get_cell(Position(line, col + length)) == cell &&
+                   prev.get_cell(Position(line, col + length)) != cell)
+            {
+                length++;
+            }
+            Message::put_u16(runs, line);
+            Message::put_u16(runs, col);
+            Message::put_u16(runs, length);
+            Message::put_u32(runs, cell.glyph);
+            Message::put_u8(runs, cell.color);
+            run_count++;
+            col += length;
+        }
+    }
+    Message::put_u32(out, run_count);
+    out += runs;
+
+    std::string lines;
+    uint16_t line_count = 0;
+    for (int panel = 0; panel < PANEL_COUNT; panel++)
+    {
+        for (int line = 0; line < next.get_lines(panel); line++)
+        {
+            const FrameLine &spans = next.get_line(panel, line);
+            if (spans == prev.get_line(panel, line))
+            {
+                continue;
+            }
+            Message::put_u8(lines, panel);
+            Message::put_u8(lines, line);
+            Message::put_u8(lines, spans.size());
+            for (auto &span : spans)
+            {
+                Message::put_u8(lines, uint8_t(span.align));
+                Message::put_u32(lines, span.attr);
+                Message::put_u16(lines, span.text.size());
+                lines += span.text;
+            }
+            line_count++;
+        }
+    }
+    Message::put_u16(out, line_count);
+    out += lines;
+}
+
+/**
+ * @brief Encodes a whole frame together with its layout.
+ *
+ * @param next Frame to encode.
+ * @return std::string: Encoded keyframe.
+ */
+std::string Frame::encode_keyframe(const Frame &next)
+{
+    std::string out;
+    Message::put_u8(out, 0);
+    Message::put_u16(out, next.layout.view.h);
+    Message::put_u16(out, next.layout.view.w);
+    Message::put_u16(out, next.layout.side.h);
+    Message::put_u16(out, next.layout.side.w);
+    Message::put_u8(out, next.layout.fields.size());
+    for (int field : next.layout.fields)
+    {
+        Message::put_u16(out, field);
+    }
+    encode_body(Frame(next.layout), next, out);
+    return out;
+}
+
+/**
+ * @brief Encodes the difference between two frames, or a keyframe if the layout changed.
+ *
+ * @param prev Frame the receiver holds.
+ * @param next Frame to reach.
+ * @return std::string: Encoded delta.
+ */
+std::string Frame::encode_delta(const Frame &prev, const Frame &next)
+{
+    if (!(prev.layout == next.layout))
+    {
+        return encode_keyframe(next);
+    }
+    std::string out;
+    Message::put_u8(out, 1);
+    encode_body(prev, next, out);
+    return out;
+}
+
+/**
+ * @brief Checks whether an encoded delta holds no run and no line.
+ * A keyframe is never empty, as it carries the layout.
+ *
+ * @param bytes Output of encode_delta.
+ * @return bool: True if applying the delta changes nothing.
+ */
+bool Frame::is_empty_delta(const std::string &bytes)
+{
+    const size_t empty_size = 1 + 4 + 2; // Kind, run count (u32) and line count (u16)
+    return bytes.size() == empty_size && uint8_t(bytes[0]) == 1;
+}
+
+/**
+ * @brief Applies an encoded keyframe or delta to this frame.
+ *
+ * @param bytes Output of encode_keyframe or encode_delta.
+ * @throws std::runtime_error If the encoding is malformed or a delta arrives before any keyframe.
+ */
+void Frame::apply(const std::string &bytes)
+{
+    FrameReader reader(bytes);
+    if (reader.get_u8() == 0)
+    {
+        FrameLayout next;
+        next.view.h = reader.get_u16();
+        next.view.w = reader.get_u16();
+        next.side.h = reader.get_u16();
+        next.side.w = reader.get_u16();
+        for (int count = reader.get_u8(); count > 0; count--)
+        {
+            next.fields.push_back(reader.get_u16());
+        }
+        reset(next);
+    }
+    else if (panels.empty())
+    {
+        throw std::runtime_error("Frame delta before keyframe");
+    }
+
+    for (uint32_t runs = reader.get_u32(); runs > 0; runs--)
+    {
+        int line = reader.get_u16();
+        int col = reader.get_u16();
+        int length = reader.get_u16();
+        uint32_t glyph = reader.get_u32();
+        uint8_t color = reader.get_u8();
+        if (line >= layout.view.h || col + length > layout.view.w)
+        {
+            throw std::runtime_error("Frame run out of view");
+        }
+        for (int index = 0; index < length; index++)
+        {
+            set_cell(Position(line, col + index), glyph, color);
+        }
+    }
+    for (int lines = reader.get_u16(); lines > 0; lines--)
+    {
+        int panel = reader.get_u8();
+        int line = reader.get_u8();
+        if (panel >= PANEL_COUNT || line >= get_lines(panel))
+        {
+            throw std::runtime_error("Frame line out of layout");
+        }
+        FrameLine &spans = panels[panel][line];
+        spans.clear();
+        for (int count = reader.get_u8(); count > 0; count--)
+        {
+            FrameSpan span;
+            span.align = SpanAlign(reader.get_u8());
+            span.attr = reader.get_u32();
+            span.text = reader.get_text(reader.get_u16());
+            spans.push_back(span);
+        }
+    }
+    if (!reader.is_end())
+    {
+        throw std::runtime_error("Trailing bytes after frame");
+    }
+}
+
+/**
+ * @brief Encodes a code point as UTF-8.
+ *
+ * @param glyph Unicode code point.
+ * @return std::string: UTF-8 bytes of the glyph.
+ */
+std::string Frame::to_utf8(uint32_t glyph)
+{
+    std::string out;
+    if (glyph < 0x80)
+    {
+        out.push_back(char(glyph));
+    }
+    else if (glyph < 0x800)
+    {
+        out.push_back(char(0xC0 | (glyph >> 6)));
+        out.push_back(char(0x80 | (glyph & 0x3F)));
+    }
+    else if (glyph < 0x10000)
+    {
+        out.push_back(char(0xE0 | (glyph >> 12)));
+        out.push_back(char(0x80 | ((glyph >> 6) & 0x3F)));
+        out.push_back(char(0x80 | (glyph & 0x3F)));
+    }
+    else
+    {
+        out.push_back(char(0xF0 | (glyph >> 18)));
+        out.push_back(char(0x80 | ((glyph >> 12) & 0x3F)));
+        out.push_back(char(0x80 | ((glyph >> 6) & 0x3F)));
+        out.push_back(char(0x80 | (glyph & 0x3F)));
+    }
+    return out;
+}
+
+/**
+ * @brief Appends a little-endian 16-bit integer.
+ *
+ * @param out Buffer to append to.
+ * @param value Value to append.
+ */
+void Message::put_u16(std::string &out, uint16_t value)
+{
+    out.push_back(char(value & 0xFF));
+    out.push_back(char(value >> 8));
+}
+
+/**
+ * @brief Appends a little-endian 32-bit integer.
+ *
+ * @param out Buffer to append to.
+ * @param value Value to append.
+ */
+void Message::put_u32(std::string &out, uint32_t value)
+{
+    put_u16(out, value & 0xFFFF);
+    put_u16(out, value >> 16);
+}
+
+/**
+ * @brief Reads a little-endian 32-bit integer.
+ *
+ * @param in Buffer to read from, holding at least offset + 4 bytes.
+ * @param offset Position of the integer.
+ * @return uint32_t: The integer.
+ */
+uint32_t Message::get_u32(const std::string &in, size_t offset)
+{
+    uint32_t value = 0;
+    for (int index = 3; index >= 0; index--)
+    {
+        value = value << 8 | uint8_t(in[offset + index]);
+    }
+    return value;
+}
+
+/**
+ * @brief Frames a message for sending.
+ *
+ * @param type Kind of the message.
+ * @param payload Message body.
+ * @return std::string: Length, type and payload.
+ */
+std::string Message::pack(MessageType type, const std::string &payload)
+{
+    std::string out;
+    out.reserve(payload.size() + 5);
+    put_u32(out, payload.size() + 1);
+    put_u8(out, uint8_t(type));
+    out += payload;
+    return out;
+}
+
+/**
+ * @brief Removes the first complete message from a receive buffer.
+ *
+ * @param buffer Bytes received so far.
+ * @param type Receives the kind of the message.
+ * @param payload Receives the message body.
+ * @return bool: Whether a complete message was available.
+ * @throws std::runtime_error If the buffer does not start with a valid length.
+ */
+bool Message::unpack(std::string &buffer, MessageType &type, std::string &payload)
+{
+    if (buffer.size() < 4)
+    {
+        return false;
+    }
+    uint32_t length = get_u32(buffer, 0);
+    if (length == 0 || length > MAX_LENGTH)
+    {
+        throw std::runtime_error("Corrupt message stream");
+    }
+    if (buffer.size() - 4 < length)
+    {
+        return false;
+    }
+    type = MessageType(uint8_t(buffer[4]));
+    payload.assign(buffer, 5, length - 1);
+    buffer.erase(0, 4 + length);
+    return true;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file frame.h
+ * @brief Renderer-independent game frames and their compact binary deltas
+ *
+ * A Frame records what the game screen shows: the glyph and colour of every map cell
+ * in view, and the text spans of every line of the side and bottom panels. Frames are
+ * captured from the game without touching ncurses, so they can be produced by a server
+ * and painted by a thin client.
+ *
+ * Consecutive frames differ in a handful of cells (moving missiles, the cursor) and
+ * panel lines, so only the difference is sent: runs of identical changed cells and
+ * whole changed lines. A keyframe is the difference from a blank frame and also
+ * carries the layout.
+ */
+
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "utils.h"
+
+class Game;
+class OperationMenu;
+
+/**
+ * @struct FrameLayout
+ * @brief Sizes of the game screen areas, as given to GameRenderer.
+ */
+struct FrameLayout
+{
+    Size view;               ///< Map view size in cells
+    Size side;               ///< Height of the bottom panels and width of the side panels
+    std::vector<int> fields; ///< Heights of the general, selected, tech and super weapon panels
+
+    bool operator==(const FrameLayout &l) const { return view == l.view && side == l.side && fields == l.fields; };
+};
+
+/**
+ * @struct FrameCell
+ * @brief Glyph and colour pair of one map cell.
+ */
+struct FrameCell
+{
+    uint32_t glyph; ///< Unicode code point, 0 for a blank frame
+    uint8_t color;  ///< Colour pair number
+
+    bool operator==(const FrameCell &c) const { return glyph == c.glyph && color == c.color; };
+    bool operator!=(const FrameCell &c) const { return !(*this == c); };
+};
+
+/**
+ * @enum SpanAlign
+ * @brief Where a text span is printed on its panel line.
+ */
+enum class SpanAlign : uint8_t
+{
+    FILL = 0,  ///< Whole line of spaces, the text is ignored
+    LEFT = 1,  ///< Left-aligned text
+    RIGHT = 2  ///< Right-aligned text
+};
+
+/**
+ * @struct FrameSpan
+ * @brief Text printed on a panel line with one attribute.
+ */
+struct FrameSpan
+{
+    SpanAlign align;
+    uint32_t attr;
+    std::string text;
+
+    bool operator==(const FrameSpan &s) const { return align == s.align && attr == s.attr && text == s.text; };
+};
+typedef std::vector<FrameSpan> FrameLine;
+
+/**
+ * @enum FramePanel
+ * @brief Text panels of the game screen, in layout order.
+ */
+enum FramePanel
+{
+    PANEL_GENERAL = 0,
+    PANEL_SELECTED = 1,
+    PANEL_TECH = 2,
+    PANEL_SUPER_WEAPON = 3,
+    PANEL_OPERATION = 4,
+    PANEL_FEEDBACK = 5,
+    PANEL_COUNT = 6
+};
+
+/**
+ * @class Frame
+ * @brief Snapshot of the game screen with delta encoding against a previous snapshot.
+ */
+class Frame
+{
+private:
+    FrameLayout layout;
+    std::vector<FrameCell> map;                 ///< View cells, row-major
+    std::vector<std::vector<FrameLine>> panels; ///< Lines of each FramePanel
+
+    void print(int panel, int line, SpanAlign align, const std::string &s, attr_t attr);
+    void print_spaces(int panel, int line, attr_t attr = A_NORMAL) { print(panel, line, SpanAlign::FILL, "", attr); };
+    void print_left(int panel, int line, const std::string &s, attr_t attr = A_NORMAL) { print(panel, line, SpanAlign::LEFT, s, attr); };
+    void print_right(int panel, int line, const std::string &s, attr_t attr = A_NORMAL) { print(panel, line, SpanAlign::RIGHT, s, attr); };
+    static void encode_body(const Frame &prev, const Frame &next, std::string &out);
+
+public:
+    Frame(void) {};
+    Frame(const FrameLayout &l) { reset(l); };
+
+    void reset(const FrameLayout &l); ///< Blank frame of a layout
+    const FrameLayout &get_layout(void) const { return layout; };
+    const FrameCell &get_cell(Position p) const { return map[p.y * layout.view.w + p.x]; };
+    void set_cell(Position p, uint32_t glyph, uint8_t color);
+    const FrameLine &get_line(int panel, int line) const { return panels.at(panel).at(line); };
+    FrameLine &edit_line(int panel, int line) { return panels.at(panel).at(line); };
+    int get_lines(int panel) const { return panels.at(panel).size(); };
+
+    void capture(Game &game, OperationMenu &menu, double blend = 1); ///< Record the current game screen, defined in render.cpp
+
+    /// @name Delta Encoding
+    /// @{
+    static std::string encode_keyframe(const Frame &next);
+    static std::string encode_delta(const Frame &prev, const Frame &next);
+    static bool is_empty_delta(const std::string &bytes); ///< Whether a delta changes nothing, so need not be sent
+    void apply(const std::string &bytes); ///< Apply an encoded keyframe or delta
+    /// @}
+
+    static std::string to_utf8(uint32_t glyph);
+};
+
+/**
+ * @enum MessageType
+ * @brief Kind of a length-prefixed message exchanged between server and client.
+ */
+enum class MessageType : uint8_t
+{
+    HELLO = 1, ///< Client to server: difficulty level (u8)
+    KEY = 2,   ///< Client to server: key code (i32)
+    FRAME = 3, ///< Server to client: encoded keyframe or delta
+    END = 4,   ///< Server to client: score, turn and casualty (i32 each)
+    START = 5, ///< Co-op host to guest: difficulty level (u8) and game seed (u64)
+    TURN = 6   ///< Co-op peer to peer: turn (u32), state hash (u64) and the orders of the turn
+};
+
+/**
+ * @class Message
+ * @brief Framing of messages on a byte stream: a u32 length, a type byte, then the payload.
+ * Every integer is little-endian.
+ */
+class Message
+{
+public:
+    static const uint32_t MAX_LENGTH = 1 << 24; ///< Larger lengths mean a corrupt stream
+
+    static std::string pack(MessageType type, const std::string &payload);
+    static bool unpack(std::string &buffer, MessageType &type, std::string &payload);
+
+    static void put_u8(std::string &out, uint8_t value) { out.push_back(char(value)); };
+    static void put_u16(std::string &out, uint16_t value);
+    static void put_u32(std::string &out, uint32_t value);
+    static uint32_t get_u32(const std::string &in, size_t offset);
+};
+
+#endif
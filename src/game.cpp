@@ -14,6 +14,7 @@
  * - AttackMissile: A subclass of Missile targeting cities.
  * - CruiseMissile: A subclass of Missile targeting other missiles.
  * - MissileManager: Manages all missiles in the game, including creation, movement, and removal.
+ * - ThreatMap: Sums the damage of the attack missiles in flight over blocks of the map.
  * - City: Represents a city with position, hitpoints, productivity, and missile storage.
  * - TechTree: Manages the research and progression of technologies.
  * - Game: Represents the overall game state and logic, including turn progression,
@@ -37,6 +38,10 @@
 #include <sstream>
 #include <iomanip>
 #include <stdexcept>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <unistd.h>
 #include "game.h"
 #include "saver.h"
 
@@ -51,10 +56,22 @@
  * @param tp Type of the missile (Attack or Cruise).
  */
 Missile::Missile(int i, Position p, Position t, int d, int v, MissileType tp)
-    : id(i), position(p), target(t), is_exploded(false), damage(d), speed(v), type(tp)
+    : id(i), position(p), prev_position(p), target(t), is_exploded(false), damage(d), speed(v), type(tp)
 {
 }
 
+/**
+ * @brief Interpolates between the position before the last move and the current one.
+ *
+ * @param blend Fraction of the last move travelled, from 0 to 1.
+ * @return Position The nearest map cell to that point.
+ */
+Position Missile::get_position(double blend) const
+{
+    return Position(prev_position.y + int(std::lround((position.y - prev_position.y) * blend)),
+                    prev_position.x + int(std::lround((position.x - prev_position.x) * blend)));
+}
+
 /**
  * @brief Determines the direction of the missile based on its current position and target position.
  *
@@ -119,6 +136,7 @@ MissileDirection Missile::get_direction(void)
  */
 void Missile::move(void)
 {
+    prev_position = position;
     for (int step = 0; step < speed; step++)
     {
         move_step();
@@ -186,6 +204,67 @@ AttackMissile::AttackMissile(int i, Position p, City &c, int d, int v)
 {
 }
 
+/**
+ * @brief Determines the direction of the attack missile.
+ * Inside the map a routed missile follows the flow field of its city; outside the map,
+ * or without a route, it flies straight like any other missile.
+ *
+ * @return MissileDirection: The direction of the next step.
+ */
+MissileDirection AttackMissile::get_direction(void)
+{
+    if (route == nullptr || !route->is_in_field(position) || !(route->get_target() == target))
+    {
+        return Missile::get_direction();
+    }
+    uint8_t step = route->get_next(position);
+    if (step == FlowField::STAY)
+    {
+        return MissileDirection::A;
+    }
+    return MissileDirection(step + 1); // STEPS share the order of MissileDirection N..NW
+}
+
+/**
+ * @brief Predicts where the attack missile will be after a number of further steps.
+ * Straight flight (diagonal until aligned with the city, then straight) is solved in
+ * closed form; routed flight walks the flow field, which is O(1) per step.
+ *
+ * @param from A position on the missile's path.
+ * @param steps Number of steps taken from `from`.
+ * @return Position: The predicted position, clamped at the target city.
+ */
+Position AttackMissile::predict_position(Position from, int steps) const
+{
+    if (route == nullptr || !(route->get_target() == target))
+    {
+        int dy = target.y - from.y;
+        int dx = target.x - from.x;
+        int sy = (dy > 0) - (dy < 0);
+        int sx = (dx > 0) - (dx < 0);
+        int diagonal = std::min(abs(dy), abs(dx));
+        if (steps <= diagonal)
+        {
+            return from + Position(sy * steps, sx * steps);
+        }
+        int straight = std::min(steps, std::max(abs(dy), abs(dx))) - diagonal;
+        return abs(dy) > abs(dx) ? Position(target.y - sy * (abs(dy) - diagonal - straight), target.x)
+                                 : Position(target.y, target.x - sx * (abs(dx) - diagonal - straight));
+    }
+    for (int step = 0; step < steps && !(from == target); step++)
+    {
+        if (route->is_in_field(from))
+        {
+            from = from + FlowField::STEPS[route->get_next(from)];
+        }
+        else // Straight flight until the missile enters the map
+        {
+            from = from + Position((target.y > from.y) - (target.y < from.y), (target.x > from.x) - (target.x < from.x));
+        }
+    }
+    return from;
+}
+
 /**
  * @brief Moves the attack missile one step.
  *
@@ -211,27 +290,341 @@ CruiseMissile::CruiseMissile(int i, Position p, Missile &m, int d, int v, int t_
     target_id = t_id;
 }
 
+/**
+ * @brief Re-solves the intercept point and moves the cruise missile for one turn.
+ * Solving every turn keeps the point valid if the target missile deviates from its
+ * predicted path; when no intercept is possible the missile falls back to pursuit.
+ *
+ */
+void CruiseMissile::move(void)
+{
+    const AttackMissile *attack_missile = dynamic_cast<const AttackMissile *>(&missile);
+    has_intercept = attack_missile != nullptr && solve_intercept(position, speed, *attack_missile, intercept);
+    Missile::move();
+}
+
 /**
  * @brief Moves the cruise missile one step.
+ * The missile flies straight at its intercept point and holds there until the target
+ * missile arrives; without an intercept point it chases the target's current position.
  *
  */
 void CruiseMissile::move_step(void)
 {
-    target = missile.get_position(); // Update target position
+    target = has_intercept ? intercept : missile.get_position(); // Update target position
+    if (position == missile.get_position()) // Target missile flew into the holding point
+    {
+        missile.set_is_exploded(); // Explode the target missile
+        set_is_exploded();         // Explode the cruise missile
+        return;
+    }
+    if (position == target) // Hold at the intercept point
+    {
+        return;
+    }
     Missile::move_step();
-    if (get_direction() == MissileDirection::A) // Check if cruise missile reached target
+    if (position == missile.get_position()) // Check if cruise missile reached target
     {
         missile.set_is_exploded(); // Explode the target missile
         set_is_exploded();         // Explode the cruise missile
     }
 }
 
+/**
+ * @brief Finds the earliest point where a cruise missile can meet an attack missile.
+ *
+ * Missiles move a whole turn at a time, attack missiles first, so the cruise missile
+ * can meet the target at the end of turn k if the target's predicted position after
+ * k turns lies within k * v steps of the launch point (Chebyshev distance, as
+ * diagonal steps are allowed). Turns are scanned until the target reaches its city.
+ *
+ * @param launch Current position of the cruise missile.
+ * @param v Speed of the cruise missile.
+ * @param m Target attack missile.
+ * @param point Receives the intercept point when one exists.
+ * @return true If the target can be intercepted before it hits its city.
+ */
+bool CruiseMissile::solve_intercept(Position launch, int v, const AttackMissile &m, Position &point)
+{
+    if (m.speed <= 0 || v <= 0)
+    {
+        return false;
+    }
+    Position predicted = m.get_position();
+    for (int turn = 1;; turn++)
+    {
+        predicted = m.predict_position(predicted, m.speed);
+        if (predicted == m.target) // Too late, the city is hit during this turn
+        {
+            return false;
+        }
+        if (std::max(abs(predicted.y - launch.y), abs(predicted.x - launch.x)) <= turn * v)
+        {
+            point = predicted;
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Builds the alias table from a list of weights using Vose's method.
+ *
+ * Columns are split into "small" (scaled probability below 1) and "large" ones; each small
+ * column is topped up by a large column which becomes its alias. Runs in O(n).
+ *
+ * @param weights Weight of each outcome. Negative weights are treated as zero.
+ */
+void AliasTable::build(const std::vector<int> &weights)
+{
+    int n = weights.size();
+    probability.assign(n, 1.0);
+    alias.assign(n, 0);
+    if (n == 0)
+    {
+        return;
+    }
+
+    long long total = 0;
+    for (int weight : weights)
+    {
+        total += std::max(weight, 0);
+    }
+    if (total == 0) // No usable weight, fall back to uniform sampling
+    {
+        for (int index = 0; index < n; index++)
+        {
+            alias.at(index) = index;
+        }
+        return;
+    }
+
+    std::vector<double> scaled(n);
+    std::vector<int> small;
+    std::vector<int> large;
+    for (int index = 0; index < n; index++)
+    {
+        scaled.at(index) = static_cast<double>(std::max(weights.at(index), 0)) * n / total;
+        if (scaled.at(index) < 1.0)
+        {
+            small.push_back(index);
+        }
+        else
+        {
+            large.push_back(index);
+        }
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        int less = small.back();
+        int more = large.back();
+        small.pop_back();
+        probability.at(less) = scaled.at(less);
+        alias.at(less) = more;
+        scaled.at(more) -= 1.0 - scaled.at(less); // Donate the missing mass to the small column
+        if (scaled.at(more) < 1.0)
+        {
+            large.pop_back();
+            small.push_back(more);
+        }
+    }
+    // NOTE: leftovers are 1.0 up to rounding error
+    for (int index : large)
+    {
+        probability.at(index) = 1.0;
+        alias.at(index) = index;
+    }
+    for (int index : small)
+    {
+        probability.at(index) = 1.0;
+        alias.at(index) = index;
+    }
+}
+
+/**
+ * @brief Draws one outcome from the table in O(1).
+ *
+ * @param rng Random stream to draw from.
+ * @return int: Index of the sampled outcome, or 0 if the table is empty.
+ */
+int AliasTable::sample(CounterRandom &rng) const
+{
+    if (probability.empty())
+    {
+        return 0;
+    }
+    int column = rng.uniform(0, probability.size() - 1);
+    return rng.uniform_real() < probability[column] ? column : alias[column];
+}
+
+/**
+ * @brief Finds the block of a cell.
+ *
+ * @param p Cell of the map.
+ * @return int: Index of its block in `damage`, -1 outside the map.
+ */
+int ThreatMap::get_index(Position p) const
+{
+    if (p.y < 0 || p.y >= size.h || p.x < 0 || p.x >= size.w)
+    {
+        return -1;
+    }
+    return (p.y / BLOCK_H) * blocks.w + p.x / BLOCK_W;
+}
+
+/**
+ * @brief Forgets every missile and covers a map of a new size.
+ *
+ * @param s Size of the map.
+ */
+void ThreatMap::reset(Size s)
+{
+    size = s;
+    blocks = Size((s.h + BLOCK_H - 1) / BLOCK_H, (s.w + BLOCK_W - 1) / BLOCK_W);
+    damage.assign(std::max(0, blocks.h * blocks.w), 0);
+}
+
+/**
+ * @brief Adds the damage of a missile to its block, or removes it with a negative damage.
+ *
+ * @param p Position of the missile.
+ * @param d Damage of the missile.
+ */
+void ThreatMap::add(Position p, int d)
+{
+    int index = get_index(p);
+    if (index >= 0)
+    {
+        damage[index] += d;
+    }
+}
+
+/**
+ * @brief Moves the damage of a missile from one cell to another. Nothing changes while
+ * the missile stays in the same block.
+ *
+ * @param from Position before the move.
+ * @param to Position after the move.
+ * @param d Damage of the missile.
+ */
+void ThreatMap::move(Position from, Position to, int d)
+{
+    int before = get_index(from);
+    int after = get_index(to);
+    if (before == after)
+    {
+        return;
+    }
+    if (before >= 0)
+    {
+        damage[before] -= d;
+    }
+    if (after >= 0)
+    {
+        damage[after] += d;
+    }
+}
+
+/**
+ * @brief Gets the damage heading through the block of a cell.
+ *
+ * @param p Cell of the map.
+ * @return int: Summed damage of the attack missiles in the block, 0 outside the map.
+ */
+int ThreatMap::get(Position p) const
+{
+    int index = get_index(p);
+    return index >= 0 ? damage[index] : 0;
+}
+
 /**
  * @brief Constructor for the MissileManager class.
  *
  * @param cts Vector of cities in the game.
+ * @param t Terrain the missiles fly over.
+ */
+MissileManager::MissileManager(std::vector<City> &cts, const Terrain &t)
+    : id(0), cities(cts), terrain(t), waves(WaveTable::get_default_rules()), seed(0) {}
+
+/**
+ * @brief Gets the route shared by every attack missile aimed at a city.
+ * Routes are usually built ahead by the wave worker; one it did not guess is built here.
+ * Missiles fly straight when routing is off or the terrain cannot be routed.
+ *
+ * @param c The targeted city.
+ * @return std::shared_ptr<const FlowField>: The route, or null when missiles fly straight.
  */
-MissileManager::MissileManager(std::vector<City> &cts) : id(0), cities(cts) {}
+std::shared_ptr<const FlowField> MissileManager::get_flow_field(const City &c)
+{
+    if (!is_routed() || !terrain.is_in_map(c.get_position()))
+    {
+        return nullptr;
+    }
+    auto cached = flow_fields.find(c.get_position().y * terrain.get_size().w + c.get_position().x);
+    if (cached != flow_fields.end())
+    {
+        cached->second.used = ++route_clock;
+        return cached->second.field;
+    }
+    std::shared_ptr<const FlowField> field = std::make_shared<const FlowField>(terrain, c.get_position(), routing);
+    cache_flow_field(field);
+    return field;
+}
+
+/**
+ * @brief Caches a route, evicting the least recently used ones beyond MAX_ROUTE_BYTES.
+ * Missiles keep their own reference, so evicting a route never changes their flight.
+ *
+ * @param field The route to cache.
+ */
+void MissileManager::cache_flow_field(const std::shared_ptr<const FlowField> &field)
+{
+    int key = field->get_target().y * terrain.get_size().w + field->get_target().x;
+    CachedRoute &cached = flow_fields[key];
+    if (cached.field != nullptr)
+    {
+        route_bytes -= cached.field->get_bytes();
+    }
+    cached.field = field;
+    cached.used = ++route_clock;
+    route_bytes += field->get_bytes();
+    while (route_bytes > MAX_ROUTE_BYTES && flow_fields.size() > 1)
+    {
+        auto oldest = flow_fields.begin();
+        for (auto entry = flow_fields.begin(); entry != flow_fields.end(); ++entry)
+        {
+            if (entry->second.used < oldest->second.used)
+            {
+                oldest = entry;
+            }
+        }
+        route_bytes -= oldest->second.field->get_bytes();
+        flow_fields.erase(oldest);
+    }
+}
+
+/**
+ * @brief Drops every cached route.
+ *
+ */
+void MissileManager::clear_flow_fields(void)
+{
+    flow_fields.clear();
+    route_bytes = 0;
+}
+
+/**
+ * @brief Sets how attack missiles cross the terrain and drops the cached routes, and
+ * the routes a pending wave plan is building.
+ *
+ * @param mode The new routing mode.
+ */
+void MissileManager::set_routing(RoutingMode mode)
+{
+    cancel_attack_wave();
+    routing = mode;
+    clear_flow_fields();
+}
 
 /**
  * @brief Gets all missiles managed by the manager.
@@ -289,8 +682,10 @@ std::vector<Missile *> MissileManager::get_cruise_missiles(void)
  */
 void MissileManager::create_attack_missile(Position p, City &c, int d, int v)
 {
-    Missile *missile = new AttackMissile(id++, p, c, d, v);
+    AttackMissile *missile = new AttackMissile(id++, p, c, d, v);
+    missile->route = get_flow_field(c);
     missiles.push_back(missile);
+    threat_map.add(p, d);
 }
 
 /**
@@ -301,208 +696,649 @@ void MissileManager::create_attack_missile(Position p, City &c, int d, int v)
  * @param v The velocity of the cruise missile.
  *
  * @return true If a cruise missile is successfully created and assigned to a target.
- * @return false If no suitable target is found or the target is out of the defense radius.
+ * @return false If no attack missile in the defense radius can be intercepted before it hits.
  *
  */
 bool MissileManager::create_cruise_missile(City &c, int d, int v)
 {
-    int target_distance = inf; // Initialize target distance to infinity
-    Missile *target_missile = nullptr;
+    std::vector<std::pair<int, AttackMissile *>> candidates; // Unaimed attack missiles in range, by distance
     for (auto attack_missile : get_attack_missiles())
     {
-        AttackMissile *attack_missile_ptr = dynamic_cast<AttackMissile *>(attack_missile);                                                      // Cast to AttackMissile pointer
-        int distance = abs(attack_missile->get_position().y - c.get_position().y) + abs(attack_missile->get_position().x - c.get_position().x); // Calculate distance to city
-        if (distance < target_distance && attack_missile_ptr->is_aimed == false)                                                                // Check if closer and not already aimed
-        {
-            target_distance = distance;
-            target_missile = attack_missile;
-        }
+        AttackMissile *attack_missile_ptr = dynamic_cast<AttackMissile *>(attack_missile);                                                      // Cast to AttackMissile pointer
+        int distance = abs(attack_missile->get_position().y - c.get_position().y) + abs(attack_missile->get_position().x - c.get_position().x); // Calculate distance to city
+        if (distance <= 15 && attack_missile_ptr->is_aimed == false)                                                                            // Check if in range and not already aimed
+        {
+            candidates.push_back(std::make_pair(distance, attack_missile_ptr));
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(), [](const std::pair<int, AttackMissile *> &a, const std::pair<int, AttackMissile *> &b)
+                     { return a.first < b.first; });
+    for (auto &candidate : candidates)
+    {
+        AttackMissile *target_missile = candidate.second;
+        Position intercept;
+        if (!CruiseMissile::solve_intercept(c.get_position(), v, *target_missile, intercept)) // Reject impossible intercepts up front
+        {
+            continue;
+        }
+        target_missile->is_aimed = true;
+        Missile *missile = new CruiseMissile(id++, c.get_position(), *target_missile, d, v, target_missile->id); // Create a new cruise missile
+        missiles.push_back(missile);
+        return true; // Cruise missile created
+    }
+    return false; // No cruise missile created
+}
+
+/**
+ * @brief Updates the positions of all missiles.
+ *
+ */
+void MissileManager::update_missiles(void)
+{
+    for (auto attack_missile : get_attack_missiles())
+    {
+        attack_missile->move();
+        threat_map.move(attack_missile->prev_position, attack_missile->position, attack_missile->damage);
+    }
+
+    for (auto cruise_missile : get_cruise_missiles())
+    {
+        cruise_missile->move();
+    }
+}
+
+/**
+ * @brief Removes exploded missiles from the game.
+ *
+ */
+void MissileManager::remove_missiles(void)
+{
+    for (auto attack_missile : get_attack_missiles())
+    {
+        if (attack_missile->get_is_exploded())
+        {
+            for (auto &missile : get_cruise_missiles())
+            {
+                CruiseMissile *cruise_missile = dynamic_cast<CruiseMissile *>(missile); // Cast to CruiseMissile pointer
+                if (cruise_missile->target_id == attack_missile->id)                    // Check if the cruise missile is targeting the exploded attack missile
+                {
+                    auto iter = std::find(missiles.begin(), missiles.end(), cruise_missile); // Find the cruise missile in the vector
+                    if (iter != missiles.end())                                              // Check if the cruise missile was found
+                    {
+                        missiles.erase(iter);
+                    }
+                    delete cruise_missile;
+                }
+            }
+            auto iter = std::find(missiles.begin(), missiles.end(), attack_missile); // Find the attack missile in the vector
+            if (iter != missiles.end())                                              // Check if the attack missile was found
+            {
+                missiles.erase(iter);
+            }
+            threat_map.add(attack_missile->position, -attack_missile->damage);
+            delete attack_missile;
+        }
+    }
+}
+
+/**
+ * @brief Generates a random number based on the interval given.
+ *
+ * @param rng The random stream to draw from.
+ * @param min The minimum value for the random number. (inclusive)
+ * @param max The maximum value for the random number. (inclusive)
+ * @return int: A random number.
+ */
+int MissileManager::generate_random(CounterRandom &rng, int min, int max)
+{
+    return rng.uniform(min, max);
+}
+
+/**
+ * @brief Generates a random number based on the interval given, with a bias towards a specific value.
+ *
+ * @param rng The random stream to draw from.
+ * @param min The minimum value for the random number. (inclusive)
+ * @param max The maximum value for the random number. (inclusive)
+ * @param biased The biased value to return if the random number is equal to max + 1.
+ * @return int: A random number.
+ */
+int MissileManager::generate_random_biased(CounterRandom &rng, int min, int max, int biased)
+{
+    int ret = generate_random(rng, min, max + 1);
+    if (ret == max + 1)
+    {
+        return biased;
+    }
+    return ret;
+}
+
+/**
+ * @brief Computes the number of missiles in a wave.
+ *
+ * @param turn the turn of the wave.
+ * @return int: Missile count.
+ */
+int WaveRule::get_count(int turn) const
+{
+    return count_base + (count_turns > 0 ? turn / count_turns : 0);
+}
+
+/**
+ * @brief Computes the speed/damage bias of a wave.
+ *
+ * @param turn the turn of the wave.
+ * @param hitpoint the current enemy hitpoint.
+ * @return int: Index favoured when drawing speeds and damages.
+ */
+int WaveRule::get_bias(int turn, int hitpoint) const
+{
+    int top = std::min(speeds.size(), damages.size()) - 1;
+    int hitpoint_factor = hitpoint_step > 0 ? std::min(top, hitpoint / hitpoint_step) : 0; // Calculate the hitpoint factor
+    int turn_factor = turn_step > 0 ? std::min(top, turn / turn_step) : 0;                   // Calculate the turn factor
+    return std::max(0, (hitpoint_factor + turn_factor) / 2);
+}
+
+/**
+ * @brief Weighs the cities a wave can target.
+ *
+ * @param hitpoints Hitpoints of each city.
+ * @return std::vector<int>: Weight of each city, zero for destroyed ones.
+ */
+std::vector<int> WaveRule::get_target_weights(const std::vector<int> &hitpoints) const
+{
+    std::vector<int> weights;
+    weights.reserve(hitpoints.size());
+    for (int hitpoint : hitpoints)
+    {
+        if (target == WaveTarget::UNIFORM)
+        {
+            weights.push_back(hitpoint > 0 ? 1 : 0);
+        }
+        else
+        {
+            weights.push_back(hitpoint);
+        }
+    }
+    return weights;
+}
+
+/**
+ * @brief Gets the built-in wave rules, used when there is no "waves.txt".
+ * A wave every 20 turns from turn 20, growing by one missile every 50, 30 or 20 turns.
+ *
+ * @return std::vector<WaveRule>: One open-ended rule per difficulty level.
+ */
+std::vector<WaveRule> WaveTable::get_default_rules(void)
+{
+    std::vector<WaveRule> defaults(3);
+    defaults[0].speeds = {1, 1, 1, 2, 2};
+    defaults[0].damages = {100, 100, 100, 150, 200};
+    defaults[0].count_turns = 50;
+    defaults[1].speeds = {1, 1, 2, 2, 3};
+    defaults[1].damages = {100, 100, 200, 200, 200};
+    defaults[1].count_turns = 30;
+    defaults[2].speeds = {1, 2, 2, 3, 3};
+    defaults[2].damages = {150, 150, 200, 200, 300};
+    defaults[2].count_turns = 20;
+    for (int index = 0; index < 3; index++)
+    {
+        WaveRule &rule = defaults[index];
+        rule.level = index + 1;
+        rule.start = 20;
+        rule.end = -1;
+        rule.interval = 20;
+        rule.count_base = 5;
+        rule.hitpoint_step = 200;
+        rule.turn_step = 100;
+        rule.target = WaveTarget::HITPOINT;
+        rule.edges = "LRTB";
+    }
+    return defaults;
+}
+
+/**
+ * @brief Validates wave rules and compiles them into the turn lookup.
+ *
+ * @param rs Wave rules, earlier rules taking precedence over later ones.
+ * @throws std::runtime_error If a rule is malformed, or its level or turns are out of bounds.
+ */
+void WaveTable::compile(const std::vector<WaveRule> &rs)
+{
+    int levels = 0;
+    for (auto &rule : rs)
+    {
+        if (rule.level < 1 || rule.level > MAX_LEVEL || rule.start < 0 || rule.start > MAX_TURN || rule.end > MAX_TURN || (rule.end >= 0 && rule.end < rule.start) || (rule.end < 0 && rule.end != -1) ||
+            rule.interval <= 0 || rule.count_base < 0 || rule.count_turns < 0 || rule.hitpoint_step < 0 || rule.turn_step < 0 ||
+            rule.speeds.empty() || rule.damages.empty() || rule.edges.empty() ||
+            rule.edges.find_first_not_of("LRTB") != std::string::npos)
+        {
+            throw std::runtime_error("Invalid wave rule for level " + std::to_string(rule.level) + " from turn " + std::to_string(rule.start));
+        }
+        levels = std::max(levels, rule.level);
+    }
+
+    rules = rs;
+    lookup.assign(levels, std::vector<int>());
+    tail.assign(levels, -1);
+    for (int level = 1; level <= levels; level++)
+    {
+        int length = 0; // NOTE: past every closed range and every start, only the tail rule can apply
+        for (int index = 0; index < int(rules.size()); index++)
+        {
+            const WaveRule &rule = rules[index];
+            if (rule.level != level)
+            {
+                continue;
+            }
+            length = std::max(length, rule.end < 0 ? rule.start : rule.end + 1);
+            if (rule.end < 0 && tail[level - 1] == -1)
+            {
+                tail[level - 1] = index;
+            }
+        }
+
+        std::vector<int> &turns = lookup[level - 1];
+        turns.assign(length, -1);
+        for (int turn = 0; turn < length; turn++)
+        {
+            for (int index = 0; index < int(rules.size()); index++)
+            {
+                const WaveRule &rule = rules[index];
+                if (rule.level == level && rule.is_in_range(turn)) // The first rule covering the turn governs it
+                {
+                    if ((turn - rule.start) % rule.interval == 0)
+                    {
+                        turns[turn] = index;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Looks up the rule launching a wave on a turn.
+ *
+ * @param level Difficulty level of the game.
+ * @param turn Turn to check.
+ * @return const WaveRule *: The rule, or null if no wave is launched on that turn.
+ */
+const WaveRule *WaveTable::get_wave(int level, int turn) const
+{
+    if (level < 1 || level > int(lookup.size()) || turn < 0)
+    {
+        return nullptr;
+    }
+    const std::vector<int> &turns = lookup[level - 1];
+    if (turn < int(turns.size()))
+    {
+        return turns[turn] < 0 ? nullptr : &rules[turns[turn]];
+    }
+    int index = tail[level - 1];
+    if (index < 0 || (turn - rules[index].start) % rules[index].interval != 0)
+    {
+        return nullptr;
+    }
+    return &rules[index];
+}
+
+/**
+ * @brief Finds the first wave at or after a turn.
+ * Past the lookup only the tail rule applies, so at most one of its intervals is scanned.
+ *
+ * @param level Difficulty level of the game.
+ * @param turn First turn to consider.
+ * @return int: Turn of the next wave, -1 if there is none.
+ */
+int WaveTable::get_next_wave(int level, int turn) const
+{
+    if (level < 1 || level > int(lookup.size()))
+    {
+        return -1;
+    }
+    int index = tail[level - 1];
+    int limit = std::max<int>(std::max(turn, 0), lookup[level - 1].size()) + (index < 0 ? 0 : rules[index].interval);
+    for (int next = std::max(turn, 0); next <= limit; next++)
+    {
+        if (get_wave(level, next) != nullptr)
+        {
+            return next;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Plans the missiles of an attack wave, except their targets.
+ * Only touches its arguments, so it can safely run on a worker thread.
+ *
+ * @param plan Wave turn and bias; receives the spawns.
+ * @param rule Wave rule governing the turn.
+ * @param size Map size.
+ * @param seed Seed of the game's random streams.
+ * @return WavePlan: The completed plan.
+ */
+WavePlan MissileManager::plan_attack_wave(WavePlan plan, WaveRule rule, Size size, uint64_t seed)
+{
+    int count = rule.get_count(plan.turn); // Calculate the number of missiles
+    plan.spawns.reserve(count);
+    for (int index = 0; index < count; index++)
+    {
+        CounterRandom rng(seed, plan.turn, index, RandomPurpose::WAVE_SPAWN); // One stream per missile
+        WaveSpawn spawn;
+        spawn.speed = rule.speeds.at(generate_random_biased(rng, 0, rule.speeds.size() - 1, plan.bias));
+        spawn.damage = rule.damages.at(generate_random_biased(rng, 0, rule.damages.size() - 1, plan.bias));
+
+        // START POSITION
+        char edge = rule.edges[generate_random(rng, 0, rule.edges.size() - 1)]; // Randomly select an edge
+        switch (edge)                                                          // Determine start position based on edge
+        {
+        case 'L':
+            spawn.position = Position(generate_random(rng, 0, size.h), 0); // Left edge
+            break;
+        case 'R':
+            spawn.position = Position(generate_random(rng, 0, size.h), size.w + 1); // Right edge
+            break;
+        case 'T':
+            spawn.position = Position(0, generate_random(rng, 0, size.w)); // Top edge
+            break;
+        case 'B':
+            spawn.position = Position(size.h + 1, generate_random(rng, 0, size.w)); // Bottom edge
+            break;
+        default:
+            spawn.position = Position(0, 0); // Default position
+            break;
+        }
+        plan.spawns.push_back(spawn);
+    }
+    return plan;
+}
+
+/**
+ * @brief Plans an attack wave, then builds the routes of its likely targets.
+ * The targets are drawn as create_attack_wave will draw them, but from the hitpoints of
+ * the planning turn, so a city hit in between may still need its route built on launch.
+ * Only touches its arguments; the terrain copy shares the flat grid of the game.
+ *
+ * @param plan Wave turn, bias and city snapshot; receives the spawns and routes.
+ * @param rule Wave rule governing the turn.
+ * @param size Map size.
+ * @param seed Seed of the game's random streams.
+ * @param terrain Terrain to route over, flat.
+ * @param mode Routing mode of the game.
+ * @return WavePlan: The completed plan.
+ */
+WavePlan MissileManager::plan_attack_wave_routes(WavePlan plan, WaveRule rule, Size size, uint64_t seed, Terrain terrain, RoutingMode mode)
+{
+    plan = plan_attack_wave(std::move(plan), rule, size, seed);
+    AliasTable city_table(rule.get_target_weights(plan.city_hitpoints));
+    if (city_table.empty())
+    {
+        return plan;
+    }
+    for (size_t index = 0; index < plan.spawns.size(); index++)
+    {
+        CounterRandom rng(seed, plan.turn, index, RandomPurpose::WAVE_TARGET);
+        Position target = plan.city_positions.at(city_table.sample(rng));
+        if (!terrain.is_in_map(target) || std::find(plan.cached.begin(), plan.cached.end(), target) != plan.cached.end())
+        {
+            continue;
+        }
+        plan.cached.push_back(target);
+        plan.routes.push_back(std::make_shared<const FlowField>(terrain, target, mode));
+    }
+    return plan;
+}
+
+/**
+ * @brief Starts planning the next attack wave on a worker thread.
+ * The worker gets a copy of every input and draws from counter-based streams keyed by
+ * the wave turn, so it shares no state with the game. The plan only depends on the wave
+ * turn and the enemy hitpoint bias; create_attack_wave plans again when the bias has
+ * changed since, and draws the targets itself, so the wave launched is the one a
+ * synchronous call would plan. Does nothing while a plan is already pending, or when
+ * threads are off: the wave is then planned on its turn.
+ *
+ * @param turn the first turn the wave may be launched on.
+ * @param hitpoint the current enemy hitpoint.
+ * @param difficulty_level the difficulty level of the game.
+ */
+void MissileManager::prepare_attack_wave(int turn, int hitpoint, int difficulty_level)
+{
+    if (!is_async || next_wave.valid())
+    {
+        return;
+    }
+    int wave_turn = waves.get_next_wave(difficulty_level, turn);
+    if (wave_turn < 0)
+    {
+        return;
     }
-    if (target_missile == nullptr || target_distance > 15) // Check if no target or too far
+    const WaveRule &rule = *waves.get_wave(difficulty_level, wave_turn);
+    WavePlan plan;
+    plan.turn = wave_turn;
+    plan.bias = rule.get_bias(wave_turn, hitpoint);
+    if (!is_routed())
     {
-        return false; // No cruise missile created
+        next_wave = std::async(std::launch::async, plan_attack_wave, std::move(plan), rule, size, seed);
+        return;
     }
-    AttackMissile *attack_missile_ptr = dynamic_cast<AttackMissile *>(target_missile); // Cast to AttackMissile pointer
-    attack_missile_ptr->is_aimed = true;
-    Missile *missile = new CruiseMissile(id++, c.get_position(), *target_missile, d, v, target_missile->id); // Create a new cruise missile
-    missiles.push_back(missile);
-    return true; // Cruise missile created
+    plan.city_hitpoints.reserve(cities.size());
+    plan.city_positions.reserve(cities.size());
+    for (auto &city : cities)
+    {
+        plan.city_hitpoints.push_back(city.hitpoint);
+        plan.city_positions.push_back(city.position);
+    }
+    for (auto &entry : flow_fields)
+    {
+        plan.cached.push_back(entry.second.field->get_target());
+    }
+    next_wave = std::async(std::launch::async, plan_attack_wave_routes, std::move(plan), rule, size, seed, terrain, routing);
 }
 
 /**
- * @brief Updates the positions of all missiles.
+ * @brief Waits for and discards any pending wave plan, e.g. before the game is reset.
  *
  */
-void MissileManager::update_missiles(void)
+void MissileManager::cancel_attack_wave(void)
 {
-    for (auto attack_missile : get_attack_missiles())
+    if (next_wave.valid())
     {
-        attack_missile->move();
+        next_wave.wait();
+        next_wave = std::future<WavePlan>();
     }
+}
 
-    for (auto cruise_missile : get_cruise_missiles())
+/**
+ * @brief Predicts the flight of a snapshot of attack missiles: the cells each one still
+ * crosses until its city, and the turn it hits it. The city is damaged on the turn the
+ * missile arrives, so one `n` steps away with speed `v` hits ceil(n / v) turns on; a
+ * missile already on its city has hit it and gets no impact turn.
+ *
+ * @param snapshot Copies of the attack missiles, owned by the worker.
+ * @param turn the turn the forecast is made on.
+ * @return Forecast: The merged paths, sorted and without duplicates, and the impact turns.
+ */
+Forecast MissileManager::plan_forecast(std::vector<AttackMissile> snapshot, int turn)
+{
+    Forecast result;
+    result.turn = turn;
+    for (const auto &missile : snapshot)
     {
-        cruise_missile->move();
+        if (missile.speed <= 0)
+        {
+            continue;
+        }
+        Position cell = missile.position;
+        int steps = 0;
+        while (!(cell == missile.target))
+        {
+            cell = missile.predict_position(cell, 1);
+            result.path.push_back(cell);
+            steps++;
+        }
+        if (steps > 0)
+        {
+            result.impact_turns[missile.id] = turn + (steps + missile.speed - 1) / missile.speed - 1;
+        }
     }
+    std::sort(result.path.begin(), result.path.end(),
+              [](const Position &a, const Position &b) { return a.y != b.y ? a.y < b.y : a.x < b.x; });
+    result.path.erase(std::unique(result.path.begin(), result.path.end()), result.path.end());
+    return result;
 }
 
 /**
- * @brief Removes exploded missiles from the game.
+ * @brief Starts forecasting the attack missiles on a worker thread, from a snapshot of
+ * their current positions, or forecasts them at once when threads are off. Does nothing
+ * while a forecast is already pending.
  *
+ * @param turn the turn the forecast is made on.
  */
-void MissileManager::remove_missiles(void)
+void MissileManager::prepare_forecast(int turn)
 {
-    for (auto attack_missile : get_attack_missiles())
+    if (next_forecast.valid())
     {
-        if (attack_missile->get_is_exploded())
+        return;
+    }
+    std::vector<AttackMissile> snapshot;
+    for (auto missile : missiles)
+    {
+        if (missile->type == MissileType::ATTACK && !missile->is_exploded)
         {
-            for (auto &missile : get_cruise_missiles())
-            {
-                CruiseMissile *cruise_missile = dynamic_cast<CruiseMissile *>(missile); // Cast to CruiseMissile pointer
-                if (cruise_missile->target_id == attack_missile->id)                    // Check if the cruise missile is targeting the exploded attack missile
-                {
-                    auto iter = std::find(missiles.begin(), missiles.end(), cruise_missile); // Find the cruise missile in the vector
-                    if (iter != missiles.end())                                              // Check if the cruise missile was found
-                    {
-                        missiles.erase(iter);
-                    }
-                    delete cruise_missile;
-                }
-            }
-            auto iter = std::find(missiles.begin(), missiles.end(), attack_missile); // Find the attack missile in the vector
-            if (iter != missiles.end())                                              // Check if the attack missile was found
-            {
-                missiles.erase(iter);
-            }
-            delete attack_missile;
+            snapshot.push_back(*static_cast<AttackMissile *>(missile));
         }
     }
+    if (!is_async)
+    {
+        forecast = plan_forecast(std::move(snapshot), turn);
+        return;
+    }
+    next_forecast = std::async(std::launch::async, plan_forecast, std::move(snapshot), turn);
 }
 
 /**
- * @brief Generates a random number based on the interval given.
+ * @brief Waits for and discards any pending forecast, and forgets the last one.
  *
- * @param min The minimum value for the random number. (inclusive)
- * @param max The maximum value for the random number. (inclusive)
- * @return int: A random number.
  */
-int MissileManager::generate_random(int min, int max)
+void MissileManager::cancel_forecast(void)
 {
-    std::random_device rd;
-    std::mt19937 mt(rd());                          // Create a Mersenne Twister engine
-    std::uniform_int_distribution<> dist(min, max); // Create a uniform distribution
-    return dist(mt);                                // Generate a random number
+    if (next_forecast.valid())
+    {
+        next_forecast.wait();
+        next_forecast = std::future<Forecast>();
+    }
+    forecast = Forecast();
 }
 
 /**
- * @brief Generates a random number based on the interval given, with a bias towards a specific value.
+ * @brief Gets the latest forecast without blocking: a finished worker is collected, and a
+ * forecast older than `turn` is made again. Until then, the older forecast is returned.
  *
- * @param min The minimum value for the random number. (inclusive)
- * @param max The maximum value for the random number. (inclusive)
- * @param biased The biased value to return if the random number is equal to max + 1.
- * @return int: A random number.
+ * @param turn the current turn.
+ * @return const Forecast&: The latest finished forecast, possibly empty.
  */
-int MissileManager::generate_random_biased(int min, int max, int biased)
+const Forecast &MissileManager::get_forecast(int turn)
 {
-    int ret = generate_random(min, max + 1);
-    if (ret == max + 1)
+    if (next_forecast.valid() && next_forecast.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
     {
-        return biased;
+        forecast = next_forecast.get();
     }
-    return ret;
+    if (forecast.turn < turn)
+    {
+        prepare_forecast(turn);
+    }
+    return forecast;
 }
 
 /**
- * @brief Generates a random number based on the weights given.
+ * @brief Chooses whether waves and forecasts are prepared on worker threads. A server
+ * already running each game on one of its own workers turns them off, and the work is
+ * then done on that worker when it is needed. Pending work is dropped.
  *
- * @param weights A vector of weights for each possible outcome.
- * @return int: A random number from 0 to weights.size(),  based on the weights.
+ * @param a Whether to start worker threads.
  */
-int MissileManager::generate_random_weighted(const std::vector<int> &weights)
+void MissileManager::set_async(bool a)
 {
-    std::random_device rd;
-    std::mt19937 mt(rd());                                             // Create a Mersenne Twister engine
-    std::discrete_distribution<> dist(weights.begin(), weights.end()); // Create a discrete distribution
-    return dist(mt);
+    cancel_attack_wave();
+    cancel_forecast();
+    is_async = a;
 }
 
 /**
- * @brief Sets the difficulty level for the missile manager by adjusting the speed and damage of missiles.
- *
- * @param lv Difficulty level (1-3).
+ * @brief Sets the key of every random stream, e.g. to share one game between peers.
+ * A wave already planned with the old key is discarded and planned again on its turn.
  *
+ * @param s New seed.
  */
-void MissileManager::set_difficulty(int lv)
+void MissileManager::set_seed(uint64_t s)
 {
-    switch (lv)
-    {
-    case 3:
-        speed_list = {1, 2, 2, 3, 3};
-        damage_list = {150, 150, 200, 200, 300};
-        break;
-    case 2:
-        speed_list = {1, 1, 2, 2, 3};
-        damage_list = {100, 100, 200, 200, 200};
-        break;
-
-    case 1:
-    default:
-
-        speed_list = {1, 1, 1, 2, 2};
-        damage_list = {100, 100, 100, 150, 200};
-        break;
-    }
+    cancel_attack_wave();
+    seed = s;
 }
 
 /**
- * @brief Creates a wave of attack missiles.
+ * @brief Creates the wave of attack missiles of a turn, if the wave rules launch one.
+ * The wave planned ahead by prepare_attack_wave is spliced in when it still matches the
+ * game state, otherwise it is planned on the spot. Targets are drawn now, from the city
+ * hitpoints of this turn, so a planned wave and a wave planned on the spot are the same.
  *
  * @param turn the current turn number.
  * @param hitpoint the current enemy hitpoint.
  * @param difficulty_level the difficulty level of the game.
+ * @return bool: Whether a wave was launched.
  */
-void MissileManager::create_attack_wave(int turn, int hitpoint, int difficulty_level)
+bool MissileManager::create_attack_wave(int turn, int hitpoint, int difficulty_level)
 {
-
-    int count = turn / inc_turn.at(difficulty_level - 1) + 5; // Calculate the number of missiles
-    int hitpoint_factor = std::min(4, hitpoint / 200);        // Calculate the hitpoint factor
-    int turn_factor = std::min(4, turn / 100);                // Calculate the turn factor
-    // Iterate through all cities and get their hitpoints
+    const WaveRule *rule = waves.get_wave(difficulty_level, turn);
+    if (rule == nullptr)
+    {
+        return false;
+    }
     std::vector<int> city_hitpoints;
+    city_hitpoints.reserve(cities.size());
     for (auto &city : cities)
     {
-        city_hitpoints.push_back(city.hitpoint); // Get the hitpoints of each city
+        city_hitpoints.push_back(city.hitpoint);
     }
-
-    for (int index = 0; index < count; index++)
+    AliasTable city_table(rule->get_target_weights(city_hitpoints)); // Built once per wave, O(1) per missile afterwards
+    if (city_table.empty())
     {
-        int speed = speed_list.at(generate_random_biased(0, 4, (hitpoint_factor + turn_factor) / 2));
-        int damage = damage_list.at(generate_random_biased(0, 4, (hitpoint_factor + turn_factor) / 2));
-        City &city = cities.at(generate_random_weighted(city_hitpoints)); // Select a city based on its hitpoints
+        cancel_attack_wave();
+        return false;
+    }
 
-        // START POSITION
-        Position position = {generate_random(0, size.h), generate_random(0, size.w)};
-        int edge = generate_random(0, 3); // Randomly select an edge
-        switch (edge)                     // Determine start position based on edge
+    WavePlan plan;
+    bool is_planned = false;
+    if (next_wave.valid())
+    {
+        plan = next_wave.get();
+        is_planned = plan.turn == turn && plan.bias == rule->get_bias(turn, hitpoint);
+        for (auto &route : plan.routes) // Routes only depend on their target, so keep them even for a stale plan
         {
-        case 0:
-            position = Position(generate_random(0, size.h), 0); // Left edge
-            break;
-        case 1:
-            position = Position(generate_random(0, size.h), size.w + 1); // Right edge
-            break;
-        case 2:
-            position = Position(0, generate_random(0, size.w)); // Top edge
-            break;
-        case 3:
-            position = Position(size.h + 1, generate_random(0, size.w)); // Bottom edge
-            break;
-        default:
-            position = Position(0, 0); // Default position
-            break;
+            cache_flow_field(route);
         }
-        create_attack_missile(position, city, damage, speed); // Create and add the attack missile
     }
+    if (!is_planned) // Plan synchronously, e.g. right after loading a game
+    {
+        plan = WavePlan();
+        plan.turn = turn;
+        plan.bias = rule->get_bias(turn, hitpoint);
+        plan = plan_attack_wave(std::move(plan), *rule, size, seed);
+    }
+
+    missiles.reserve(missiles.size() + plan.spawns.size());
+    for (size_t index = 0; index < plan.spawns.size(); index++)
+    {
+        const WaveSpawn &spawn = plan.spawns[index];
+        CounterRandom rng(seed, turn, index, RandomPurpose::WAVE_TARGET);
+        City &city = cities.at(city_table.sample(rng)); // Select a city based on the target weights
+        create_attack_missile(spawn.position, city, spawn.damage, spawn.speed); // Create and add the attack missile
+    }
+    return true;
 }
 
 /**
@@ -687,14 +1523,124 @@ void TechTree::update_available(int deposit)
     }
 }
 
-int Game::generate_random(int min, int max)
+/**
+ * @brief Draws a random number from the stream of this turn keyed by purpose and index.
+ * @param min The minimum value for the random number. (inclusive)
+ * @param max The maximum value for the random number. (inclusive)
+ * @param purpose What the number decides
+ * @param index Entity the number is drawn for, e.g. a city index
+ * @return int: A random number.
+ */
+int Game::generate_random(int min, int max, RandomPurpose purpose, int index)
+{
+    CounterRandom rng(missile_manager.get_seed(), turn, index, purpose);
+    return rng.uniform(min, max);
+}
+
+/**
+ * @brief Constructs empty series with room for a few hundred turns.
+ *
+ */
+TurnSeries::TurnSeries(void)
+    : length(0), capacity(256)
+{
+    for (int column = 0; column < SERIES_COUNT; column++)
+    {
+        values[column].reset(new int32_t[capacity]);
+        sums[column].reset(new int64_t[capacity + 1]);
+        sums[column][0] = 0;
+    }
+}
+
+/**
+ * @brief Doubles the capacity of every column, keeping the recorded turns.
+ *
+ */
+void TurnSeries::grow(void)
+{
+    size_t grown = capacity * 2;
+    for (int column = 0; column < SERIES_COUNT; column++)
+    {
+        std::unique_ptr<int32_t[]> new_values(new int32_t[grown]);
+        std::unique_ptr<int64_t[]> new_sums(new int64_t[grown + 1]);
+        std::copy(values[column].get(), values[column].get() + length, new_values.get());
+        std::copy(sums[column].get(), sums[column].get() + length + 1, new_sums.get());
+        values[column] = std::move(new_values);
+        sums[column] = std::move(new_sums);
+    }
+    capacity = grown;
+}
+
+/**
+ * @brief Records the statistics of one more turn.
+ *
+ * @param row Value of every column, indexed by SeriesColumn.
+ */
+void TurnSeries::append(const std::array<int32_t, SERIES_COUNT> &row)
+{
+    if (length == capacity)
+    {
+        grow();
+    }
+    for (int column = 0; column < SERIES_COUNT; column++)
+    {
+        values[column][length] = row[column];
+        sums[column][length + 1] = sums[column][length] + row[column];
+    }
+    length++;
+}
+
+/**
+ * @brief Computes the mean of a column over a range of turns from the running sums.
+ *
+ * @param column Series to average.
+ * @param first First turn of the range.
+ * @param last One past the last turn of the range.
+ * @return double: Mean, 0 for an empty range.
+ */
+double TurnSeries::get_mean(SeriesColumn column, size_t first, size_t last) const
+{
+    last = std::min(last, length);
+    if (first >= last)
+    {
+        return 0;
+    }
+    return double(sums[column][last] - sums[column][first]) / (last - first);
+}
+
+/**
+ * @brief Shrinks a column to at most `width` points for a chart. Each point is the mean of
+ * an equal share of the turns, taken from the running sums, so the cost does not grow
+ * with the length of the game.
+ *
+ * @param column Series to downsample.
+ * @param width Maximum number of points.
+ * @return std::vector<int32_t>: Points in turn order, the values themselves if they fit.
+ */
+std::vector<int32_t> TurnSeries::downsample(SeriesColumn column, int width) const
 {
-    std::random_device rd;
-    std::mt19937 mt(rd());                             // Create a Mersenne Twister engine
-    std::uniform_int_distribution<int> dist(min, max); // Create a uniform distributions
-    return dist(mt);                                   // Generate a random number
+    std::vector<int32_t> points;
+    if (width <= 0 || length == 0)
+    {
+        return points;
+    }
+    if (length <= size_t(width))
+    {
+        points.assign(values[column].get(), values[column].get() + length);
+        return points;
+    }
+    points.reserve(width);
+    for (int index = 0; index < width; index++)
+    {
+        size_t first = length * index / width;
+        size_t last = length * (index + 1) / width;
+        points.push_back(int32_t(get_mean(column, first, last)));
+    }
+    return points;
 }
 
+const int Game::MAX_TURNS_PER_SECOND;
+
 /**
  * @brief Sets the difficulty level for the game by adjusting the initial deposit and enemy hitpoint.
  *
@@ -702,7 +1648,6 @@ int Game::generate_random(int min, int max)
  */
 void Game::set_difficulty(int lv)
 {
-    missile_manager.set_difficulty(lv);
     switch (lv) // Determine difficulty based on input
     {
     case 1: // Easy difficulty
@@ -774,6 +1719,7 @@ void Game::move_cursor(Position dcursor)
     }
     cursor.y += dcursor.y; // Update the Y position of the cursor
     cursor.x += dcursor.x; // Update the X position of the cursor
+    follow_cursor();
 }
 
 /**
@@ -787,6 +1733,54 @@ void Game::move_cursor_to_city(int index)
         return;
     }
     cursor = cities.at(index).get_position();
+    follow_cursor();
+}
+
+/**
+ * @brief Resizes the visible part of the map. A view larger than the map, or an
+ *        empty one, shows the whole map.
+ * @param s Requested view size
+ */
+void Game::fit_view(Size s)
+{
+    view_size.h = (s.h <= 0 || s.h > size.h) ? size.h : s.h;
+    view_size.w = (s.w <= 0 || s.w > size.w) ? size.w : s.w;
+    follow_cursor();
+}
+
+/**
+ * @brief Shows or hides the threat heatmap.
+ */
+void Game::toggle_heatmap(void)
+{
+    is_heatmap_shown = !is_heatmap_shown;
+    insert_feedback(is_heatmap_shown ? "Threat Heatmap On" : "Threat Heatmap Off", COLOR_PAIR(4));
+}
+
+/**
+ * @brief Scrolls the view by the smallest amount that keeps the cursor visible,
+ *        without letting the view leave the map.
+ */
+void Game::follow_cursor(void)
+{
+    if (cursor.y < view_origin.y)
+    {
+        view_origin.y = cursor.y;
+    }
+    else if (cursor.y >= view_origin.y + view_size.h)
+    {
+        view_origin.y = cursor.y - view_size.h + 1;
+    }
+    if (cursor.x < view_origin.x)
+    {
+        view_origin.x = cursor.x;
+    }
+    else if (cursor.x >= view_origin.x + view_size.w)
+    {
+        view_origin.x = cursor.x - view_size.w + 1;
+    }
+    view_origin.y = std::max(0, std::min(view_origin.y, size.h - view_size.h));
+    view_origin.x = std::max(0, std::min(view_origin.x, size.w - view_size.w));
 }
 
 /**
@@ -795,8 +1789,30 @@ void Game::move_cursor_to_city(int index)
  */
 void Game::pass_turn(void)
 {
+    auto start = std::chrono::steady_clock::now();
+    auto lap = start;
+    auto count_attacks = [this](void)
+    {
+        return std::count_if(missile_manager.missiles.begin(), missile_manager.missiles.end(),
+                             [](const Missile *missile) { return missile->type == MissileType::ATTACK; });
+    };
+    int attacks = count_attacks(); // NOTE: includes missiles shot down since the last turn
+    int casualty_before = casualty;
+    int impacts = 0; // Hits on cities
+    int landed = 0;  // Missiles removed after hitting
+    auto time_phase = [this, &lap](TurnPhase phase)
+    {
+        auto now = std::chrono::steady_clock::now();
+        phase_time[phase] = uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(now - lap).count());
+        lap = now;
+    };
+
     // NOTE: update missiles
     missile_manager.update_missiles(); // Update missile positions
+    time_phase(PHASE_MISSILES);
+    std::vector<int> impact_damage(cities.size(), 0); // NOTE: impacts are accumulated per city, then applied once
+    std::vector<int> impact_count(cities.size(), 0);
+    std::vector<int> impacted;                        // Cities in order of first impact
     for (auto missile : missile_manager.get_attack_missiles())
     {
         if (!(missile->type == MissileType::ATTACK)) // Check if the missile is an attack missile
@@ -807,10 +1823,26 @@ void Game::pass_turn(void)
 
         if (attack_missile->get_direction() == MissileDirection::A) // Check if the missile has reached its target
         {
-            hit_city(attack_missile->city, attack_missile->damage); // Hit the city with the missile
+            int index = &attack_missile->city - cities.data();
+            if (impact_count.at(index) == 0)
+            {
+                impacted.push_back(index);
+            }
+            impact_damage.at(index) += attack_missile->damage;
+            impact_count.at(index)++;
+            impacts++;
+            landed += attack_missile->get_is_exploded() ? 1 : 0; // NOTE: a missile arriving on its last step only explodes next turn
         }
     }
+    for (auto index : impacted)
+    {
+        hit_city(cities.at(index), impact_damage.at(index), impact_count.at(index)); // Hit the city with every missile at once
+    }
     missile_manager.remove_missiles(); // Remove exploded missiles
+    time_phase(PHASE_IMPACTS);
+    int survivors = count_attacks();
+    intercepted_total += attacks - survivors - landed;
+    landed_total += landed;
 
     // NOTE: update cities productivity and missile production
     for (auto &city : cities)
@@ -856,24 +1888,128 @@ void Game::pass_turn(void)
     {
         hydrogen_bomb_counter--;
     }
+    time_phase(PHASE_ECONOMY);
 
     // NOTE: update research
     tech_tree.proceed_research();
     check_research(); // Check if research is complete
+    time_phase(PHASE_RESEARCH);
 
     // NOTE: check iron curtain & self defense system
     check_iron_curtain(); // Check if iron curtain is active
     self_defense();       // Activate self defense system
+    time_phase(PHASE_DEFENSE);
 
     // NOTE: create new attack wave
-    if (turn % 20 == 0 && turn > 0) // Check if it's time to launch a new attack wave
+    if (missile_manager.create_attack_wave(turn, enemy_hitpoint, difficulty_level)) // Launch the wave of this turn, if any
     {
-        missile_manager.create_attack_wave(turn, enemy_hitpoint, difficulty_level);
         insert_feedback("New Attack Missile Wave Approaching", COLOR_PAIR(3));
     }
 
     // NOTE: turn increment
     turn++;
+    missile_manager.prepare_attack_wave(turn, enemy_hitpoint, difficulty_level); // Plan the next wave ahead of time
+    time_phase(PHASE_WAVE);
+    turn_time = uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(lap - start).count());
+
+    int in_flight = count_attacks();
+    int city_hitpoint = 0;
+    for (const auto &city : cities)
+    {
+        city_hitpoint += std::max(0, city.hitpoint);
+    }
+    int resolved = intercepted_total + landed_total;
+    series.append({int32_t(deposit), int32_t(city_hitpoint), int32_t(in_flight),
+                   int32_t(resolved ? int64_t(intercepted_total) * 1000 / resolved : 0)});
+
+    if (live_stats)
+    {
+        publish_live_stats();
+    }
+    if (telemetry)
+    {
+        record_telemetry(in_flight - survivors, attacks - survivors - landed, impacts, casualty - casualty_before);
+    }
+}
+
+/**
+ * @brief Publishes the statistics of the turn just played to the live stats segment.
+ */
+void Game::publish_live_stats(void)
+{
+    LiveSnapshot snapshot = {};
+    snapshot.pid = getpid();
+    snapshot.level = difficulty_level;
+    snapshot.turn = turn;
+    snapshot.deposit = deposit;
+    snapshot.productivity = get_productivity();
+    snapshot.enemy_hp = enemy_hitpoint;
+    snapshot.score = score;
+    snapshot.casualty = casualty;
+    snapshot.cities = cities.size();
+    for (const auto &city : cities)
+    {
+        snapshot.cities_alive += city.hitpoint > 0 ? 1 : 0;
+        snapshot.city_hp += std::max(0, city.hitpoint);
+    }
+    for (const auto missile : missile_manager.missiles)
+    {
+        (missile->type == MissileType::ATTACK ? snapshot.attack_missiles : snapshot.cruise_missiles)++;
+    }
+    snapshot.turn_ns = turn_time;
+    std::copy(phase_time.begin(), phase_time.end(), snapshot.phase_ns);
+    snapshot.time_s = uint32_t(std::time(nullptr));
+    live_stats->publish(snapshot);
+}
+
+/**
+ * @brief Starts streaming a record per turn. The header takes the level, seed and cities,
+ * so this is called once the game has been started or loaded.
+ *
+ * @param writer Telemetry file of this game, or null to stop (which flushes the old one).
+ */
+void Game::set_telemetry(std::unique_ptr<TelemetryWriter> writer)
+{
+    telemetry = std::move(writer);
+    if (telemetry)
+    {
+        telemetry->begin(difficulty_level, missile_manager.get_seed(), cities.size());
+        telemetry_hitpoints.assign(cities.size(), 0);
+    }
+}
+
+/**
+ * @brief Queues the record of the turn just played; dropped if the writer is behind.
+ *
+ * @param spawned Attack missiles launched this turn.
+ * @param intercepted Attack missiles destroyed without reaching a city.
+ * @param impacted Attack missiles that hit a city.
+ * @param casualty_delta Casualties caused this turn.
+ */
+void Game::record_telemetry(int spawned, int intercepted, int impacted, int casualty_delta)
+{
+    TelemetryRecord record;
+    record.turn = turn;
+    record.deposit = deposit;
+    record.productivity = get_productivity();
+    record.enemy_hp = enemy_hitpoint;
+    record.score = score;
+    record.casualty_delta = casualty_delta;
+    record.spawned = spawned;
+    record.intercepted = intercepted;
+    record.impacted = impacted;
+    record.researched = 0;
+    for (size_t index = 0; index < tech_tree.nodes.size() && index < 32; index++)
+    {
+        record.researched |= tech_tree.is_researched(tech_tree.nodes[index]) ? 1u << index : 0;
+    }
+    record.turn_ns = turn_time;
+    std::copy(phase_time.begin(), phase_time.end(), record.phase_ns);
+    for (size_t index = 0; index < cities.size(); index++)
+    {
+        telemetry_hitpoints[index] = std::max(0, cities[index].hitpoint);
+    }
+    telemetry->push(record, telemetry_hitpoints.data());
 }
 
 /**
@@ -896,12 +2032,36 @@ bool Game::is_in_range(Position p1, Position p2, int range) const
     return true;
 }
 
+/**
+ * @brief Checks whether the game has ended, without settling the score.
+ * @return bool True if the enemy is destroyed or every city is lost
+ */
+bool Game::is_game_over(void) const
+{
+    if (enemy_hitpoint <= 0)
+    {
+        return true;
+    }
+    for (const auto &city : cities)
+    {
+        if (city.hitpoint > 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 /**
  * @brief Determines game termination conditions. Checks enemy destruction or complete city loss.
  * @return bool True if game should end, false otherwise
  */
 bool Game::check_game_over(void)
 {
+    if (!is_game_over())
+    {
+        return false; // game continues
+    }
     if (enemy_hitpoint <= 0) // Check if the enemy has been defeated
     {
         for (const auto &city : cities)
@@ -916,17 +2076,41 @@ bool Game::check_game_over(void)
         return true;                // game win
     }
 
-    for (const auto &city : cities)
+    score += turn * 2;     // endurance bonus
+    score -= casualty * 3; // casualty penalty
+    return true;           // game lose
+}
+
+/**
+ * @brief Hashes the simulated state with 64-bit FNV-1a, for desync checks between peers.
+ * The cursor, view and feedback are local to each player and left out.
+ * @return uint64_t Hash of the turn, economy, research, super weapons, cities and missiles
+ */
+uint64_t Game::get_state_hash(void) const
+{
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    auto mix = [&hash](int64_t value)
     {
-        if (city.hitpoint > 0) // check if any city is still alive
+        for (int byte = 0; byte < 8; byte++)
         {
-            return false; // game continues
+            hash = (hash ^ uint64_t((value >> (byte * 8)) & 0xFF)) * 0x100000001B3ULL;
         }
-    }
+    };
 
-    score += turn * 2;     // endurance bonus
-    score -= casualty * 3; // casualty penalty
-    return true;           // game lose
+    mix(turn), mix(deposit), mix(enemy_hitpoint), mix(score), mix(casualty);
+    mix(standard_bomb_counter), mix(dirty_bomb_counter), mix(hydrogen_bomb_counter), mix(iron_curtain_counter);
+    mix(tech_tree.researched.size()), mix(tech_tree.remaining_time);
+    mix(tech_tree.researching == nullptr ? -1 : std::find(tech_tree.nodes.begin(), tech_tree.nodes.end(), tech_tree.researching) - tech_tree.nodes.begin());
+    for (const auto &city : cities)
+    {
+        mix(city.hitpoint), mix(city.productivity), mix(city.countdown), mix(city.cruise_storage);
+    }
+    for (const auto missile : missile_manager.missiles)
+    {
+        mix(missile->id), mix(int(missile->type)), mix(missile->is_exploded), mix(missile->damage), mix(missile->speed);
+        mix(missile->position.y), mix(missile->position.x), mix(missile->target.y), mix(missile->target.x);
+    }
+    return hash;
 }
 
 /**
@@ -1128,12 +2312,16 @@ void Game::finish_research(TechNode *node)
 }
 
 /**
- * @brief Applies damage to target city. Implements damage reduction mechanics.
+ * @brief Applies the damage of one or more attack missiles to a target city. Implements
+ *        damage reduction mechanics.
+ * A batch of impacts costs a single casualty roll and produces a single feedback line.
  * @param city Target city reference
- * @param damage Base damage value before modifiers
+ * @param damage Total base damage of the batch before modifiers
+ * @param count Number of attack missiles in the batch
  */
-void Game::hit_city(City &city, int damage)
+void Game::hit_city(City &city, int damage, int count)
 {
+    std::string missiles = count == 1 ? "Attack Missile" : std::to_string(count) + " Attack Missiles";
     if (iron_curtain_counter >= 0)
     {
         insert_feedback("Iron Curtain Activated, " + city.name + " Not Damaged", COLOR_PAIR(4));
@@ -1142,17 +2330,17 @@ void Game::hit_city(City &city, int damage)
     damage = en_self_defense_sys ? damage / 2 : damage;
     if (damage > city.hitpoint && city.hitpoint > 0)
     {
-        insert_feedback(city.name + " Destroyed by Attack Missile!", COLOR_PAIR(2));
+        insert_feedback(city.name + " Destroyed by " + missiles + "!", COLOR_PAIR(2));
         city.hitpoint = 0;
         score -= 50;
-        casualty += (200 + generate_random(-50, 50));
+        casualty += (200 + generate_random(-50, 50, RandomPurpose::CASUALTY, &city - cities.data()));
     }
     else
     {
-        insert_feedback(city.name + " Hit by Attack Missile, HP -" + std::to_string(damage / (en_fortress_city ? 2 : 1)), COLOR_PAIR(2));
+        insert_feedback(city.name + " Hit by " + missiles + ", HP -" + std::to_string(damage / (en_fortress_city ? 2 : 1)), COLOR_PAIR(2));
         city.hitpoint -= damage;
-        score -= 20;
-        casualty += (damage / 10 * (10 + generate_random(-3, 3)));
+        score -= 20 * count;
+        casualty += (damage / 10 * (10 + generate_random(-3, 3, RandomPurpose::CASUALTY, &city - cities.data())));
     }
 }
 
@@ -1227,7 +2415,7 @@ void Game::launch_cruise(void)
     }
     if (!missile_manager.create_cruise_missile(city, 100, en_enhanced_cruise_II ? 4 : 3)) // Try to create cruise missile
     {
-        insert_feedback("No targeted attack missile in range", COLOR_PAIR(3));
+        insert_feedback("No interceptable attack missile in range", COLOR_PAIR(3));
         return;
     }
     insert_feedback("Cruise Missile Launched", COLOR_PAIR(4));
@@ -1333,7 +2521,7 @@ void Game::launch_dirty_bomb(void)
     }
     dirty_bomb_counter = -1; // Set counter to -1 to indicate bomb has been used
 
-    if (generate_random(0, 3) == 0) // Check if bomb misses
+    if (generate_random(0, 3, RandomPurpose::DIRTY_BOMB) == 0) // Check if bomb misses
     {
         insert_feedback("Dirty Bomb Missed", COLOR_PAIR(3));
         return;
@@ -1393,7 +2581,7 @@ void Game::launch_hydrogen_bomb(void)
     }
     hydrogen_bomb_counter = -1; // Set counter to -1 to indicate bomb has been used
 
-    if (generate_random(0, 1) == 0) // Check if bomb misses
+    if (generate_random(0, 1, RandomPurpose::HYDROGEN_BOMB) == 0) // Check if bomb misses
     {
         insert_feedback("Hydrogen Bomb Missed", COLOR_PAIR(3));
         return;
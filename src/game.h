@@ -14,7 +14,15 @@
 #include <vector>
 #include <array>
 #include <algorithm>
+#include <random>
+#include <memory>
+#include <future>
+#include <unordered_map>
 #include "saver.h"
+#include "terrain.h"
+#include "rng.h"
+#include "stats.h"
+#include "telemetry.h"
 #include "utils.h"
 
 #define inf 0x3f3f3f3f
@@ -56,9 +64,12 @@ class City
 {
     friend class Game;
     friend class GameRenderer;
+    friend class Frame;
     friend class MissileManager;
     friend class SaveDumper;
     friend class SaveLoader;
+    friend class AssetLoader;
+    friend class ScriptRunner;
 
 private:
     Position position; ///< Map coordinates
@@ -134,6 +145,7 @@ class Missile
 {
     friend class Game;
     friend class GameRenderer;
+    friend class Frame;
     friend class MissileManager;
     friend class SaveDumper;
     friend class SaveLoader;
@@ -141,6 +153,7 @@ class Missile
 protected:
     int id; ///< Unique identifier
     Position position; ///< Current coordinates
+    Position prev_position; ///< Coordinates before the last move, to draw the missile between turns
     Position target;  ///< Destination coordinates
     MissileType type; ///< Behavior category
     bool is_exploded; ///< Detonation status
@@ -153,12 +166,13 @@ public:
      /// @name Core Functionality
     /// @{
     Position get_position(void) const { return position; };
+    Position get_position(double blend) const; ///< Point between the last two positions, 0 for the previous one
     virtual Position get_target(void) = 0;
     MissileType get_type(void) const { return type; };
-    MissileDirection get_direction(void);
+    virtual MissileDirection get_direction(void);
     bool get_is_exploded(void) const { return is_exploded; };
     void set_is_exploded(void) { is_exploded = true; };
-    void move(void);
+    virtual void move(void);
     virtual void move_step(void);
 };
 
@@ -175,20 +189,27 @@ class AttackMissile : public Missile
 {
     friend class Game;
     friend class GameRenderer;
+    friend class Frame;
     friend class MissileManager;
     friend class SaveDumper;
     friend class SaveLoader;
+    friend class CruiseMissile;
 
 private:
     City &city; ///< Target city reference
     bool is_aimed = false; ///< Target lock status
+    std::shared_ptr<const FlowField> route; ///< Shared route to the city, null for straight flight
 
 public:
     AttackMissile(int i, Position p, City &c, int d, int v);
     /// @name Overrides
     /// @{
     virtual Position get_target(void) override { return city.get_position(); };
+    virtual MissileDirection get_direction(void) override;
     virtual void move_step(void) override;
+    /// @}
+
+    Position predict_position(Position from, int steps) const; ///< Where the missile will be after `steps` more steps from `from`
 };
 
 /**
@@ -203,12 +224,15 @@ class CruiseMissile : public Missile
 {
     friend class Game;
     friend class GameRenderer;
+    friend class Frame;
     friend class MissileManager;
     friend class SaveDumper;
 
 private:
     Missile &missile; ///< Target missile reference
     int target_id; ///< Tracked missile ID
+    Position intercept; ///< Predicted meeting point with the target missile
+    bool has_intercept = false; ///< Whether `intercept` is valid, pure pursuit otherwise
 
 public:
     CruiseMissile(int i, Position p, Missile &m, int d, int v, int t_id);
@@ -216,7 +240,172 @@ public:
     /// @name Overrides
     /// @{
     virtual Position get_target(void) override { return missile.get_position(); };
+    virtual void move(void) override;
     virtual void move_step(void) override;
+    /// @}
+
+    static bool solve_intercept(Position launch, int v, const AttackMissile &m, Position &point);
+};
+
+/**
+ * @class AliasTable
+ * @brief Precomputed table for O(1) weighted random sampling (Walker/Vose alias method).
+ *
+ * The table is built once from a list of integer weights in O(n) time. Each sample then
+ * costs one uniform index draw and one uniform real draw, regardless of the number of
+ * outcomes. Negative weights are treated as zero; if every weight is zero the table
+ * falls back to a uniform distribution.
+ */
+class AliasTable
+{
+private:
+    std::vector<double> probability; ///< Probability of keeping the drawn column
+    std::vector<int> alias;          ///< Fallback outcome of each column
+
+public:
+    AliasTable(void) {};
+    AliasTable(const std::vector<int> &weights) { build(weights); };
+    void build(const std::vector<int> &weights);
+    bool empty(void) const { return probability.empty(); };
+    int size(void) const { return probability.size(); };
+    int sample(CounterRandom &rng) const;
+};
+
+/**
+ * @struct WaveSpawn
+ * @brief One planned attack missile of an upcoming wave.
+ */
+struct WaveSpawn
+{
+    Position position; ///< Start position outside the map edge
+    int speed;         ///< Movement units per turn
+    int damage;        ///< Impact damage value
+};
+
+/**
+ * @struct WavePlan
+ * @brief Attack wave planned ahead of its turn, together with the inputs it was planned from.
+ * Targets are not part of the plan: they depend on the city hitpoints of the wave turn.
+ * When missiles are routed, the worker also guesses the targets from the hitpoints of the
+ * planning turn and builds the routes to those not cached yet.
+ */
+struct WavePlan
+{
+    int turn;                      ///< Turn the wave is launched on
+    int bias;                      ///< Speed/damage bias derived from enemy hitpoint and turn
+    std::vector<WaveSpawn> spawns; ///< Planned missiles
+    std::vector<int> city_hitpoints;      ///< City hitpoints when planned, to guess the targets
+    std::vector<Position> city_positions; ///< City cells, to guess the targets
+    std::vector<Position> cached;         ///< Targets whose routes were cached when planned
+    std::vector<std::shared_ptr<const FlowField>> routes; ///< Routes built by the worker
+};
+
+/**
+ * @struct Forecast
+ * @brief Predicted flight of every attack missile, made on a worker thread when a frame first
+ * asks for it in a turn.
+ */
+struct Forecast
+{
+    int turn = -1;                             ///< Turn the forecast was made on, -1 for none
+    std::vector<Position> path;                ///< Cells any attack missile will still fly over, sorted by row then column
+    std::unordered_map<int, int> impact_turns; ///< Turn each attack missile (by id) hits its city
+};
+
+/**
+ * @class ThreatMap
+ * @brief Damage of the attack missiles in flight, summed over blocks of the map.
+ *
+ * Kept up to date as missiles are created, move and are removed, so a turn costs
+ * O(moved missiles) and reading the threat on a cell is O(1). Missiles outside the map
+ * are not counted until they enter it.
+ */
+class ThreatMap
+{
+public:
+    static const int BLOCK_H = 3; ///< Rows of a block
+    static const int BLOCK_W = 6; ///< Columns of a block
+    static const int HEAVY = 500; ///< Damage in a block shaded as a heavy threat
+
+private:
+    Size size;               ///< Map size
+    Size blocks;             ///< Blocks across the map
+    std::vector<int> damage; ///< Damage in each block, row by row
+
+    int get_index(Position p) const;
+
+public:
+    void reset(Size s); ///< Forget every missile and cover a map of size `s`
+    void add(Position p, int d);
+    void move(Position from, Position to, int d);
+    int get(Position p) const; ///< Damage in the block of a cell, 0 outside the map
+};
+
+/**
+ * @enum WaveTarget
+ * @brief How the missiles of a wave pick their target city.
+ */
+enum class WaveTarget : int
+{
+    HITPOINT = 0, ///< Weighted by city hitpoints
+    UNIFORM = 1   ///< Every standing city is equally likely
+};
+
+/**
+ * @struct WaveRule
+ * @brief Attack waves launched over a range of turns at one difficulty level, as read from "waves.txt".
+ *
+ * Waves are launched on `start`, `start + interval`, ... within the range. Each missile draws
+ * its speed and damage uniformly from the lists, with one extra chance on the bias index,
+ * which grows with the enemy hitpoint and the turn.
+ */
+struct WaveRule
+{
+    int level;                 ///< Difficulty level the rule applies to
+    int start;                 ///< First turn of the range, also its first wave
+    int end;                   ///< Last turn of the range (inclusive), -1 if open-ended
+    int interval;              ///< Turns between two waves
+    int count_base;            ///< Missiles in a wave on turn 0
+    int count_turns;           ///< Turns per extra missile, 0 for a fixed count
+    std::vector<int> speeds;   ///< Speeds drawn from, slowest first
+    std::vector<int> damages;  ///< Damages drawn from, weakest first
+    int hitpoint_step;         ///< Enemy hitpoints per bias step, 0 to ignore the hitpoint
+    int turn_step;             ///< Turns per bias step, 0 to ignore the turn
+    WaveTarget target;         ///< Target city weighting
+    std::string edges;         ///< Map edges missiles start from, any of "LRTB"
+
+    bool is_in_range(int turn) const { return turn >= start && (end < 0 || turn <= end); };
+    int get_count(int turn) const;
+    int get_bias(int turn, int hitpoint) const;
+    std::vector<int> get_target_weights(const std::vector<int> &hitpoints) const;
+};
+
+/**
+ * @class WaveTable
+ * @brief Wave rules compiled into a per-level, per-turn lookup.
+ *
+ * Within a level the first rule whose range contains a turn governs it. Compiling resolves
+ * every turn up to the last closed range once, and the first open-ended rule covers all
+ * later turns, so finding the wave of a turn costs O(1) however many rules there are.
+ */
+class WaveTable
+{
+private:
+    std::vector<WaveRule> rules;
+    std::vector<std::vector<int>> lookup; ///< Per level, index of the rule launching a wave on each turn, -1 if none
+    std::vector<int> tail;                ///< Per level, index of the rule governing turns past `lookup`, -1 if none
+
+public:
+    static const int MAX_LEVEL = 9;      ///< Highest difficulty level a rule may target
+    static const int MAX_TURN = 100000; ///< Latest turn a range may start or end on, bounding the lookup
+
+    WaveTable(void) {};
+    WaveTable(const std::vector<WaveRule> &rs) { compile(rs); };
+
+    static std::vector<WaveRule> get_default_rules(void);
+    void compile(const std::vector<WaveRule> &rs);
+    const WaveRule *get_wave(int level, int turn) const; ///< Rule launching a wave on `turn`, null if none
+    int get_next_wave(int level, int turn) const;        ///< First wave turn not before `turn`, -1 if none
 };
 
 /**
@@ -231,6 +420,7 @@ class MissileManager
 {
     friend class Game;
     friend class GameRenderer;
+    friend class Frame;
     friend class SaveDumper;
     friend class SaveLoader;
     friend class AssetLoader;
@@ -239,36 +429,71 @@ private:
     int id;
     Size size;
     std::vector<City> &cities;
+    const Terrain &terrain;
     std::vector<Missile *> missiles;
-    std::array<int, 5> speed_list = {0};
-    std::array<int, 5> damage_list = {0};
-    // NOTE: controls how missile num in a wave increases by turn
-    std::array<int, 3> inc_turn = {50, 30, 20};
-
-    int generate_random(int min, int max);
-    int generate_random_biased(int min, int max, int biased);
-    int generate_random_weighted(const std::vector<int> &weights);
+    RoutingMode routing = RoutingMode::DIRECT; ///< How attack missiles cross the terrain
+    /**
+     * @struct CachedRoute
+     * @brief A cached flow field and when it was last used.
+     */
+    struct CachedRoute
+    {
+        std::shared_ptr<const FlowField> field;
+        uint64_t used; ///< Value of route_clock at the last use
+    };
+    std::unordered_map<int, CachedRoute> flow_fields; ///< Route of recently targeted city cells
+    uint64_t route_clock = 0; ///< Counts route uses, to evict the least recently used
+    size_t route_bytes = 0;   ///< Memory held by the cached routes
+    WaveTable waves; ///< Compiled wave rules of every difficulty level
+    uint64_t seed; ///< Key of every counter-based random stream of the game
+    bool is_async = true; ///< Plan waves and forecasts on worker threads, rather than when needed
+    std::future<WavePlan> next_wave; ///< Next wave, planned on a worker thread
+    Forecast forecast; ///< Latest finished forecast of the attack missiles
+    std::future<Forecast> next_forecast; ///< Forecast being made on a worker thread
+    ThreatMap threat_map; ///< Damage of the attack missiles in flight, by map block
+
+    static int generate_random(CounterRandom &rng, int min, int max);
+    static int generate_random_biased(CounterRandom &rng, int min, int max, int biased);
+    static WavePlan plan_attack_wave(WavePlan plan, WaveRule rule, Size size, uint64_t seed);
+    static WavePlan plan_attack_wave_routes(WavePlan plan, WaveRule rule, Size size, uint64_t seed, Terrain terrain, RoutingMode mode);
+    bool is_routed(void) const { return routing != RoutingMode::DIRECT && FlowField::is_routable(terrain); };
+    void cache_flow_field(const std::shared_ptr<const FlowField> &field);
+    void clear_flow_fields(void);
+    static Forecast plan_forecast(std::vector<AttackMissile> snapshot, int turn);
 
 public:
-    MissileManager(std::vector<City> &cts);
+    static const size_t MAX_ROUTE_BYTES = 64 << 20; ///< Memory the cached routes may hold, at least one is kept
+
+    MissileManager(std::vector<City> &cts, const Terrain &t);
+    uint64_t get_seed(void) const { return seed; };
+    void set_seed(uint64_t s); ///< Rekey the random streams, dropping any wave planned with the old key
+    void set_async(bool a);    ///< Whether to start worker threads, e.g. off when the caller is one
     /// @name Missile Access
     /// @{
     std::vector<Missile *> get_missiles(void); ///< All active missiles
     std::vector<Missile *> get_attack_missiles(void); ///< Offensive missiles
     std::vector<Missile *> get_cruise_missiles(void); ///< Defensive missiles
+    const ThreatMap &get_threat_map(void) const { return threat_map; };
     /// @}
     
     /// @name Operations
     /// @{
 
-    void set_difficulty(int lv);
     bool city_weight_check(City &c);
+    std::shared_ptr<const FlowField> get_flow_field(const City &c);
+    void set_routing(RoutingMode mode);
     void create_attack_missile(Position p, City &c, int d, int v);
     bool create_cruise_missile(City &c, int d, int v);
     void update_missiles(void);
     void remove_missiles(void);
 
-    void create_attack_wave(int turn, int difficulty_level, int hitpoint);
+    void prepare_attack_wave(int turn, int hitpoint, int difficulty_level);
+    void cancel_attack_wave(void);
+    bool create_attack_wave(int turn, int hitpoint, int difficulty_level);
+
+    void prepare_forecast(int turn);
+    void cancel_forecast(void);
+    const Forecast &get_forecast(int turn); ///< Latest forecast, made again if older than `turn`
 };
 
 /**
@@ -283,10 +508,12 @@ class TechNode
 {
     friend class Game;
     friend class GameRenderer;
+    friend class Frame;
     friend class TechTree;
     friend class TechMenu;
     friend class SaveDumper;
     friend class SaveLoader;
+    friend class ScriptRunner;
 
 private:
     std::string name; ///< Technology name
@@ -321,10 +548,12 @@ class TechTree
 {
     friend class Game;
     friend class GameRenderer;
+    friend class Frame;
     friend class TechMenu;
     friend class SaveDumper;
     friend class SaveLoader;
     friend class AssetLoader;
+    friend class ScriptRunner;
 
 private:
     std::vector<TechNode *> nodes; ///< All available technologies
@@ -353,6 +582,50 @@ private:
     bool check_available(TechNode *node, int deposit) const; ///< Validate prerequisites
 };
 
+/**
+ * @enum SeriesColumn
+ * @brief Per-turn series recorded by TurnSeries.
+ */
+enum SeriesColumn
+{
+    SERIES_DEPOSIT = 0,   ///< Deposit after the turn
+    SERIES_CITY_HP = 1,   ///< Total hitpoints of every city
+    SERIES_MISSILES = 2,  ///< Attack missiles in flight
+    SERIES_INTERCEPT = 3, ///< Attack missiles shot down so far, per mille of those resolved
+    SERIES_COUNT = 4
+};
+
+/**
+ * @class TurnSeries
+ * @brief Per-turn statistics of a game, stored column by column.
+ *
+ * Every column is a plain array that doubles in size when full, so appending a turn is
+ * amortised O(1) and a column can be scanned without touching the others. Each column
+ * keeps running sums alongside its values, so the mean over any range of turns costs
+ * O(1) and downsampling a whole game to a chart of `width` points costs O(width).
+ */
+class TurnSeries
+{
+private:
+    std::array<std::unique_ptr<int32_t[]>, SERIES_COUNT> values;
+    std::array<std::unique_ptr<int64_t[]>, SERIES_COUNT> sums; ///< sums[c][i] is the sum of the first i values
+    size_t length;
+    size_t capacity;
+
+    void grow(void);
+
+public:
+    TurnSeries(void);
+    void clear(void) { length = 0; };
+    void append(const std::array<int32_t, SERIES_COUNT> &row);
+
+    size_t size(void) const { return length; };
+    int32_t at(SeriesColumn column, size_t turn) const { return values[column][turn]; };
+    int32_t back(SeriesColumn column) const { return length ? values[column][length - 1] : 0; };
+    double get_mean(SeriesColumn column, size_t first, size_t last) const; ///< Mean over turns [first, last)
+    std::vector<int32_t> downsample(SeriesColumn column, int width) const; ///< At most `width` bucket means
+};
+
 /**
  * @class Game
  * @brief Represents the main game logic, managing the state of the game, cities, missiles, and technology.
@@ -364,14 +637,19 @@ private:
 class Game
 {
     friend class GameRenderer;
+    friend class Frame;
     friend class SaveDumper;
     friend class SaveLoader;
     friend class AssetLoader;
     friend class OperationMenu;
+    friend class ScriptRunner;
 
 private:
     Size size;
+    Size view_size;       ///< Visible part of the map, defaults to the whole map
+    Position view_origin; ///< Top-left map cell of the visible part
     Position cursor;
+    bool is_heatmap_shown = false; ///< Shade the map by the threat of the attack missiles
     int turn;
     int deposit;
     int difficulty_level;
@@ -380,7 +658,7 @@ private:
     int casualty;
 
     std::vector<City> cities;
-    std::vector<std::string> background;
+    Terrain terrain; ///< Compiled map background
     VAttrString feedbacks;
     MissileManager missile_manager;
     TechTree tech_tree;
@@ -409,15 +687,32 @@ private:
     bool en_self_defense_sys = false;
     bool en_iron_curtain = false;
 
-    int generate_random(int min, int max);
+    // NOTE: duration of the last pass_turn and of each of its phases, in nanoseconds
+    uint32_t turn_time = 0;
+    std::array<uint32_t, PHASE_COUNT> phase_time = {};
+    std::unique_ptr<LiveStats> live_stats; ///< Segment published every turn, null when disabled
+    std::unique_ptr<TelemetryWriter> telemetry; ///< Record stream of this game, null when disabled
+    std::vector<int32_t> telemetry_hitpoints;    ///< City hitpoints of the record being built
+    TurnSeries series;     ///< Statistics of every turn played since the game was started or loaded
+    int intercepted_total; ///< Attack missiles shot down since then
+    int landed_total;      ///< Attack missiles that reached a city since then
+
+    int generate_random(int min, int max, RandomPurpose purpose, int index = 0);
+    void follow_cursor(void); ///< Scroll the view to keep the cursor visible
+    void publish_live_stats(void);
+    void record_telemetry(int spawned, int intercepted, int impacted, int casualty_delta);
 
 public:
-    Game(void) : missile_manager(cities) {};
+    static const int MAX_TURNS_PER_SECOND = 512; ///< Fastest pace of the real-time mode
+
+    Game(void) : view_size(0, 0), view_origin(0, 0), missile_manager(cities, terrain), intercepted_total(0), landed_total(0) {};
     void set_difficulty(int lv);
 
     const Size &get_size(void) const { return size; };
+    const Size &get_view_size(void) const { return view_size; };
+    const Position &get_view_origin(void) const { return view_origin; };
     const Position &get_cursor(void) const { return cursor; };
-    const std::vector<std::string> &get_background(void) const { return background; };
+    const Terrain &get_terrain(void) const { return terrain; };
     const VAttrString &get_feedbacks(void) const { return feedbacks; };
     MissileManager &get_missile_manager(void) { return missile_manager; };
     TechTree &get_tech_tree(void) { return tech_tree; };
@@ -428,16 +723,21 @@ public:
     int get_deposit(void) const { return deposit; };
     int get_productivity(void) const;
     int get_enemy_hp(void) const { return enemy_hitpoint; };
+    int get_difficulty(void) const { return difficulty_level; };
 
     // NOTE: cursor/position-related functions
     void move_cursor(Position dcursor); ///< Cursor movement
     void move_cursor_to_city(int index); ///< City quick-select
     void pass_turn(void);  ///< Advance game state
     bool is_in_map(Position p) const { return p.y >= 0 && p.y < size.h && p.x >= 0 && p.x < size.w; };
+    bool is_in_view(Position p) const { return p.y >= view_origin.y && p.y < view_origin.y + view_size.h && p.x >= view_origin.x && p.x < view_origin.x + view_size.w; };
+    void fit_view(Size s); ///< Resize the view, clamped to the map
+    bool get_is_heatmap_shown(void) const { return is_heatmap_shown; };
+    void toggle_heatmap(void); ///< Show or hide the threat heatmap
     bool is_in_range(Position p1, Position p2, int range) const;
-    bool is_on_sea(Position p) const { return background.at(p.y).at(p.x) == '#'; };
-    bool is_on_city(Position p) const { return background.at(p.y).at(p.x) == '@'; };
-    bool is_on_land(Position p) const { return background.at(p.y).at(p.x) == ' '; };
+    bool is_on_sea(Position p) const { return terrain.at(p) == TerrainType::SEA; };
+    bool is_on_city(Position p) const { return terrain.at(p) == TerrainType::CITY; };
+    bool is_on_land(Position p) const { return terrain.at(p) == TerrainType::LAND; };
     bool is_selected_missile(void);
     bool is_selected_city(void);
     Missile &select_missile(void);
@@ -447,7 +747,7 @@ public:
     void start_research(TechNode *node);
     void check_research(void);
     void finish_research(TechNode *node);
-    void hit_city(City &city, int damage); ///< Apply city damage
+    void hit_city(City &city, int damage, int count = 1); ///< Apply city damage of a batch of missiles
     void fix_city(void); ///< Repair city
     void build_cruise(void); ///< Produce defense
     void launch_cruise(void); ///< Deploy defense
@@ -465,7 +765,18 @@ public:
     // NOTE: score-related functions
     int get_score(void) const { return score; };
     int get_casualty(void) const { return casualty; };
-    bool check_game_over(void);
+    bool is_game_over(void) const; ///< Whether the game has ended, leaves the score alone
+    bool check_game_over(void);    ///< Whether the game has ended, settling the final score once it has
+    uint64_t get_state_hash(void) const; ///< Hash of the simulated state, for desync checks
+
+    // NOTE: statistics export
+    void set_live_stats(std::unique_ptr<LiveStats> stats) { live_stats = std::move(stats); };
+    void set_telemetry(std::unique_ptr<TelemetryWriter> writer); ///< Start streaming records, once the game is set up
+    uint32_t get_turn_time(void) const { return turn_time; };
+    const std::array<uint32_t, PHASE_COUNT> &get_phase_time(void) const { return phase_time; };
+    const TurnSeries &get_series(void) const { return series; };
+    int get_intercepted_total(void) const { return intercepted_total; };
+    int get_landed_total(void) const { return landed_total; };
 };
 
 #endif
@@ -0,0 +1,260 @@
+/**
+ * @file generator.cpp
+ * @brief Implementation of the procedural map and city generator.
+ *
+ * Classes:
+ * - MapGenerator: Produces coastlines from fractal value noise and scatters cities on
+ *   land with Poisson-disk sampling.
+ *
+ * Dependencies:
+ * - generator.h: Declaration of the MapGenerator class.
+ * - terrain.h: Target terrain grid.
+ * - game.h: City class of the generated cities.
+ */
+
+#include <string>
+#include <vector>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+#include "generator.h"
+
+/**
+ * @brief Constructs a generator for a map of the given size.
+ *
+ * @param s Size of the map to generate.
+ * @param n Number of cities to place.
+ * @param sd Seed of every generation step.
+ */
+MapGenerator::MapGenerator(Size s, int n, uint32_t sd)
+    : size(s), city_count(n), seed(sd), sea_level(0.5), octaves(5)
+{
+    base_period = std::max(8, std::min(size.h, size.w) / 3);
+}
+
+/**
+ * @brief Hashes a lattice point into a well mixed 32-bit value.
+ *
+ * @param y Lattice row.
+ * @param x Lattice column.
+ * @param salt Per-octave salt derived from the seed.
+ * @return uint32_t: Hash of the lattice point.
+ */
+uint32_t MapGenerator::hash(int y, int x, uint32_t salt)
+{
+    uint32_t h = salt ^ (uint32_t(y) * 0x27d4eb2dU) ^ (uint32_t(x) * 0x165667b1U);
+    h ^= h >> 15;
+    h *= 0x2c1b3c6dU;
+    h ^= h >> 12;
+    h *= 0x297a2d39U;
+    h ^= h >> 15;
+    return h;
+}
+
+/**
+ * @brief Fills the terrain with noise-generated land and sea.
+ * The terrain is reset to a flat grid of the generator's size first.
+ *
+ * @param terrain Terrain to overwrite.
+ */
+void MapGenerator::generate_terrain(Terrain &terrain) const
+{
+    terrain.reset(size);
+    std::vector<float> height(size.w);
+    std::vector<float> column;
+    std::vector<float> fade;
+    for (int y = 0; y < size.h; y++)
+    {
+        std::fill(height.begin(), height.end(), 0.0f);
+        float amplitude = 1.0f;
+        float total = 0.0f;
+        for (int octave = 0, period = base_period; octave < octaves; octave++, period = std::max(2, period / 2))
+        {
+            uint32_t salt = seed + uint32_t(octave) * 0x9e3779b9U;
+            int lattice_y = y / period;
+            float ty = float(y % period) / period;
+            ty = ty * ty * (3.0f - 2.0f * ty);
+
+            // NOTE: hash the lattice once per row, interpolating vertically up front
+            int lattice_w = size.w / period + 2;
+            column.resize(lattice_w);
+            for (int i = 0; i < lattice_w; i++)
+            {
+                float lower = (hash(lattice_y, i, salt) >> 8) / 16777216.0f;
+                float upper = (hash(lattice_y + 1, i, salt) >> 8) / 16777216.0f;
+                column[i] = lower + (upper - lower) * ty;
+            }
+            fade.resize(period);
+            for (int j = 0; j < period; j++)
+            {
+                float t = float(j) / period;
+                fade[j] = t * t * (3.0f - 2.0f * t);
+            }
+
+            // NOTE: branch-free horizontal interpolation over contiguous arrays
+            for (int i = 0, x = 0; x < size.w; i++, x += period)
+            {
+                int span = std::min(period, size.w - x);
+                float left = column[i];
+                float slope = column[i + 1] - column[i];
+                float *out = height.data() + x;
+                for (int j = 0; j < span; j++)
+                {
+                    out[j] += amplitude * (left + slope * fade[j]);
+                }
+            }
+            total += amplitude;
+            amplitude *= 0.5f;
+        }
+
+        float threshold = sea_level * total;
+        for (int x = 0; x < size.w; x++)
+        {
+            if (height[x] < threshold)
+            {
+                terrain.set(Position(y, x), TerrainType::SEA);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Draws a Poisson-disk point set covering the whole map with Bridson's algorithm.
+ * A background grid with cells of spacing / sqrt(2) holds at most one point each, so
+ * checking a candidate only looks at the surrounding 5x5 grid cells.
+ *
+ * @param spacing Minimum distance between two points.
+ * @return std::vector<Position>: Cells containing the sampled points.
+ */
+std::vector<Position> MapGenerator::sample_disk(double spacing) const
+{
+    const int attempts = 30;
+    std::mt19937 engine(seed ^ 0x85ebca6bU);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    double cell = spacing / std::sqrt(2.0);
+    int grid_h = int(std::ceil(size.h / cell));
+    int grid_w = int(std::ceil(size.w / cell));
+    std::vector<int> grid(size_t(grid_h) * grid_w, -1);
+    std::vector<double> ys;
+    std::vector<double> xs;
+    std::vector<int> active;
+
+    ys.push_back(unit(engine) * size.h);
+    xs.push_back(unit(engine) * size.w);
+    grid[size_t(ys[0] / cell) * grid_w + size_t(xs[0] / cell)] = 0;
+    active.push_back(0);
+    while (!active.empty())
+    {
+        int slot = std::uniform_int_distribution<int>(0, active.size() - 1)(engine);
+        int parent = active[slot];
+        bool found = false;
+        for (int attempt = 0; attempt < attempts && !found; attempt++)
+        {
+            double angle = unit(engine) * 2.0 * std::acos(-1.0);
+            double radius = spacing * (1.0 + unit(engine));
+            double y = ys[parent] + radius * std::sin(angle);
+            double x = xs[parent] + radius * std::cos(angle);
+            if (y < 0 || y >= size.h || x < 0 || x >= size.w)
+            {
+                continue;
+            }
+            int gy = int(y / cell);
+            int gx = int(x / cell);
+            bool fits = true;
+            for (int ny = std::max(0, gy - 2); ny <= std::min(grid_h - 1, gy + 2) && fits; ny++)
+            {
+                for (int nx = std::max(0, gx - 2); nx <= std::min(grid_w - 1, gx + 2); nx++)
+                {
+                    int other = grid[size_t(ny) * grid_w + nx];
+                    if (other != -1 && (ys[other] - y) * (ys[other] - y) + (xs[other] - x) * (xs[other] - x) < spacing * spacing)
+                    {
+                        fits = false;
+                        break;
+                    }
+                }
+            }
+            if (fits)
+            {
+                grid[size_t(gy) * grid_w + gx] = ys.size();
+                active.push_back(ys.size());
+                ys.push_back(y);
+                xs.push_back(x);
+                found = true;
+            }
+        }
+        if (!found) // Retire the point once its annulus is full
+        {
+            active[slot] = active.back();
+            active.pop_back();
+        }
+    }
+
+    std::vector<Position> points;
+    points.reserve(ys.size());
+    for (size_t index = 0; index < ys.size(); index++)
+    {
+        points.push_back(Position(int(ys[index]), int(xs[index])));
+    }
+    return points;
+}
+
+/**
+ * @brief Places the generator's cities on the land of a terrain and marks their cells as CITY.
+ * The spacing starts from the land area per city and shrinks until enough cities fit.
+ *
+ * @param terrain Flat terrain produced by generate_terrain.
+ * @return std::vector<City>: Generated cities.
+ * @throws std::runtime_error If the land cannot hold that many cities.
+ */
+std::vector<City> MapGenerator::generate_cities(Terrain &terrain) const
+{
+    std::vector<City> cities;
+    if (city_count <= 0)
+    {
+        return cities;
+    }
+    long long land = 0;
+    for (int y = 0; y < size.h; y++)
+    {
+        for (int x = 0; x < size.w; x++)
+        {
+            land += terrain.get(Position(y, x)) == TerrainType::LAND;
+        }
+    }
+
+    // NOTE: a spacing of at least sqrt(2) keeps every city in its own cell
+    std::vector<Position> sites;
+    for (double spacing = std::sqrt(0.6 * land / city_count);; spacing *= 0.9)
+    {
+        spacing = std::max(spacing, std::sqrt(2.0));
+        sites.clear();
+        for (auto &point : sample_disk(spacing))
+        {
+            if (terrain.get(point) == TerrainType::LAND)
+            {
+                sites.push_back(point);
+            }
+        }
+        if (sites.size() >= size_t(city_count))
+        {
+            break;
+        }
+        if (spacing <= std::sqrt(2.0))
+        {
+            throw std::runtime_error("Not enough land for " + std::to_string(city_count) + " cities");
+        }
+    }
+
+    std::mt19937 engine(seed ^ 0xc2b2ae35U);
+    std::shuffle(sites.begin(), sites.end(), engine); // Any subset keeps the minimum spacing
+    std::uniform_int_distribution<int> level(0, 2);
+    cities.reserve(city_count);
+    for (int index = 0; index < city_count; index++)
+    {
+        terrain.set(sites[index], TerrainType::CITY);
+        cities.push_back(City(sites[index], "City " + std::to_string(index + 1), 600 + 200 * level(engine)));
+    }
+    return cities;
+}
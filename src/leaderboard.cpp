@@ -0,0 +1,363 @@
+/**
+ * @file leaderboard.cpp
+ * @brief Implementation of the persistent leaderboard.
+ *
+ * Classes:
+ * - FileLock: Holds a `flock` on the leaderboard file for the duration of one call.
+ * - Leaderboard: Opens or creates the leaderboard file, inserts finished games into its
+ *   B+ tree and reads the best games of a level.
+ *
+ * Dependencies:
+ * - leaderboard.h: Declaration of LeaderRecord and Leaderboard.
+ * - POSIX file I/O (open, pread, pwrite, flock).
+ */
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include "leaderboard.h"
+
+/**
+ * @class FileLock
+ * @brief Locks a file with `flock` until it goes out of scope.
+ */
+class FileLock
+{
+private:
+    int fd;
+
+public:
+    /**
+     * @brief Waits for the lock.
+     *
+     * @param f Open file to lock.
+     * @param operation LOCK_EX or LOCK_SH.
+     * @throws std::runtime_error If the file cannot be locked.
+     */
+    FileLock(int f, int operation) : fd(f)
+    {
+        while (flock(fd, operation) < 0)
+        {
+            if (errno != EINTR)
+            {
+                throw std::runtime_error(std::string("Cannot lock leaderboard: ") + std::strerror(errno));
+            }
+        }
+    };
+    ~FileLock(void) { flock(fd, LOCK_UN); };
+    FileLock(const FileLock &) = delete;
+    FileLock &operator=(const FileLock &) = delete;
+};
+
+/**
+ * @brief Opens the leaderboard file, creating an empty tree if it does not exist yet.
+ *
+ * @param p Path of the file.
+ * @throws std::runtime_error If the file cannot be opened, or is not a leaderboard of this version.
+ */
+Leaderboard::Leaderboard(const std::string &p)
+    : fd(-1), path(p)
+{
+    static_assert(sizeof(LeaderRecord) == 32, "LeaderRecord must not be padded");
+    static_assert(sizeof(Node) <= PAGE_SIZE, "A node must fit in a page");
+
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+    }
+
+    try
+    {
+        FileLock lock(fd, LOCK_EX); // NOTE: another game may be creating the file too
+        struct stat info;
+        if (fstat(fd, &info) < 0)
+        {
+            throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno));
+        }
+        if (info.st_size == 0)
+        {
+            std::memcpy(header.magic, "CALB", 4);
+            header.version = VERSION;
+            header.root = 1;
+            header.pages = 2;
+            header.count = 0;
+            header.serial = 0;
+            Node root;
+            std::memset(&root, 0, sizeof(root));
+            root.is_leaf = 1;
+            write_node(1, root);
+            write_header();
+        }
+        else
+        {
+            read_header(header);
+        }
+    }
+    catch (...)
+    {
+        close(fd);
+        throw;
+    }
+}
+
+/**
+ * @brief Closes the file.
+ *
+ */
+Leaderboard::~Leaderboard(void)
+{
+    close(fd);
+}
+
+/**
+ * @brief Reads one page.
+ *
+ * @param page Page number.
+ * @param node Receives the page.
+ * @throws std::runtime_error If the page cannot be read.
+ */
+void Leaderboard::read_node(uint32_t page, Node &node) const
+{
+    if (pread(fd, &node, sizeof(node), off_t(page) * PAGE_SIZE) != ssize_t(sizeof(node)))
+    {
+        throw std::runtime_error("Corrupt leaderboard: " + path);
+    }
+}
+
+/**
+ * @brief Writes one page.
+ *
+ * @param page Page number.
+ * @param node Page to write.
+ * @throws std::runtime_error If the page cannot be written.
+ */
+void Leaderboard::write_node(uint32_t page, const Node &node)
+{
+    char buffer[PAGE_SIZE] = {};
+    std::memcpy(buffer, &node, sizeof(node));
+    if (pwrite(fd, buffer, PAGE_SIZE, off_t(page) * PAGE_SIZE) != PAGE_SIZE)
+    {
+        throw std::runtime_error("Cannot write leaderboard: " + path);
+    }
+}
+
+/**
+ * @brief Reads the header page, which other games may have changed since the last call.
+ *
+ * @param h Receives the header.
+ * @throws std::runtime_error If the file is not a leaderboard of this version.
+ */
+void Leaderboard::read_header(Header &h) const
+{
+    if (pread(fd, &h, sizeof(h), 0) != ssize_t(sizeof(h)) || std::memcmp(h.magic, "CALB", 4) != 0 || h.version != VERSION)
+    {
+        throw std::runtime_error("Not a leaderboard of this version: " + path);
+    }
+}
+
+/**
+ * @brief Writes the header page.
+ *
+ * @throws std::runtime_error If the header cannot be written.
+ */
+void Leaderboard::write_header(void)
+{
+    if (pwrite(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header)))
+    {
+        throw std::runtime_error("Cannot write leaderboard: " + path);
+    }
+}
+
+/**
+ * @brief Inserts a record below a page, splitting full pages on the way back up.
+ *
+ * @param page Page of the subtree.
+ * @param record Record to insert.
+ * @param split_key Receives the smallest key of the new right page, if the page split.
+ * @param split_page Receives the new right page, if the page split.
+ * @return bool: Whether the page split.
+ */
+bool Leaderboard::insert(uint32_t page, const LeaderRecord &record, Key &split_key, uint32_t &split_page)
+{
+    Node node;
+    read_node(page, node);
+    Key key = get_key(record);
+
+    if (node.is_leaf)
+    {
+        LeaderRecord *records = node.body.records;
+        int index = std::upper_bound(records, records + node.count, record,
+                                     [](const LeaderRecord &a, const LeaderRecord &b) { return get_key(a) < get_key(b); }) -
+                    records;
+        if (node.count < LEAF_CAPACITY)
+        {
+            std::copy_backward(records + index, records + node.count, records + node.count + 1);
+            records[index] = record;
+            node.count++;
+            write_node(page, node);
+            return false;
+        }
+
+        std::vector<LeaderRecord> all(records, records + node.count);
+        all.insert(all.begin() + index, record);
+        Node right;
+        std::memset(&right, 0, sizeof(right));
+        right.is_leaf = 1;
+        node.count = all.size() / 2;
+        right.count = all.size() - node.count;
+        std::copy(all.begin(), all.begin() + node.count, records);
+        std::copy(all.begin() + node.count, all.end(), right.body.records);
+        split_page = allocate();
+        right.next = node.next;
+        node.next = split_page;
+        split_key = get_key(right.body.records[0]);
+        write_node(split_page, right);
+        write_node(page, node);
+        return true;
+    }
+
+    Inner &inner = node.body.inner;
+    int index = std::upper_bound(inner.keys, inner.keys + node.count, key) - inner.keys;
+    Key child_key;
+    uint32_t child_page;
+    if (!insert(inner.children[index], record, child_key, child_page))
+    {
+        return false;
+    }
+    if (node.count < INNER_CAPACITY)
+    {
+        std::copy_backward(inner.keys + index, inner.keys + node.count, inner.keys + node.count + 1);
+        std::copy_backward(inner.children + index + 1, inner.children + node.count + 1, inner.children + node.count + 2);
+        inner.keys[index] = child_key;
+        inner.children[index + 1] = child_page;
+        node.count++;
+        write_node(page, node);
+        return false;
+    }
+
+    std::vector<Key> keys(inner.keys, inner.keys + node.count);
+    std::vector<uint32_t> children(inner.children, inner.children + node.count + 1);
+    keys.insert(keys.begin() + index, child_key);
+    children.insert(children.begin() + index + 1, child_page);
+    int middle = keys.size() / 2; // NOTE: the middle key moves up instead of staying in either half
+    Node right;
+    std::memset(&right, 0, sizeof(right));
+    node.count = middle;
+    right.count = keys.size() - middle - 1;
+    std::copy(keys.begin(), keys.begin() + middle, inner.keys);
+    std::copy(children.begin(), children.begin() + middle + 1, inner.children);
+    std::copy(keys.begin() + middle + 1, keys.end(), right.body.inner.keys);
+    std::copy(children.begin() + middle + 1, children.end(), right.body.inner.children);
+    split_key = keys[middle];
+    split_page = allocate();
+    write_node(split_page, right);
+    write_node(page, node);
+    return true;
+}
+
+/**
+ * @brief Counts the records in the file.
+ *
+ * @return uint32_t: Games recorded by every process sharing the file.
+ * @throws std::runtime_error If the file cannot be locked or read.
+ */
+uint32_t Leaderboard::size(void) const
+{
+    FileLock lock(fd, LOCK_SH);
+    Header current;
+    read_header(current);
+    return current.count;
+}
+
+/**
+ * @brief Records a finished game, growing the tree by a new root if the old one split.
+ *
+ * @param level Difficulty level.
+ * @param score Final score.
+ * @param turn Turns played.
+ * @param casualty Casualties.
+ * @param is_win Whether the enemy was defeated.
+ * @return LeaderRecord: The stored record, with its serial and time.
+ * @throws std::runtime_error If the file cannot be updated.
+ */
+LeaderRecord Leaderboard::insert(int level, int score, int turn, int casualty, bool is_win)
+{
+    FileLock lock(fd, LOCK_EX);
+    read_header(header);
+    LeaderRecord record = {level, score, turn, casualty, is_win ? 1 : 0, uint32_t(std::time(nullptr)), ++header.serial, 0};
+    Key split_key;
+    uint32_t split_page;
+    if (insert(header.root, record, split_key, split_page))
+    {
+        Node root;
+        std::memset(&root, 0, sizeof(root));
+        root.count = 1;
+        root.body.inner.keys[0] = split_key;
+        root.body.inner.children[0] = header.root;
+        root.body.inner.children[1] = split_page;
+        header.root = allocate();
+        write_node(header.root, root);
+    }
+    header.count++;
+    write_header();
+    return record;
+}
+
+/**
+ * @brief Reads the best games of a level: descends to the first record of the level,
+ * then follows the leaves.
+ *
+ * @param level Difficulty level.
+ * @param k Number of games wanted.
+ * @return std::vector<LeaderRecord>: Up to `k` records, best score first.
+ * @throws std::runtime_error If the file is corrupt.
+ */
+std::vector<LeaderRecord> Leaderboard::get_top(int level, int k) const
+{
+    FileLock lock(fd, LOCK_SH);
+    Header current;
+    read_header(current);
+    std::vector<LeaderRecord> top;
+    Key first = {level, INT32_MAX, 0}; // NOTE: serials start at 1, so this precedes every record of the level
+    Node node;
+    read_node(current.root, node);
+    while (!node.is_leaf)
+    {
+        const Inner &inner = node.body.inner;
+        int index = std::upper_bound(inner.keys, inner.keys + node.count, first) - inner.keys;
+        read_node(inner.children[index], node);
+    }
+
+    int index = std::upper_bound(node.body.records, node.body.records + node.count, first,
+                                 [](const Key &a, const LeaderRecord &b) { return a < get_key(b); }) -
+                node.body.records;
+    while (int(top.size()) < k)
+    {
+        if (index == node.count)
+        {
+            if (node.next == 0)
+            {
+                break;
+            }
+            read_node(node.next, node);
+            index = 0;
+            continue;
+        }
+        if (node.body.records[index].level != level)
+        {
+            break;
+        }
+        top.push_back(node.body.records[index++]);
+    }
+    return top;
+}
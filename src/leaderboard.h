@@ -0,0 +1,133 @@
+/**
+ * @file leaderboard.h
+ * @brief Persistent leaderboard of finished games, stored as an on-disk B+ tree
+ *
+ * Every finished game becomes one fixed-size LeaderRecord in "leaderboard.dat". The file
+ * is a B+ tree of 4 KiB pages ordered by difficulty level, then score from best to worst,
+ * then arrival order: page 0 is the header, leaves hold the records and link to their
+ * right neighbour. Inserting a record and finding the best K of a level each read and
+ * write O(log n) pages, plus K / 127 leaves for the query, so the file can hold millions
+ * of runs without slowing the menus down.
+ *
+ * Several games may share the file: every call locks it with `flock` (exclusive to insert,
+ * shared to read) and reads the header again under the lock, so nothing is cached between
+ * calls.
+ */
+
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/**
+ * @struct LeaderRecord
+ * @brief One finished game. Fixed layout, 32 bytes.
+ */
+struct LeaderRecord
+{
+    int32_t level;    ///< Difficulty level
+    int32_t score;    ///< Final score, after the game over bonus and penalty
+    int32_t turn;     ///< Turns played
+    int32_t casualty;
+    int32_t is_win;   ///< 1 if the enemy was defeated
+    uint32_t time;    ///< End of the game, seconds since the epoch
+    uint32_t serial;  ///< Arrival order, unique within the file
+    uint32_t reserved;
+};
+
+/**
+ * @class Leaderboard
+ * @brief B+ tree of LeaderRecord in a file, indexed by level and score.
+ */
+class Leaderboard
+{
+public:
+    static const uint32_t VERSION = 1;
+    static const int PAGE_SIZE = 4096;
+    static const int LEAF_CAPACITY = 127;  ///< Records per leaf page
+    static const int INNER_CAPACITY = 255; ///< Keys per inner page
+
+private:
+    /**
+     * @struct Key
+     * @brief Sort key of a record: level ascending, score descending, serial ascending.
+     */
+    struct Key
+    {
+        int32_t level;
+        int32_t score;
+        uint32_t serial;
+
+        bool operator<(const Key &k) const
+        {
+            return level != k.level ? level < k.level : score != k.score ? score > k.score : serial < k.serial;
+        }
+    };
+
+    /**
+     * @struct Inner
+     * @brief Body of an inner page: child i holds the keys below keys[i], which is the
+     * smallest key of child i + 1.
+     */
+    struct Inner
+    {
+        Key keys[INNER_CAPACITY];
+        uint32_t children[INNER_CAPACITY + 1];
+    };
+
+    /**
+     * @struct Node
+     * @brief One page of the tree.
+     */
+    struct Node
+    {
+        uint16_t is_leaf;
+        uint16_t count; ///< Records of a leaf, keys of an inner page
+        uint32_t next;  ///< Right neighbour of a leaf, 0 for the last one
+        union
+        {
+            LeaderRecord records[LEAF_CAPACITY];
+            Inner inner;
+        } body;
+    };
+
+    /**
+     * @struct Header
+     * @brief Page 0 of the file.
+     */
+    struct Header
+    {
+        char magic[4];   ///< "CALB"
+        uint32_t version;
+        uint32_t root;   ///< Page of the root node
+        uint32_t pages;  ///< Pages in the file, header included
+        uint32_t count;  ///< Records in the tree
+        uint32_t serial; ///< Serial of the last record
+    };
+
+    int fd;
+    std::string path;
+    Header header;
+
+    static Key get_key(const LeaderRecord &record) { return Key{record.level, record.score, record.serial}; };
+    void read_node(uint32_t page, Node &node) const;
+    void write_node(uint32_t page, const Node &node);
+    void read_header(Header &h) const;
+    void write_header(void);
+    uint32_t allocate(void) { return header.pages++; };
+    bool insert(uint32_t page, const LeaderRecord &record, Key &split_key, uint32_t &split_page);
+
+public:
+    Leaderboard(const std::string &p);
+    ~Leaderboard(void);
+    Leaderboard(const Leaderboard &) = delete;
+    Leaderboard &operator=(const Leaderboard &) = delete;
+
+    uint32_t size(void) const; ///< Records in the file
+    LeaderRecord insert(int level, int score, int turn, int casualty, bool is_win); ///< Record a finished game
+    std::vector<LeaderRecord> get_top(int level, int k) const;                      ///< Best `k` games of a level
+};
+
+#endif
@@ -7,7 +7,15 @@
  */
 
 #include <iostream>
+#include <fstream>
 #include <string>
+#include <vector>
+#include <deque>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <memory>
 #include <ncurses.h>
 #include <unistd.h>
 
@@ -15,6 +23,9 @@
 #include "menu.h"
 #include "render.h"
 #include "saver.h"
+#include "server.h"
+#include "coop.h"
+#include "script.h"
 #include "utils.h"
 
 /**
@@ -50,6 +61,42 @@ enum class Stage
     QUIT
 };
 
+/**
+ * @name Menu items
+ * @brief Items of the menus built in main(), in the order they are listed.
+ * @{
+ */
+enum StartItem
+{
+    START_GAME,
+    START_LOAD,
+    START_TUTORIAL,
+    START_QUIT
+};
+
+enum LevelItem ///< Items are also the difficulty level they start
+{
+    LEVEL_RETURN = 0,
+    LEVEL_EASY = 1,
+    LEVEL_NORMAL = 2,
+    LEVEL_HARD = 3
+};
+
+enum PauseItem
+{
+    PAUSE_RESUME,
+    PAUSE_RETURN,
+    PAUSE_SAVE,
+    PAUSE_QUIT
+};
+
+enum EndItem
+{
+    END_RETURN,
+    END_QUIT
+};
+/** @} */
+
 /**
  * @brief Initialize terminal interface settings
  * @details Configures ncurses environment with:
@@ -76,8 +123,62 @@ void init(void)
     init_pair(4, COLOR_WHITE, COLOR_GREEN);
 }
 
+/**
+ * @brief Reads the keys put back by a stage, then every key pressed since the last frame,
+ * up to a bound so a frame never stalls.
+ * @param pending Keys put back by unread_keys, taken first
+ * @return std::vector<int> Key codes in the order they were pressed, empty if none
+ */
+std::vector<int> read_keys(std::deque<int> &pending)
+{
+    const size_t limit = 256;
+    std::vector<int> keys;
+    while (!pending.empty() && keys.size() < limit)
+    {
+        keys.push_back(pending.front());
+        pending.pop_front();
+    }
+    while (keys.size() < limit)
+    {
+        int key = getch();
+        if (key == ERR)
+        {
+            break;
+        }
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+/**
+ * @brief Puts back the keys a stage did not use, so the next stage reads them in order.
+ * NOTE: kept in our own queue, as the ncurses one holds too few keys and drops the rest.
+ * @param pending Queue read_keys takes keys from first
+ * @param keys Keys returned by read_keys
+ * @param used Number of keys used, from the front
+ */
+void unread_keys(std::deque<int> &pending, const std::vector<int> &keys, size_t used)
+{
+    pending.insert(pending.begin(), keys.begin() + used, keys.end());
+}
+
+/**
+ * @brief Starts the telemetry file of a game just started or loaded, if "general.txt" asks for one.
+ * @param game Game to record
+ * @param asset_loader Loader that read "general.txt"
+ */
+void start_telemetry(Game &game, const AssetLoader &asset_loader)
+{
+    if (!asset_loader.get_telemetry().empty())
+    {
+        game.set_telemetry(std::unique_ptr<TelemetryWriter>(new TelemetryWriter(asset_loader.get_telemetry())));
+    }
+}
+
 /**
  * @brief Main game execution loop
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments
  * @return int Program exit status
  *
  * Manages complete game lifecycle including:
@@ -89,11 +190,247 @@ void init(void)
  * - Save/load operations
  *
  * Implements finite state machine pattern with menu-driven transitions.
+ *
+ * Command line options:
+ * - `--pack-map`: Convert background.txt into the chunked background.map and exit.
+ * - `--generate H W N [SEED]`: Generate an HxW map with N cities as the map assets and exit.
+ * - `--server SOCKET [WORKERS]`: Serve games to clients connecting to a UNIX socket.
+ * - `--broadcast SOCKET`: Play locally and let spectators watch through a UNIX socket.
+ * - `--host SOCKET [LEVEL]` / `--join SOCKET`: Play a two-player co-op game in lockstep.
+ * - `--script [FILE]`: Run the commands of FILE, or of stdin, without a terminal (see script.h).
  */
-int main(void)
+int main(int argc, char **argv)
 {
+    if (argc > 1 && std::string(argv[1]) == "--pack-map")
+    {
+        try
+        {
+            Game game = Game();
+            AssetLoader(game).pack_background();
+            std::cout << "background.map written" << '\n';
+            return 0;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+    if (argc > 1 && std::string(argv[1]) == "--generate")
+    {
+        if (argc < 5)
+        {
+            std::cerr << "Usage: " << argv[0] << " --generate HEIGHT WIDTH CITIES [SEED]" << '\n';
+            return 1;
+        }
+        try
+        {
+            Game game = Game();
+            uint32_t seed = argc > 5 ? std::stoul(argv[5]) : std::random_device()();
+            AssetLoader(game).generate_assets(Size(std::stoi(argv[2]), std::stoi(argv[3])), std::stoi(argv[4]), seed);
+            std::cout << "map assets generated with seed " << seed << '\n';
+            return 0;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--server")
+    {
+        if (argc < 3)
+        {
+            std::cerr << "Usage: " << argv[0] << " --server SOCKET [WORKERS]" << '\n';
+            return 1;
+        }
+        try
+        {
+            int workers = argc > 3 ? std::stoi(argv[3]) : std::max(1u, std::thread::hardware_concurrency());
+            FrameLayout layout = {Size(0, 0), Size(10, 30), {6, 6, 4, 4}}; // Same layout as the local GameRenderer
+            GameServer server(argv[2], workers, layout);
+            std::cout << "serving on " << argv[2] << " with " << workers << " workers" << '\n';
+            server.run();
+            return 0;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    if (argc > 1 && std::string(argv[1]) == "--script")
+    {
+        try
+        {
+            std::ifstream file;
+            if (argc > 2 && std::string(argv[2]) != "-")
+            {
+                file.open(argv[2]);
+                if (!file.is_open())
+                {
+                    std::cerr << "Cannot open " << argv[2] << '\n';
+                    return 1;
+                }
+            }
+            Game game = Game();
+            AssetLoader asset_loader = AssetLoader(game);
+            asset_loader.load_general();
+            ScriptRunner runner(game, asset_loader, std::cout);
+            runner.run(file.is_open() ? file : std::cin);
+            return 0;
+        }
+        catch (const std::exception &e)
+        {
+            std::cout.flush();
+            std::cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+
+    if (argc > 2 && (std::string(argv[1]) == "--host" || std::string(argv[1]) == "--join"))
+    {
+        bool is_host = std::string(argv[1]) == "--host";
+        try
+        {
+            Game game = Game();
+            AssetLoader asset_loader = AssetLoader(game);
+            asset_loader.load_general();
+            asset_loader.reset();
+            if (asset_loader.is_live_stats())
+            {
+                game.set_live_stats(std::unique_ptr<LiveStats>(new LiveStats(LiveStats::get_name(getpid()), true)));
+            }
+            OperationMenu operation_menu = OperationMenu(game);
+            TechMenu tech_menu = TechMenu(game.get_tech_tree(), "RETURN TO GAME");
+            std::cout << (is_host ? "waiting for the other player on " : "joining ") << argv[2] << '\n';
+            CoopSession session(argv[2], is_host, game, operation_menu, tech_menu);
+            session.start(argc > 3 ? std::stoi(argv[3]) : 1);
+            start_telemetry(game, asset_loader);
+
+            init();
+            GameRenderer game_renderer = GameRenderer(game, operation_menu, Size(10, 30), {6, 6, 4, 4});
+            TechMenuRenderer tech_menu_renderer = TechMenuRenderer(tech_menu, Size(10, 60), Size(10, 60));
+            Stage stage = Stage::GAME;
+            bool is_connected = true;
+            bool is_over = false;
+            std::deque<int> pending_keys; // NOTE: never refilled, the co-op loop uses every key it reads
+            game_renderer.init();
+            while (stage != Stage::QUIT)
+            {
+                for (int key : read_keys(pending_keys)) // NOTE: a stage change applies to the keys after it
+                {
+                    if (stage == Stage::QUIT)
+                    {
+                        break;
+                    }
+                    if (stage == Stage::GAME)
+                    {
+                        switch (session.handle_key(key))
+                        {
+                        case GameCommand::RESEARCH:
+                            stage = Stage::TECH_MENU;
+                            tech_menu_renderer.init();
+                            break;
+                        case GameCommand::QUIT:
+                            stage = Stage::QUIT;
+                            break;
+                        default:
+                            break;
+                        }
+                    }
+                    else
+                    {
+                        switch (key)
+                        {
+                        case 'w':
+                        case 'a':
+                        case 'q':
+                            tech_menu.move_cursor(-1);
+                            break;
+                        case 's':
+                        case 'd':
+                        case 'e':
+                            tech_menu.move_cursor(1);
+                            break;
+
+                        case '\n': // Enter key
+                            if (tech_menu.check_tech_node())
+                            {
+                                session.order_research(); // NOTE: starts on both sides at the end of the turn
+                            }
+                            else
+                            {
+                                stage = Stage::GAME;
+                                game_renderer.init();
+                            }
+                            break;
+
+                        case 'r':
+                            stage = Stage::GAME;
+                            game_renderer.init();
+                            break;
+
+                        case '\033': // ESC key
+                            stage = Stage::QUIT;
+                            break;
+                        }
+                    }
+                }
+
+                is_connected = session.receive();
+                is_over = game.check_game_over();
+                if (!is_connected || is_over)
+                {
+                    break;
+                }
+                operation_menu.update_items();
+                if (stage == Stage::GAME)
+                {
+                    game_renderer.draw();
+                    game_renderer.render();
+                }
+                else if (stage == Stage::TECH_MENU)
+                {
+                    tech_menu_renderer.draw();
+                    tech_menu_renderer.render();
+                }
+                usleep(10000);
+            }
+            endwin();
+
+            if (is_over)
+            {
+                std::cout << "GAME OVER  score " << game.get_score() << "  turn " << game.get_turn()
+                          << "  casualty " << game.get_casualty() << '\n';
+            }
+            else if (!is_connected)
+            {
+                std::cout << "the other player left" << '\n';
+            }
+            game.get_missile_manager().cancel_attack_wave();
+            game.get_missile_manager().cancel_forecast();
+            return 0;
+        }
+        catch (const std::exception &e)
+        {
+            endwin();
+            std::cerr << e.what() << '\n';
+            return 1;
+        }
+    }
+
     try
-    { // Initialize ncurses environment
+    {
+        std::unique_ptr<FrameBroadcaster> broadcaster;
+        if (argc > 2 && std::string(argv[1]) == "--broadcast")
+        {
+            broadcaster.reset(new FrameBroadcaster(argv[2]));
+        }
+
+        // Initialize ncurses environment
         init();
 
         // ----------------------------
@@ -119,6 +456,22 @@ int main(void)
         AssetLoader asset_loader = AssetLoader(game);
         GeneralChecker general_checker = GeneralChecker();
         asset_loader.load_general();
+        if (asset_loader.is_live_stats())
+        {
+            game.set_live_stats(std::unique_ptr<LiveStats>(new LiveStats(LiveStats::get_name(getpid()), true)));
+        }
+        int turns_per_second = asset_loader.get_realtime(); ///< Pace of the real-time mode, 0 to play turn by turn
+        std::deque<int> pending_keys; ///< Keys read but left to the next stage
+
+        std::unique_ptr<Leaderboard> leaderboard;
+        try
+        {
+            leaderboard.reset(new Leaderboard("leaderboard.dat"));
+        }
+        catch (const std::runtime_error &e)
+        {
+            // NOTE: the game is playable without a leaderboard, the menus say it is unavailable
+        }
 
         TitleVideo title_video = TitleVideo(asset_loader.load_video());
         TitleMenu title_menu = TitleMenu(asset_loader.load_title(), "PRESS ANY KEY TO START");
@@ -136,11 +489,13 @@ int main(void)
         TitleMenuRenderer title_menu_renderer = TitleMenuRenderer(title_menu, Size(10, 120));
         BasicMenuRenderer start_menu_renderer = BasicMenuRenderer(start_menu, Size(10, 30));
         BasicMenuRenderer level_menu_renderer = BasicMenuRenderer(level_menu, Size(10, 30));
-        BasicMenuRenderer pause_menu_renderer = BasicMenuRenderer(pause_menu, Size(10, 30));
+        PauseMenuRenderer pause_menu_renderer = PauseMenuRenderer(pause_menu, game, Size(10, 30));
         TutorialMenuRenderer tutorial_menu_renderer = TutorialMenuRenderer(tutorial_menu, Size(15, 50), Size(5, 50));
         SaveMenuRenderer save_menu_renderer = SaveMenuRenderer(save_menu, Size(10, 30));
         SaveMenuRenderer load_menu_renderer = SaveMenuRenderer(load_menu, Size(10, 30));
         EndMenuRenderer end_menu_renderer = EndMenuRenderer(game, end_menu, Size(10, 30), Size(5, 30));
+        LeaderboardRenderer start_leaderboard_renderer = LeaderboardRenderer(leaderboard.get(), Size(12, 30), Position(0, 33));
+        LeaderboardRenderer end_leaderboard_renderer = LeaderboardRenderer(leaderboard.get(), Size(10, 30), Position(0, 33));
         GameRenderer game_renderer = GameRenderer(game, operation_menu, Size(10, 30), {6, 6, 4, 4});
         TechMenuRenderer tech_menu_renderer = TechMenuRenderer(tech_menu, Size(10, 60), Size(10, 60));
 
@@ -151,15 +506,21 @@ int main(void)
                 title_video_renderer.init();
                 while (stage == Stage::TITLE_VIDEO)
                 {
-                    key = getch();
-                    if (key == '\033')
-                    {
-                        stage = Stage::QUIT;
-                    }
-                    else if (key != ERR)
+                    std::vector<int> keys = read_keys(pending_keys);
+                    size_t used = 0;
+                    while (used < keys.size() && stage == Stage::TITLE_VIDEO)
                     {
-                        stage = Stage::TITLE_MENU;
+                        key = keys[used++];
+                        if (key == '\033')
+                        {
+                            stage = Stage::QUIT;
+                        }
+                        else
+                        {
+                            stage = Stage::TITLE_MENU;
+                        }
                     }
+                    unread_keys(pending_keys, keys, used);
                     title_video_renderer.draw();
                     title_video_renderer.render();
                     if (!title_video.is_end())
@@ -178,19 +539,22 @@ int main(void)
                 title_menu_renderer.init();
                 while (stage == Stage::TITLE_MENU)
                 {
-                    key = getch();
-
-                    switch (key)
+                    std::vector<int> keys = read_keys(pending_keys);
+                    size_t used = 0;
+                    while (used < keys.size() && stage == Stage::TITLE_MENU)
                     {
-                    case '\033': // ESC key
-                        stage = Stage::QUIT;
-                        break;
-                    case ERR:
-                        break;
-                    default:
-                        stage = Stage::START_MENU;
-                        break;
+                        key = keys[used++];
+                        switch (key)
+                        {
+                        case '\033': // ESC key
+                            stage = Stage::QUIT;
+                            break;
+                        default:
+                            stage = Stage::START_MENU;
+                            break;
+                        }
                     }
+                    unread_keys(pending_keys, keys, used);
                     title_menu_renderer.draw();
                     title_menu_renderer.render();
                     usleep(10000);
@@ -199,53 +563,59 @@ int main(void)
             else if (stage == Stage::START_MENU)
             {
                 start_menu_renderer.init();
+                start_leaderboard_renderer.init();
                 while (stage == Stage::START_MENU)
                 {
-                    key = getch();
-                    switch (key)
+                    std::vector<int> keys = read_keys(pending_keys);
+                    size_t used = 0;
+                    while (used < keys.size() && stage == Stage::START_MENU)
                     {
-                    case 'w':
-                    case 'a':
-                    case 'q':
-                        start_menu.move_cursor(-1);
-                        break;
-                    case 's':
-                    case 'd':
-                    case 'e':
-                        start_menu.move_cursor(1);
-                        break;
-
-                    case '\n': // Enter key
-                        if (start_menu.get_item() == "START THE GAME")
+                        key = keys[used++];
+                        switch (key)
                         {
-                            if (general_checker.is_first_run())
+                        case 'w':
+                        case 'a':
+                        case 'q':
+                            start_menu.move_cursor(-1);
+                            break;
+                        case 's':
+                        case 'd':
+                        case 'e':
+                            start_menu.move_cursor(1);
+                            break;
+
+                        case '\n': // Enter key
+                            switch (start_menu.get_cursor())
                             {
+                            case START_GAME:
+                                if (general_checker.is_first_run())
+                                {
+                                    stage = Stage::TUTORIAL_MENU;
+                                    general_checker.save_lastrun();
+                                }
+                                else
+                                {
+                                    stage = Stage::LEVEL_MENU;
+                                }
+                                break;
+                            case START_LOAD:
+                                stage = Stage::LOAD_MENU;
+                                break;
+                            case START_TUTORIAL:
                                 stage = Stage::TUTORIAL_MENU;
-                                general_checker.save_lastrun();
-                            }
-                            else
-                            {
-                                stage = Stage::LEVEL_MENU;
+                                break;
+                            case START_QUIT:
+                                stage = Stage::QUIT;
+                                break;
                             }
-                        }
-                        else if (start_menu.get_item() == "LOAD  GAME")
-                        {
-                            stage = Stage::LOAD_MENU;
-                        }
-                        else if (start_menu.get_item() == "TUTORIAL")
-                        {
-                            stage = Stage::TUTORIAL_MENU;
-                        }
-                        else if (start_menu.get_item() == "QUIT")
-                        {
+                            break;
+
+                        case '\033': // ESC key
                             stage = Stage::QUIT;
+                            break;
                         }
-                        break;
-
-                    case '\033': // ESC key
-                        stage = Stage::QUIT;
-                        break;
                     }
+                    unread_keys(pending_keys, keys, used);
                     start_menu_renderer.draw();
                     start_menu_renderer.render();
                     usleep(10000); ///< Maintain 100FPS refresh rate
@@ -256,49 +626,48 @@ int main(void)
                 level_menu_renderer.init();
                 while (stage == Stage::LEVEL_MENU)
                 {
-                    key = getch();
-                    switch (key)
+                    std::vector<int> keys = read_keys(pending_keys);
+                    size_t used = 0;
+                    while (used < keys.size() && stage == Stage::LEVEL_MENU)
                     {
-                    case 'w':
-                    case 'a':
-                    case 'q':
-                        level_menu.move_cursor(-1);
-                        break;
-                    case 's':
-                    case 'd':
-                    case 'e':
-                        level_menu.move_cursor(1);
-                        break;
-
-                    case '\n': // Enter key
-                        if (level_menu.get_item() == "EASY")
-                        {
-                            asset_loader.reset();
-                            game.set_difficulty(1);
-                            stage = Stage::GAME;
-                        }
-                        else if (level_menu.get_item() == "NORMAL")
-                        {
-                            asset_loader.reset();
-                            game.set_difficulty(2);
-                            stage = Stage::GAME;
-                        }
-                        else if (level_menu.get_item() == "HARD")
-                        {
-                            asset_loader.reset();
-                            game.set_difficulty(3);
-                            stage = Stage::GAME;
-                        }
-                        else if (level_menu.get_item() == "RETURN TO MENU")
+                        key = keys[used++];
+                        switch (key)
                         {
-                            stage = Stage::START_MENU;
-                        }
-                        break;
+                        case 'w':
+                        case 'a':
+                        case 'q':
+                            level_menu.move_cursor(-1);
+                            break;
+                        case 's':
+                        case 'd':
+                        case 'e':
+                            level_menu.move_cursor(1);
+                            break;
 
-                    case '\033': // ESC key
-                        stage = Stage::QUIT;
-                        break;
+                        case '\n': // Enter key
+                            switch (level_menu.get_cursor())
+                            {
+                            case LEVEL_EASY:
+                            case LEVEL_NORMAL:
+                            case LEVEL_HARD:
+                                asset_loader.reset();
+                                game.set_difficulty(level_menu.get_cursor());
+                                start_telemetry(game, asset_loader);
+                                turns_per_second = asset_loader.get_realtime(); // NOTE: drop the pace set by + and - in the last game
+                                stage = Stage::GAME;
+                                break;
+                            case LEVEL_RETURN:
+                                stage = Stage::START_MENU;
+                                break;
+                            }
+                            break;
+
+                        case '\033': // ESC key
+                            stage = Stage::QUIT;
+                            break;
+                        }
                     }
+                    unread_keys(pending_keys, keys, used);
                     level_menu_renderer.draw();
                     level_menu_renderer.render();
                     usleep(10000);
@@ -309,47 +678,53 @@ int main(void)
                 tutorial_menu_renderer.init();
                 while (stage == Stage::TUTORIAL_MENU)
                 {
-                    key = getch();
-                    switch (key)
+                    std::vector<int> keys = read_keys(pending_keys);
+                    size_t used = 0;
+                    while (used < keys.size() && stage == Stage::TUTORIAL_MENU)
                     {
-                    case 'w':
-                        tutorial_menu.move_cursor(-1);
-                        break;
-                    case 'a':
-                    case 'q':
-                        tutorial_menu.prev_page();
-                        break;
-                    case 's':
-                        tutorial_menu.move_cursor(1);
-                        break;
-                    case 'd':
-                    case 'e':
-                        tutorial_menu.next_page();
-                        break;
-
-                    case '\n': // Enter key
-                        if (tutorial_menu.get_item() == "RETURN TO MENU")
-                        {
-                            stage = Stage::START_MENU;
-                        }
-                        else if (tutorial_menu.get_item() == "NEXT PAGE")
-                        {
-                            tutorial_menu.next_page();
-                        }
-                        else if (tutorial_menu.get_item() == "PREV PAGE")
+                        key = keys[used++];
+                        switch (key)
                         {
+                        case 'w':
+                            tutorial_menu.move_cursor(-1);
+                            break;
+                        case 'a':
+                        case 'q':
                             tutorial_menu.prev_page();
-                        }
-                        break;
+                            break;
+                        case 's':
+                            tutorial_menu.move_cursor(1);
+                            break;
+                        case 'd':
+                        case 'e':
+                            tutorial_menu.next_page();
+                            break;
 
-                    case 'p':
-                        stage = Stage::START_MENU;
-                        break;
+                        case '\n': // Enter key
+                            switch (tutorial_menu.get_cursor())
+                            {
+                            case TUTORIAL_RETURN:
+                                stage = Stage::START_MENU;
+                                break;
+                            case TUTORIAL_NEXT:
+                                tutorial_menu.next_page();
+                                break;
+                            case TUTORIAL_PREV:
+                                tutorial_menu.prev_page();
+                                break;
+                            }
+                            break;
 
-                    case '\033': // ESC key
-                        stage = Stage::QUIT;
-                        break;
+                        case 'p':
+                            stage = Stage::START_MENU;
+                            break;
+
+                        case '\033': // ESC key
+                            stage = Stage::QUIT;
+                            break;
+                        }
                     }
+                    unread_keys(pending_keys, keys, used);
                     tutorial_menu_renderer.draw();
                     tutorial_menu_renderer.render();
                     usleep(10000);
@@ -358,143 +733,99 @@ int main(void)
             else if (stage == Stage::GAME)
             {
                 game_renderer.init();
+                std::chrono::steady_clock::time_point last_frame = std::chrono::steady_clock::now();
+                double owed = 0; // NOTE: turns due in real time but not played yet, the fraction is drawn as motion
                 while (stage == Stage::GAME)
                 {
-                    key = getch();
-                    switch (key)
+                    std::vector<int> keys = read_keys(pending_keys);
+                    size_t used = 0;
+                    GameCommand command = operation_menu.handle_keys(keys, used);
+                    unread_keys(pending_keys, keys, used);
+                    switch (command)
                     {
-                    case 'w':
-                        game.move_cursor(Position(-1, 0));
+                    case GameCommand::RESEARCH:
+                        stage = Stage::TECH_MENU;
                         break;
-                    case 's':
-                        game.move_cursor(Position(1, 0));
+                    case GameCommand::PAUSE:
+                        stage = Stage::PAUSE_MENU;
                         break;
-                    case 'a':
-                        game.move_cursor(Position(0, -1));
+                    case GameCommand::FASTER:
+                        turns_per_second = std::min(Game::MAX_TURNS_PER_SECOND, std::max(1, turns_per_second * 2));
+                        game.insert_feedback("Real Time: " + std::to_string(turns_per_second) + " Turns per Second", COLOR_PAIR(4));
                         break;
-                    case 'd':
-                        game.move_cursor(Position(0, 1));
+                    case GameCommand::SLOWER:
+                        turns_per_second /= 2;
+                        game.insert_feedback(turns_per_second > 0 ? "Real Time: " + std::to_string(turns_per_second) + " Turns per Second"
+                                                                  : std::string("Real Time Off"),
+                                             COLOR_PAIR(4));
                         break;
-
-                    case 'q':
-                        operation_menu.move_cursor(-1);
+                    case GameCommand::QUIT:
+                        stage = Stage::QUIT;
                         break;
-                    case 'e':
-                        operation_menu.move_cursor(1);
+                    case GameCommand::NONE:
                         break;
+                    }
 
-                    case '\n': // Enter key
-                        if (operation_menu.get_item() == "RESEARCH")
-                        {
-                            stage = Stage::TECH_MENU;
-                        }
-                        else if (operation_menu.get_item() == "FIX")
-                        {
-                            game.fix_city();
-                        }
-                        else if (operation_menu.get_item() == "BUILD CRUISE")
-                        {
-                            game.build_cruise();
-                        }
-                        else if (operation_menu.get_item() == "LAUNCH CRUISE")
-                        {
-                            game.launch_cruise();
-                        }
-                        else if (operation_menu.get_item() == "BUILD STANDARD BOMB")
-                        {
-                            game.build_standard_bomb();
-                        }
-                        else if (operation_menu.get_item() == "LAUNCH STANDARD BOMB")
-                        {
-                            game.launch_standard_bomb();
-                        }
-                        else if (operation_menu.get_item() == "BUILD DIRTY BOMB")
-                        {
-                            game.build_dirty_bomb();
-                        }
-                        else if (operation_menu.get_item() == "LAUNCH DIRTY BOMB")
-                        {
-                            game.launch_dirty_bomb();
-                        }
-                        else if (operation_menu.get_item() == "BUILD HYDROGEN BOMB")
+                    // NOTE: in real time, every turn that fell due is played before the next frame is drawn;
+                    //       if playing them takes too long, frames are skipped, turns never are
+                    std::chrono::steady_clock::time_point frame_start = std::chrono::steady_clock::now();
+                    bool is_behind = false;
+                    if (turns_per_second > 0 && stage == Stage::GAME)
+                    {
+                        owed += std::chrono::duration<double>(frame_start - last_frame).count() * turns_per_second;
+                        while (owed >= 1 && !game.is_game_over())
                         {
-                            game.build_hydrogen_bomb();
+                            game.pass_turn();
+                            owed -= 1;
+                            if (std::chrono::steady_clock::now() - frame_start > std::chrono::milliseconds(100))
+                            {
+                                is_behind = owed >= 1; // Still draw a frame now and then to keep reading keys
+                                break;
+                            }
                         }
-                        else if (operation_menu.get_item() == "LAUNCH HYDROGEN BOMB")
+                    }
+                    else
+                    {
+                        owed = 0;
+                    }
+                    last_frame = frame_start;
+
+                    if (game.check_game_over())
+                    {
+                        if (broadcaster)
                         {
-                            game.launch_hydrogen_bomb();
+                            broadcaster->finish(game.get_score(), game.get_turn(), game.get_casualty());
                         }
-                        else if (operation_menu.get_item() == "ACTIVATE IRON CURTAIN")
+                        end_leaderboard_renderer.set_level(game.get_difficulty());
+                        end_leaderboard_renderer.set_highlight(0);
+                        if (leaderboard)
                         {
-                            game.activate_iron_curtain();
+                            try
+                            {
+                                LeaderRecord record = leaderboard->insert(game.get_difficulty(), game.get_score(), game.get_turn(),
+                                                                          game.get_casualty(), game.get_enemy_hp() <= 0);
+                                end_leaderboard_renderer.set_highlight(record.serial);
+                            }
+                            catch (const std::runtime_error &e)
+                            {
+                                // NOTE: the leaderboard then simply lacks this game
+                            }
                         }
-                        break;
-
-                    case '1':
-                        game.move_cursor_to_city(0);
-                        break;
-                    case '2':
-                        game.move_cursor_to_city(1);
-                        break;
-                    case '3':
-                        game.move_cursor_to_city(2);
-                        break;
-                    case '4':
-                        game.move_cursor_to_city(3);
-                        break;
-                    case '5':
-                        game.move_cursor_to_city(4);
-                        break;
-                    case '6':
-                        game.move_cursor_to_city(5);
-                        break;
-                    case '7':
-                        game.move_cursor_to_city(6);
-                        break;
-                    case '8':
-                        game.move_cursor_to_city(7);
-                        break;
-                    case '9':
-                        game.move_cursor_to_city(8);
-                        break;
-                    case '0':
-                        game.move_cursor_to_city(9);
-                        break;
-
-                    case ' ': // Space key
-                        game.pass_turn();
-                        break;
-                    case 'p':
-                        stage = Stage::PAUSE_MENU;
-                        break;
-
-                    // NOTE: keyboard shortcuts for common operations
-                    case 'r':
-                        stage = Stage::TECH_MENU;
-                        break;
-                    case 'f':
-                        game.fix_city();
-                        break;
-                    case 'b':
-                        game.build_cruise();
-                        break;
-                    case 'l':
-                        game.launch_cruise();
-                        break;
-
-                    case '\033': // ESC key
-                        stage = Stage::QUIT;
-                        break;
-                    }
-                    if (game.check_game_over())
-                    {
                         stage = Stage::END_MENU;
                         break;
                     }
                     operation_menu.update_items();
+                    game_renderer.set_blend(turns_per_second > 0 ? std::min(owed, 1.0) : 1);
                     game_renderer.draw();
                     game_renderer.render();
-                    usleep(10000);
+                    if (broadcaster)
+                    {
+                        broadcaster->publish(game_renderer.get_frame());
+                    }
+                    if (!is_behind)
+                    {
+                        usleep(10000);
+                    }
                 }
             }
             else if (stage == Stage::PAUSE_MENU)
@@ -502,47 +833,52 @@ int main(void)
                 pause_menu_renderer.init();
                 while (stage == Stage::PAUSE_MENU)
                 {
-                    key = getch();
-                    switch (key)
+                    std::vector<int> keys = read_keys(pending_keys);
+                    size_t used = 0;
+                    while (used < keys.size() && stage == Stage::PAUSE_MENU)
                     {
-                    case 'w':
-                    case 'a':
-                    case 'q':
-                        pause_menu.move_cursor(-1);
-                        break;
-                    case 's':
-                    case 'd':
-                    case 'e':
-                        pause_menu.move_cursor(1);
-                        break;
-
-                    case '\n': // Enter key
-                        if (pause_menu.get_item() == "RESUME")
+                        key = keys[used++];
+                        switch (key)
                         {
+                        case 'w':
+                        case 'a':
+                        case 'q':
+                            pause_menu.move_cursor(-1);
+                            break;
+                        case 's':
+                        case 'd':
+                        case 'e':
+                            pause_menu.move_cursor(1);
+                            break;
+
+                        case '\n': // Enter key
+                            switch (pause_menu.get_cursor())
+                            {
+                            case PAUSE_RESUME:
+                                stage = Stage::GAME;
+                                break;
+                            case PAUSE_RETURN:
+                                stage = Stage::START_MENU;
+                                break;
+                            case PAUSE_SAVE:
+                                stage = Stage::SAVE_MENU;
+                                break;
+                            case PAUSE_QUIT:
+                                stage = Stage::QUIT;
+                                break;
+                            }
+                            break;
+
+                        case 'p':
                             stage = Stage::GAME;
-                        }
-                        else if (pause_menu.get_item() == "RETURN TO MENU")
-                        {
-                            stage = Stage::START_MENU;
-                        }
-                        else if (pause_menu.get_item() == "SAVE GAME")
-                        {
-                            stage = Stage::SAVE_MENU;
-                        }
-                        else if (pause_menu.get_item() == "QUIT")
-                        {
+                            break;
+
+                        case '\033': // ESC key
                             stage = Stage::QUIT;
+                            break;
                         }
-                        break;
-
-                    case 'p':
-                        stage = Stage::GAME;
-                        break;
-
-                    case '\033': // ESC key
-                        stage = Stage::QUIT;
-                        break;
                     }
+                    unread_keys(pending_keys, keys, used);
                     pause_menu_renderer.draw();
                     pause_menu_renderer.render();
                     usleep(10000);
@@ -553,40 +889,46 @@ int main(void)
                 tech_menu_renderer.init();
                 while (stage == Stage::TECH_MENU)
                 {
-                    key = getch();
-                    switch (key)
+                    std::vector<int> keys = read_keys(pending_keys);
+                    size_t used = 0;
+                    while (used < keys.size() && stage == Stage::TECH_MENU)
                     {
-                    case 'w':
-                    case 'a':
-                    case 'q':
-                        tech_menu.move_cursor(-1);
-                        break;
-                    case 's':
-                    case 'd':
-                    case 'e':
-                        tech_menu.move_cursor(1);
-                        break;
-
-                    case '\n': // Enter key
-                        if (tech_menu.get_item() == "RETURN TO GAME")
-                        {
-                            stage = Stage::GAME;
-                        }
-                        else if (tech_menu.check_tech_node())
+                        key = keys[used++];
+                        switch (key)
                         {
-                            game.start_research(tech_menu.get_tech_node());
-                            game.check_research();
-                        }
-                        break;
+                        case 'w':
+                        case 'a':
+                        case 'q':
+                            tech_menu.move_cursor(-1);
+                            break;
+                        case 's':
+                        case 'd':
+                        case 'e':
+                            tech_menu.move_cursor(1);
+                            break;
 
-                    case 'r':
-                        stage = Stage::GAME;
-                        break;
+                        case '\n': // Enter key
+                            if (tech_menu.check_tech_node())
+                            {
+                                game.start_research(tech_menu.get_tech_node());
+                                game.check_research();
+                            }
+                            else
+                            {
+                                stage = Stage::GAME; // NOTE: the only other item is "RETURN TO GAME"
+                            }
+                            break;
 
-                    case '\033': // ESC key
-                        stage = Stage::QUIT;
-                        break;
+                        case 'r':
+                            stage = Stage::GAME;
+                            break;
+
+                        case '\033': // ESC key
+                            stage = Stage::QUIT;
+                            break;
+                        }
                     }
+                    unread_keys(pending_keys, keys, used);
                     tech_menu_renderer.draw();
                     tech_menu_renderer.render();
                     usleep(10000);
@@ -594,50 +936,42 @@ int main(void)
             }
             else if (stage == Stage::SAVE_MENU)
             {
+                save_menu.update_items(); // NOTE: slots only change when saving, which leaves the menu
                 save_menu_renderer.init();
                 while (stage == Stage::SAVE_MENU)
                 {
-                    key = getch();
-                    switch (key)
+                    std::vector<int> keys = read_keys(pending_keys);
+                    size_t used = 0;
+                    while (used < keys.size() && stage == Stage::SAVE_MENU)
                     {
-                    case 'w':
-                    case 'a':
-                    case 'q':
-                        save_menu.move_cursor(-1);
-                        break;
-                    case 's':
-                    case 'd':
-                    case 'e':
-                        save_menu.move_cursor(1);
-                        break;
-
-                    case '\n': // Enter key
-                        if (save_menu.get_item() == "SLOT 1 EMPTY" || save_menu.get_item() == "SLOT 1  FULL")
-                        {
-                            save_dumper.save_game("1");
-                            stage = Stage::PAUSE_MENU;
-                        }
-                        else if (save_menu.get_item() == "SLOT 2 EMPTY" || save_menu.get_item() == "SLOT 2  FULL")
-                        {
-                            save_dumper.save_game("2");
-                            stage = Stage::PAUSE_MENU;
-                        }
-                        else if (save_menu.get_item() == "SLOT 3 EMPTY" || save_menu.get_item() == "SLOT 3  FULL")
-                        {
-                            save_dumper.save_game("3");
-                            stage = Stage::PAUSE_MENU;
-                        }
-                        else if (save_menu.get_item() == "RETURN TO MENU")
+                        key = keys[used++];
+                        switch (key)
                         {
+                        case 'w':
+                        case 'a':
+                        case 'q':
+                            save_menu.move_cursor(-1);
+                            break;
+                        case 's':
+                        case 'd':
+                        case 'e':
+                            save_menu.move_cursor(1);
+                            break;
+
+                        case '\n': // Enter key
+                            if (save_menu.get_slot() != SLOT_RETURN)
+                            {
+                                save_dumper.save_game(std::to_string(save_menu.get_slot()));
+                            }
                             stage = Stage::PAUSE_MENU;
-                        }
-                        break;
+                            break;
 
-                    case '\033': // ESC key
-                        stage = Stage::QUIT;
-                        break;
+                        case '\033': // ESC key
+                            stage = Stage::QUIT;
+                            break;
+                        }
                     }
-                    save_menu.update_items();
+                    unread_keys(pending_keys, keys, used);
                     save_menu_renderer.draw();
                     save_menu_renderer.render();
                     usleep(10000);
@@ -645,56 +979,50 @@ int main(void)
             }
             else if (stage == Stage::LOAD_MENU)
             {
+                load_menu.update_items();
                 load_menu_renderer.init();
                 while (stage == Stage::LOAD_MENU)
                 {
-                    key = getch();
-                    switch (key)
+                    std::vector<int> keys = read_keys(pending_keys);
+                    size_t used = 0;
+                    while (used < keys.size() && stage == Stage::LOAD_MENU)
                     {
-                    case 'w':
-                    case 'a':
-                    case 'q':
-                        load_menu.move_cursor(-1);
-                        break;
-                    case 's':
-                    case 'd':
-                    case 'e':
-                        load_menu.move_cursor(1);
-                        break;
-
-                    case '\n': // Enter key
-                        if (load_menu.get_item() == "SLOT 1  FULL")
+                        key = keys[used++];
+                        switch (key)
                         {
-                            asset_loader.reset();
-                            save_loader.load_game("1");
-                            general_checker.save_lastrun();
-                            stage = Stage::GAME;
-                        }
-                        else if (load_menu.get_item() == "SLOT 2 FULL")
-                        {
-                            asset_loader.reset();
-                            save_loader.load_game("2");
-                            general_checker.save_lastrun();
-                            stage = Stage::GAME;
-                        }
-                        else if (load_menu.get_item() == "SLOT 3 FULL")
-                        {
-                            asset_loader.reset();
-                            save_loader.load_game("3");
-                            general_checker.save_lastrun();
-                            stage = Stage::GAME;
-                        }
-                        else if (load_menu.get_item() == "RETURN TO MENU")
-                        {
-                            stage = Stage::START_MENU;
-                        }
-                        break;
+                        case 'w':
+                        case 'a':
+                        case 'q':
+                            load_menu.move_cursor(-1);
+                            break;
+                        case 's':
+                        case 'd':
+                        case 'e':
+                            load_menu.move_cursor(1);
+                            break;
 
-                    case '\033': // ESC key
-                        stage = Stage::QUIT;
-                        break;
+                        case '\n': // Enter key
+                            if (load_menu.get_slot() == SLOT_RETURN)
+                            {
+                                stage = Stage::START_MENU;
+                            }
+                            else if (load_menu.is_slot_full())
+                            {
+                                asset_loader.reset();
+                                save_loader.load_game(std::to_string(load_menu.get_slot()));
+                                start_telemetry(game, asset_loader);
+                                turns_per_second = asset_loader.get_realtime();
+                                general_checker.save_lastrun();
+                                stage = Stage::GAME;
+                            }
+                            break;
+
+                        case '\033': // ESC key
+                            stage = Stage::QUIT;
+                            break;
+                        }
                     }
-                    load_menu.update_items();
+                    unread_keys(pending_keys, keys, used);
                     load_menu_renderer.draw();
                     load_menu_renderer.render();
                     usleep(10000);
@@ -703,37 +1031,45 @@ int main(void)
             else if (stage == Stage::END_MENU)
             {
                 end_menu_renderer.init();
+                end_leaderboard_renderer.init();
                 while (stage == Stage::END_MENU)
                 {
-                    key = getch();
-                    switch (key)
+                    std::vector<int> keys = read_keys(pending_keys);
+                    size_t used = 0;
+                    while (used < keys.size() && stage == Stage::END_MENU)
                     {
-                    case 'w':
-                    case 'a':
-                    case 'q':
-                        end_menu.move_cursor(-1);
-                        break;
-                    case 's':
-                    case 'd':
-                    case 'e':
-                        end_menu.move_cursor(1);
-                        break;
-
-                    case '\n': // Enter key
-                        if (end_menu.get_item() == "RETURN TO MENU")
-                        {
-                            stage = Stage::START_MENU;
-                        }
-                        else if (end_menu.get_item() == "QUIT")
+                        key = keys[used++];
+                        switch (key)
                         {
+                        case 'w':
+                        case 'a':
+                        case 'q':
+                            end_menu.move_cursor(-1);
+                            break;
+                        case 's':
+                        case 'd':
+                        case 'e':
+                            end_menu.move_cursor(1);
+                            break;
+
+                        case '\n': // Enter key
+                            switch (end_menu.get_cursor())
+                            {
+                            case END_RETURN:
+                                stage = Stage::START_MENU;
+                                break;
+                            case END_QUIT:
+                                stage = Stage::QUIT;
+                                break;
+                            }
+                            break;
+
+                        case '\033': // ESC key
                             stage = Stage::QUIT;
+                            break;
                         }
-                        break;
-
-                    case '\033': // ESC key
-                        stage = Stage::QUIT;
-                        break;
                     }
+                    unread_keys(pending_keys, keys, used);
                     end_menu_renderer.draw();
                     end_menu_renderer.render();
                     usleep(10000);
@@ -750,6 +1086,8 @@ int main(void)
         // ----------------------------
 
         endwin(); ///< Restore terminal settings
+        game.set_live_stats(std::unique_ptr<LiveStats>()); // NOTE: exit() skips destructors, remove the segment now
+        game.set_telemetry(std::unique_ptr<TelemetryWriter>()); // and flush the telemetry file
         exit(0);
     }
     catch (const std::exception &e)
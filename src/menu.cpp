@@ -22,6 +22,9 @@
  * Functions:
  * - move_cursor: Adjusts the cursor position within menu bounds.
  * - update_items: Updates menu items dynamically based on game state.
+ * - handle_key: Applies a key pressed during the game.
+ * - handle_keys: Applies the keys of a frame, coalescing cursor moves and turns.
+ * - get_item_id / select_item: Identify and select an operation independently of the shown list.
  * - get_item_description: Retrieves detailed descriptions for selected items.
  * - next_page: Advances to the next page in a multi-page menu.
  * - prev_page: Returns to the previous page in a multi-page menu.
@@ -139,7 +142,8 @@ void SaveMenu::update_items(void)
 LoadMenu::LoadMenu(const std::string &t, SaveLoader &sl)
     : BasicMenu(t, {}), save_loader(sl),
       all_items({"RETURN TO MENU", "SLOT 1 EMPTY", "SLOT 2 EMPTY", "SLOT 3 EMPTY",
-                 "SLOT 1  FULL", "SLOT 2  FULL", "SLOT 3  FULL"})
+                 "SLOT 1  FULL", "SLOT 2  FULL", "SLOT 3  FULL"}),
+      is_full({false})
 {
     items.push_back(all_items.at(0));
 }
@@ -151,53 +155,257 @@ LoadMenu::LoadMenu(const std::string &t, SaveLoader &sl)
 void LoadMenu::update_items(void)
 {
     items.erase(items.begin() + 1, items.end());
-    items.push_back(all_items.at(save_loader.is_slot_empty("1") ? 1 : 4));
-    items.push_back(all_items.at(save_loader.is_slot_empty("2") ? 2 : 5));
-    items.push_back(all_items.at(save_loader.is_slot_empty("3") ? 3 : 6));
+    is_full.erase(is_full.begin() + 1, is_full.end());
+    for (int slot = 1; slot <= 3; slot++)
+    {
+        is_full.push_back(!save_loader.is_slot_empty(std::to_string(slot)));
+        items.push_back(all_items.at(is_full.back() ? slot + 3 : slot));
+    }
 }
 
+const OperationMenu::Entry OperationMenu::entries[OPERATION_COUNT] = {
+    {"RESEARCH", nullptr},
+    {"FIX", &Game::fix_city},
+    {"BUILD CRUISE", &Game::build_cruise},
+    {"LAUNCH CRUISE", &Game::launch_cruise},
+    {"BUILD STANDARD BOMB", &Game::build_standard_bomb},
+    {"LAUNCH STANDARD BOMB", &Game::launch_standard_bomb},
+    {"BUILD DIRTY BOMB", &Game::build_dirty_bomb},
+    {"LAUNCH DIRTY BOMB", &Game::launch_dirty_bomb},
+    {"BUILD HYDROGEN BOMB", &Game::build_hydrogen_bomb},
+    {"LAUNCH HYDROGEN BOMB", &Game::launch_hydrogen_bomb},
+    {"ACTIVATE IRON CURTAIN", &Game::activate_iron_curtain},
+};
+
 /**
  * @brief Constructs an OperationMenu object with a reference to the game instance.
  *
  * @param g Reference to the Game instance
  */
 OperationMenu::OperationMenu(Game &g)
-    : ScrollMenu("Operation", {}, 9), game(g), // Initialize scroll parameters
-      all_items({"RESEARCH", "FIX", "BUILD CRUISE", "LAUNCH CRUISE", "BUILD STANDARD BOMB", "LAUNCH STANDARD BOMB",
-                 "BUILD DIRTY BOMB", "LAUNCH DIRTY BOMB", "BUILD HYDROGEN BOMB", "LAUNCH HYDROGEN BOMB", "ACTIVATE IRON CURTAIN"})
+    : ScrollMenu("Operation", {}, 9), game(g), unlocked(-1) // Initialize scroll parameters
 {
-    // Populate initial visible items (index 0-5)
-    for (int index = 0; index < 6; index++)
-    {
-        items.push_back(all_items.at(index));
-    }
+    update_items();
 }
 
 /**
  * @brief Synchronizes menu options with current research status.
  * Dynamically appends advanced commands when corresponding technologies become
- * available. Maintains core commands in fixed positions.
+ * available. Maintains core commands in fixed positions. The list is only rebuilt
+ * when one of the research flags it depends on has changed.
  */
 void OperationMenu::update_items(void)
 {
-    items.erase(items.begin() + 6, items.end());
+    int flags = (game.en_dirty_bomb ? 1 : 0) | (game.en_hydrogen_bomb ? 2 : 0) | (game.en_iron_curtain ? 4 : 0);
+    if (flags == unlocked)
+    {
+        return;
+    }
+    unlocked = flags;
+
+    // Core operations are always shown
+    shown.assign({OPERATION_RESEARCH, OPERATION_FIX, OPERATION_BUILD_CRUISE, OPERATION_LAUNCH_CRUISE,
+                  OPERATION_BUILD_STANDARD_BOMB, OPERATION_LAUNCH_STANDARD_BOMB});
     // Append dirty bomb operations when researched
     if (game.en_dirty_bomb)
     {
-        items.push_back(all_items.at(6)); // Build dirty bomb
-        items.push_back(all_items.at(7)); // Launch dirty bomb
+        shown.push_back(OPERATION_BUILD_DIRTY_BOMB);
+        shown.push_back(OPERATION_LAUNCH_DIRTY_BOMB);
     }
     // Append hydrogen bomb operations when researched
     if (game.en_hydrogen_bomb)
     {
-        items.push_back(all_items.at(8)); // Build hydrogen bomb
-        items.push_back(all_items.at(9)); // Launch hydrogen bomb
+        shown.push_back(OPERATION_BUILD_HYDROGEN_BOMB);
+        shown.push_back(OPERATION_LAUNCH_HYDROGEN_BOMB);
     }
     // Append iron curtain operation when researched
     if (game.en_iron_curtain)
     {
-        items.push_back(all_items.at(10)); // Activate iron curtain
+        shown.push_back(OPERATION_ACTIVATE_IRON_CURTAIN);
+    }
+
+    items.clear();
+    for (auto operation : shown)
+    {
+        items.push_back(entries[operation].label);
+    }
+    if (cursor >= int(items.size())) // NOTE: a new or loaded game may have fewer operations
+    {
+        cursor = 0;
+        offset = 0;
+    }
+}
+
+/**
+ * @brief Applies a key pressed during the game: cursor and menu movement, the selected
+ * operation, city quick-select, passing the turn and the operation shortcuts.
+ * Shared by the local game loop and by server sessions.
+ * @param key Key code as returned by getch()
+ * @return GameCommand Stage change the caller should perform
+ */
+GameCommand OperationMenu::handle_key(int key)
+{
+    switch (key)
+    {
+    case 'w':
+        game.move_cursor(Position(-1, 0));
+        break;
+    case 's':
+        game.move_cursor(Position(1, 0));
+        break;
+    case 'a':
+        game.move_cursor(Position(0, -1));
+        break;
+    case 'd':
+        game.move_cursor(Position(0, 1));
+        break;
+
+    case 'q':
+        move_cursor(-1);
+        break;
+    case 'e':
+        move_cursor(1);
+        break;
+
+    case '\n': // Enter key
+    {
+        const Entry &entry = entries[shown.at(cursor)];
+        if (entry.action == nullptr)
+        {
+            return GameCommand::RESEARCH;
+        }
+        (game.*entry.action)();
+        break;
+    }
+
+    case '1':
+    case '2':
+    case '3':
+    case '4':
+    case '5':
+    case '6':
+    case '7':
+    case '8':
+    case '9':
+        game.move_cursor_to_city(key - '1');
+        break;
+    case '0':
+        game.move_cursor_to_city(9);
+        break;
+
+    case ' ': // Space key
+        game.pass_turn();
+        break;
+    case 'p':
+        return GameCommand::PAUSE;
+    case '+':
+    case '=':
+        return GameCommand::FASTER;
+    case '-':
+        return GameCommand::SLOWER;
+
+    // NOTE: keyboard shortcuts for common operations
+    case 'r':
+        return GameCommand::RESEARCH;
+    case 'f':
+        game.fix_city();
+        break;
+    case 'b':
+        game.build_cruise();
+        break;
+    case 'l':
+        game.launch_cruise();
+        break;
+    case 'h':
+        game.toggle_heatmap();
+        break;
+
+    case '\033': // ESC key
+        return GameCommand::QUIT;
+    }
+    return GameCommand::NONE;
+}
+
+/**
+ * @brief Applies the keys of one frame. Runs of cursor moves become a single move_cursor
+ * and runs of space a single multi-turn advance, so a backlog of held keys costs one
+ * update instead of one frame per key. Other keys go through handle_key in order, after
+ * the moves and turns pressed before them.
+ * @param keys Key codes in the order they were pressed
+ * @param used Receives how many keys were applied: all of them, unless one changes the stage
+ * @return GameCommand Stage change the caller should perform
+ */
+GameCommand OperationMenu::handle_keys(const std::vector<int> &keys, size_t &used)
+{
+    Position target = game.get_cursor();
+    int turns = 0;
+    GameCommand command = GameCommand::NONE;
+    auto flush = [&](void)
+    {
+        if (!(target == game.get_cursor()))
+        {
+            game.move_cursor(target - game.get_cursor());
+        }
+        // NOTE: stop at game over, as pressing space once per frame would
+        for (; turns > 0 && !game.is_game_over(); turns--)
+        {
+            game.pass_turn();
+        }
+        turns = 0;
+    };
+    for (used = 0; used < keys.size() && command == GameCommand::NONE; used++)
+    {
+        Position step(0, 0);
+        switch (keys[used])
+        {
+        case 'w':
+            step = Position(-1, 0);
+            break;
+        case 's':
+            step = Position(1, 0);
+            break;
+        case 'a':
+            step = Position(0, -1);
+            break;
+        case 'd':
+            step = Position(0, 1);
+            break;
+        case ' ': // Space key
+            turns++;
+            continue;
+        default:
+            flush();
+            command = handle_key(keys[used]);
+            target = game.get_cursor();
+            continue;
+        }
+        if (game.is_in_map(target + step)) // NOTE: a step off the map is ignored on its own, as in move_cursor
+        {
+            target = target + step;
+        }
+    }
+    flush();
+    return command;
+}
+
+/**
+ * @brief Moves the cursor onto an operation, one step at a time so the scroll offset follows.
+ * @param id Index in the complete command list
+ * @return bool False if the operation is not shown, leaving the cursor unchanged
+ */
+bool OperationMenu::select_item(int id)
+{
+    auto found = std::find(shown.begin(), shown.end(), id);
+    if (found == shown.end())
+    {
+        return false;
+    }
+    int target = found - shown.begin();
+    while (cursor != target)
+    {
+        move_cursor(cursor < target ? 1 : -1);
     }
+    return true;
 }
 
 /**
@@ -293,7 +501,9 @@ TutorialMenu::TutorialMenu(void)
         "F                                         Fix City",
         "B                                     Build Cruise",
         "L                                    Launch Cruise",
-        "1-9                                   Select City"};
+        "H                                   Threat Heatmap",
+        "1-9                                   Select City",
+        "+/-                     Faster/Slower in Real Time"};
     std::vector<std::string> game_target_page = {
         "=================== GAME TARGET ==================",
         "manage your deposit and resources wisely          ",
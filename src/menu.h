@@ -75,7 +75,7 @@ public:
  */
 class ScrollMenu : public Menu
 {
-private:
+protected:
     int limit;  ///< Maximum visible items at once
     int offset; ///< Starting index of visible items
 
@@ -131,6 +131,15 @@ public:
     bool is_end(void) const { return index == frames.size() - 1; };
 };
 
+/**
+ * @enum SlotItem
+ * @brief Items of the save and load menus: every other item is the save slot of its number.
+ */
+enum SlotItem
+{
+    SLOT_RETURN = 0 ///< "RETURN TO MENU"
+};
+
 /**
  * @class SaveMenu
  * @brief Game save file management menu
@@ -147,6 +156,7 @@ private:
 public:
     SaveMenu(const std::string &t, SaveDumper &sd);
     void update_items(void);
+    int get_slot(void) const { return cursor; }; ///< Selected save slot, or SLOT_RETURN
 };
 
 
@@ -163,9 +173,49 @@ private:
     SaveLoader save_loader;
     std::vector<std::string> all_items;
 
+    std::vector<bool> is_full; ///< Whether each item is a saved game, as of the last update_items()
+
 public:
     LoadMenu(const std::string &t, SaveLoader &sl);
     void update_items(void);
+    int get_slot(void) const { return cursor; };                 ///< Selected save slot, or SLOT_RETURN
+    bool is_slot_full(void) const { return is_full.at(cursor); }; ///< Whether the selected slot can be loaded
+};
+
+/**
+ * @enum GameCommand
+ * @brief Stage change requested by a key pressed during the game.
+ */
+enum class GameCommand
+{
+    NONE,     ///< Stay in the game
+    RESEARCH, ///< Open the technology menu
+    PAUSE,    ///< Open the pause menu
+    FASTER,   ///< Play more turns per second in real time
+    SLOWER,   ///< Play fewer turns per second in real time
+    QUIT      ///< Leave the program
+};
+
+/**
+ * @enum Operation
+ * @brief Every operation of the operation menu, in the order they are listed.
+ *
+ * Co-op peers exchange these values, so new operations go at the end.
+ */
+enum Operation
+{
+    OPERATION_RESEARCH,
+    OPERATION_FIX,
+    OPERATION_BUILD_CRUISE,
+    OPERATION_LAUNCH_CRUISE,
+    OPERATION_BUILD_STANDARD_BOMB,
+    OPERATION_LAUNCH_STANDARD_BOMB,
+    OPERATION_BUILD_DIRTY_BOMB,
+    OPERATION_LAUNCH_DIRTY_BOMB,
+    OPERATION_BUILD_HYDROGEN_BOMB,
+    OPERATION_LAUNCH_HYDROGEN_BOMB,
+    OPERATION_ACTIVATE_IRON_CURTAIN,
+    OPERATION_COUNT
 };
 
 /**
@@ -178,8 +228,20 @@ public:
 class OperationMenu : public ScrollMenu
 {
 private:
-    Game &game;                         ///< Main game state reference
-    std::vector<std::string> all_items; ///< Complete command list
+    /**
+     * @struct Entry
+     * @brief Label and action of an operation.
+     */
+    struct Entry
+    {
+        const char *label;
+        void (Game::*action)(void); ///< Null for RESEARCH, which opens the tech menu instead
+    };
+    static const Entry entries[OPERATION_COUNT]; ///< Indexed by Operation
+
+    Game &game;                    ///< Main game state reference
+    std::vector<Operation> shown;  ///< Operation of each item
+    int unlocked;                  ///< Research flags the items were built for, -1 before the first build
 
 public:
     /**
@@ -193,6 +255,30 @@ public:
      * Synchronizes available commands with game context and player capabilities.
      */
     void update_items(void);
+    /**
+     * @brief Apply a key pressed during the game
+     * @param key Key code as returned by getch()
+     * @return GameCommand Stage change requested by the key
+     */
+    GameCommand handle_key(int key);
+    /**
+     * @brief Apply every key pressed since the last frame, with cursor moves and turns coalesced
+     * @param keys Key codes in the order they were pressed
+     * @param used Receives how many keys were applied; the rest belong to the next stage
+     * @return GameCommand Stage change requested by the last key applied
+     */
+    GameCommand handle_keys(const std::vector<int> &keys, size_t &used);
+    /**
+     * @brief Identify the selected operation independently of which are shown
+     * @return int Index of the selected item among all operations
+     */
+    int get_item_id(void) const { return shown.at(cursor); };
+    /**
+     * @brief Select an operation by the index returned by get_item_id
+     * @param id Index among all operations
+     * @return bool Whether the operation is currently shown and now selected
+     */
+    bool select_item(int id);
 };
 
 /**
@@ -222,6 +308,17 @@ public:
     /// @}
 };
 
+/**
+ * @enum TutorialItem
+ * @brief Items of the tutorial menu, in the order they are listed.
+ */
+enum TutorialItem
+{
+    TUTORIAL_NEXT,
+    TUTORIAL_PREV,
+    TUTORIAL_RETURN
+};
+
 /**
  * @class TutorialMenu
  * @brief Multi-page tutorial content viewer
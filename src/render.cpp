@@ -6,8 +6,6 @@
  * including windows, menus, and game states. It uses the ncurses library for terminal-based UI rendering.
  * 
  * Classes:
- * - Window: Represents a window in the terminal and provides methods to print text and manage attributes.
- * - Renderer: Provides debugging functionalities for rendering.
  * - BasicMenuRenderer: Handles rendering of basic menus with items and titles.
  * - TitleMenuRenderer: Manages rendering of title menus with left-aligned and centered items.
  * - SaveMenuRenderer: Renders the save menu interface with warnings.
@@ -15,9 +13,11 @@
  * - TutorialMenuRenderer: Renders a tutorial menu with pages and items.
  * - TechMenuRenderer: Handles rendering of technology menus with descriptions.
  * - GameRenderer: Manages and renders the entire game interface, including map, information, and operations.
+ * - Frame: Captures the game screen, kept here so the frame codec needs no Game.
  * 
  * Dependencies:
  * - ncurses library for terminal-based UI rendering.
+ * - screen.h: Windows and the FrameRenderer the game screen is painted with.
  * - Various game-related classes such as Game, Menu, and Position.
  * 
  * Key Features:
@@ -30,6 +30,7 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <sstream>
 #include <fstream>
 #include <iomanip>
@@ -41,219 +42,6 @@
 
 #define ALL_SIZE Size(LINES, COLS)
 
-/**
-* @brief Constructor for the Window class.
-*
-* @param win The parent window.
-* @param s The size of the window.
-* @param p The position of the window.
-*
-*/
-
-Window::Window(WINDOW *win, Size s, Position p) : size(s), pos(p)
-{
-    window = subwin(win, s.h, s.w, p.y, p.x);
-}
-
-/**
- * @brief Constructor for the Window class.
- * 
- * @param win The parent window.
- * @param s The size of the window.
- * @param p The position of the window.
- * 
- */
-
-Window::Window(Window &win, Size s, Position p) : size(s), pos(p)
-{
-    window = subwin(win.window, s.h, s.w, p.y, p.x);
-}
-
-/**
- * @brief Prints a character with specified attributes at a given position within the window.
- * 
- * This function places a character (`ch`) at the specified position (`p`) in the window,
- * applying the given attributes (`attr`). If the position is outside the bounds of the
- * window, the function returns without performing any action.
- * 
- * @param p The position (x, y) where the character should be printed. 
- *          It is represented as a `Position` object.
- * @param ch The character to be printed, represented as a `chtype`.
- * @param attr The attributes to be applied to the character, represented as an `attr_t`.
- *             Attributes can include color, bold, underline, etc.
- */
-void Window::print(Position p, chtype ch, attr_t attr)
-{
-    if (p.y >= size.h || p.x >= size.w)
-    {
-        return;
-    }
-    wattron(window, attr);
-    mvwaddch(window, p.y, p.x, ch);
-    wattroff(window, attr);
-}
-
-/**
- * @brief Prints a string with specified attributes at a given position within the window.
- * 
- * This function places a string (`s`) at the specified position (`p`) in the window,
- * applying the given attributes (`attr`). If the position is outside the bounds of the
- * window, the function returns without performing any action.
- * 
- * @param p The position (x, y) where the string should be printed. 
- *          It is represented as a `Position` object.
- * @param s The string to be printed, represented as a `const char*`.
- * @param attr The attributes to be applied to the string, represented as an `attr_t`.
- *             Attributes can include color, bold, underline, etc.
- */
-void Window::print(Position p, const char *s, attr_t attr)
-{
-    if (p.y >= size.h || p.x >= size.w)
-    {
-        return;
-    }
-    wattron(window, attr);
-    mvwprintw(window, p.y, p.x, "%s", s);
-    wattroff(window, attr);
-}
-
-
-/**
- * @brief Prints a line of spaces with the specified attributes in a window.
- * 
- * This function fills an entire line of the window with spaces, starting from
- * the beginning of the line (column 0) and extending to the width of the window.
- * The spaces are printed with the specified text attributes.
- * 
- * @param line The line number (row) in the window where the spaces will be printed.
- *             If the line number is greater than or equal to the height of the window,
- *             the function returns without performing any action.
- * @param attr The text attributes to be applied to the spaces (e.g., color, bold).
- *             These attributes are applied using `wattron` and removed using `wattroff`.
- */
-void Window::print_spaces(int line, attr_t attr)
-{
-    if (line >= size.h)
-    {
-        return;
-    }
-    wattron(window, attr);
-    mvwprintw(window, line, 0, "%s", std::string(size.w, ' ').c_str());
-    wattroff(window, attr);
-}
-
-/**
- * @brief Prints a string aligned to the left at a specified line in the window.
- * 
- * This function displays a string `s` starting from the leftmost position of the specified
- * line in the window. If the string exceeds the width of the window, it is truncated to fit.
- * The specified attributes `attr` are applied to the string while rendering.
- * 
- * @param line The line number (0-based index) where the string will be printed.
- *             If the line number exceeds the height of the window, the function returns without printing.
- * @param s The string to be printed.
- * @param attr The attributes to be applied to the string (e.g., color, bold, etc.).
- */
-void Window::print_left(int line, const std::string &s, attr_t attr)
-{
-    if (line >= size.h)
-    {
-        return;
-    }
-    wattron(window, attr);
-    mvwprintw(window, line, 0, "%s", s.c_str());
-    if (s.length() > size.w)
-    {
-        mvwprintw(window, line, 0, "%s", s.substr(0, size.w - 1).c_str());
-    }
-    else
-    {
-        mvwprintw(window, line, 0, "%s", s.c_str());
-    }
-    wattroff(window, attr);
-}
-
-/**
- * @brief Prints a string centered on a specified line within the window.
- *
- * This function centers a given string on a specified line of the window.
- * If the string is longer than the window's width, it truncates the string
- * to fit within the window. The text is displayed with the specified
- * attributes.
- *
- * @param line The line number (0-based index) where the string will be printed.
- *             If the line number exceeds the window's height, the function
- *             returns without performing any action.
- * @param s The string to be printed.
- * @param attr The text attributes to be applied (e.g., bold, underline).
- */
-void Window::print_center(int line, const std::string &s, attr_t attr)
-{
-    if (line >= size.h)
-    {
-        return;
-    }
-    wattron(window, attr);
-    mvwprintw(window, line, (size.w - s.length()) / 2, "%s", s.c_str());
-    if (s.length() > size.w)
-    {
-        mvwprintw(window, line, 0, "%s", s.substr(0, size.w - 1).c_str());
-    }
-    else
-    {
-        mvwprintw(window, line, (size.w - s.length()) / 2, "%s", s.c_str());
-    }
-    wattroff(window, attr);
-}
-
-/**
- * @brief Prints a string aligned to the right on a specified line within the window.
- * 
- * This function displays a string on a specified line of the window, aligning it to the right.
- * If the string is longer than the window's width, it will be truncated to fit.
- * The specified attributes are applied to the text during rendering.
- * 
- * @param line The line number (0-based index) where the string will be printed.
- *             If the line number exceeds the window's height, the function returns without action.
- * @param s The string to be printed. If its length exceeds the window's width, it will be truncated.
- * @param attr The text attributes to be applied (e.g., color, bold, etc.).
- */
-void Window::print_right(int line, const std::string &s, attr_t attr)
-{
-    if (line >= size.h)
-    {
-        return;
-    }
-
-    wattron(window, attr);
-    if (s.length() > size.w)
-    {
-        mvwprintw(window, line, 0, "%s", s.substr(0, size.w - 1).c_str());
-    }
-    else
-    {
-        mvwprintw(window, line, size.w - s.length(), "%s", s.c_str());
-    }
-    mvwprintw(window, line, size.w - s.length(), "%s", s.c_str());
-    wattroff(window, attr);
-}
-
-/**
- * @brief Displays a debug message on the screen at a specified line.
- * 
- * This function uses the `mvwprintw` function to print a string to the 
- * standard screen (`stdscr`) at the specified line number. It is useful 
- * for debugging purposes to display messages during program execution.
- * 
- * @param str The debug message to be displayed.
- * @param line The line number on the screen where the message will be printed.
- */
-void Renderer::debug(const std::string &str, int line)
-{
-    mvwprintw(stdscr, line, 1, "%s", str.c_str());
-}
-
-
 /**
  * @brief Constructs a BasicMenuRenderer object to render a menu with specified size.
  * 
@@ -314,6 +102,83 @@ void BasicMenuRenderer::draw(void)
     }
 }
 
+/**
+ * @brief Prints one line of charts: a label, a sparkline of a series and a value.
+ *
+ * @param window Window to print in.
+ * @param line Line of the window.
+ * @param width Width of the window.
+ * @param label Name of the series, up to 8 characters.
+ * @param series Statistics of the game.
+ * @param column Series to chart.
+ * @param value Text shown right-aligned after the chart.
+ */
+static void print_sparkline(Window &window, int line, int width, const std::string &label,
+                            const TurnSeries &series, SeriesColumn column, const std::string &value)
+{
+    static const char *const blocks[] = {"\u2581", "\u2582", "\u2583", "\u2584", "\u2585", "\u2586", "\u2587", "\u2588"};
+    const int chart_x = 9;
+    std::vector<int32_t> points = series.downsample(column, width - chart_x - 7);
+    window.print_left(line, label);
+    window.print_right(line, value);
+    if (points.empty())
+    {
+        return;
+    }
+
+    auto bounds = std::minmax_element(points.begin(), points.end());
+    int32_t low = *bounds.first;
+    int32_t high = *bounds.second;
+    std::string chart;
+    for (auto point : points)
+    {
+        chart += blocks[high > low ? int64_t(point - low) * 7 / (high - low) : 0];
+    }
+    window.print(Position(line, chart_x), chart, COLOR_PAIR(4));
+}
+
+/**
+ * @brief Prints the charts of deposit, city hitpoints, missiles in flight and intercept rate.
+ *
+ * @param window Window to print in, at least 4 lines high.
+ * @param line First line of the charts.
+ * @param width Width of the window.
+ * @param game Game whose series are charted.
+ */
+static void print_series(Window &window, int line, int width, const Game &game)
+{
+    const TurnSeries &series = game.get_series();
+    print_sparkline(window, line, width, "Deposit", series, SERIES_DEPOSIT, std::to_string(series.back(SERIES_DEPOSIT)));
+    print_sparkline(window, line + 1, width, "City HP", series, SERIES_CITY_HP, std::to_string(series.back(SERIES_CITY_HP)));
+    print_sparkline(window, line + 2, width, "Missile", series, SERIES_MISSILES, std::to_string(series.back(SERIES_MISSILES)));
+    print_sparkline(window, line + 3, width, "Shot", series, SERIES_INTERCEPT, std::to_string(series.back(SERIES_INTERCEPT) / 10) + "%");
+}
+
+/**
+ * @brief Constructs the pause menu renderer with a statistics box below the menu box.
+ *
+ * @param m Reference to the pause menu.
+ * @param g Reference to the game, for its statistics.
+ * @param s Size of the item window within the menu.
+ */
+PauseMenuRenderer::PauseMenuRenderer(Menu &m, Game &g, Size s)
+    : BasicMenuRenderer(m, s), game(g),
+      stats_box_window(Window(stdscr, Size(6, s.w + 2), pos + Size(s.h + 2, 0))),
+      stats_window(Window(stats_box_window, Size(4, s.w), pos + Size(s.h + 3, 1)))
+{
+}
+
+/**
+ * @brief Draws the menu box and the charts of every turn played so far.
+ */
+void PauseMenuRenderer::init(void)
+{
+    BasicMenuRenderer::init();
+    stats_box_window.draw_margin();
+    stats_box_window.print_center(0, std::string("STATISTICS"));
+    print_series(stats_window, 0, size.w, game);
+}
+
 /**
  * @brief Constructs a VideoRenderer object to render a title video within a specified size and position.
  * 
@@ -532,6 +397,11 @@ void EndMenuRenderer::init(void)
 
     desc_window.print_left(3, "Turn:", A_NORMAL);
     desc_window.print_right(3, std::to_string(game.get_turn()), A_NORMAL);
+
+    print_series(desc_window, 5, desc_size.w, game);
+    int resolved = game.get_intercepted_total() + game.get_landed_total();
+    desc_window.print_left(9, "Shot down:", A_NORMAL);
+    desc_window.print_right(9, std::to_string(game.get_intercepted_total()) + "/" + std::to_string(resolved), A_NORMAL);
 }
 
 void EndMenuRenderer::render(void)
@@ -563,6 +433,84 @@ void EndMenuRenderer::draw(void)
     }
 }
 
+/**
+ * @brief Constructs a leaderboard box, centred on the screen and then shifted.
+ *
+ * @param l Leaderboard to list, may be null.
+ * @param s Size of the list within the box.
+ * @param shift Offset from the centre, to place the box beside a menu.
+ */
+LeaderboardRenderer::LeaderboardRenderer(Leaderboard *l, Size s, Position shift)
+    : leaderboard(l), level(0), highlight(0), size(s), pos((ALL_SIZE - s - Size(2, 2)) / 2 + shift),
+      box_window(Window(stdscr, s + Size(2, 2), pos)),
+      list_window(Window(box_window, s, pos + Size(1, 1)))
+{
+}
+
+/**
+ * @brief Draws the box and the list.
+ */
+void LeaderboardRenderer::init(void)
+{
+    box_window.draw_margin();
+    box_window.print_center(0, std::string(level ? "LEADERBOARD" : "BEST GAMES"));
+    draw();
+}
+
+/**
+ * @brief Refreshes the list.
+ */
+void LeaderboardRenderer::render(void)
+{
+    list_window.refresh();
+}
+
+/**
+ * @brief Reads the best games and lists them: rank, score, turns and outcome. With every
+ * level, each level gets an equal share of the lines under its name.
+ */
+void LeaderboardRenderer::draw(void)
+{
+    static const char *const level_names[] = {"EASY", "NORMAL", "HARD"};
+    list_window.erase();
+    if (leaderboard == nullptr)
+    {
+        list_window.print_center(0, std::string("No leaderboard"));
+        return;
+    }
+
+    try
+    {
+        int line = 0;
+        for (int lv = (level ? level : 1); lv <= (level ? level : 3); lv++)
+        {
+            int rows = level ? size.h : size.h / 3 - 1;
+            if (!level)
+            {
+                list_window.print_center(line++, level_names[lv - 1], A_BOLD);
+            }
+            std::vector<LeaderRecord> top = leaderboard->get_top(lv, rows);
+            if (top.empty())
+            {
+                list_window.print_center(line, std::string("No games yet"));
+            }
+            for (size_t rank = 0; rank < top.size(); rank++)
+            {
+                std::ostringstream oss;
+                oss << std::setw(2) << rank + 1 << ". " << std::setw(7) << top[rank].score << "  turn "
+                    << std::setw(4) << top[rank].turn << "  " << (top[rank].is_win ? "WIN " : "LOSE");
+                list_window.print(Position(line + rank, 0), oss.str(), top[rank].serial == highlight ? A_REVERSE : A_NORMAL);
+            }
+            line += rows;
+        }
+    }
+    catch (const std::runtime_error &e)
+    {
+        list_window.erase();
+        list_window.print_center(0, std::string("Leaderboard unreadable"));
+    }
+}
+
 /**
  * @brief Constructs a TutorialMenuRenderer object to render a tutorial menu.
  * 
@@ -722,114 +670,10 @@ void TechMenuRenderer::draw(void)
  * @param fs Vector of integers specifying the heights of various information windows.
  */
 GameRenderer::GameRenderer(Game &g, OperationMenu &m, Size s, const std::vector<int> &fs)
-    : game(g), menu(m), fields(fs),
-      map_size(game.get_size()), info_size(map_size.h + s.h + 1, s.w),
-      operation_size(s.h, map_size.w / 3),
-      feedback_size(s.h, map_size.w - map_size.w / 3 - 1),
-      pos((ALL_SIZE - map_size - s - Size(3, 3)) / 2),
-      box_window(stdscr, map_size + s + Size(3, 3), pos),
-      map_window(box_window, map_size, pos + Size(1, 1)),
-      info_window(box_window, info_size, pos + Size(1, map_size.x + 2)),
-      general_info_window(box_window, Size(fs.at(0), info_size.w), pos + Size(1, map_size.x + 2)),
-      selected_info_window(box_window, Size(fs.at(1), info_size.w), pos + Size(fs.at(0) + 2, map_size.x + 2)),
-      tech_info_window(box_window, Size(fs.at(2), info_size.w), pos + Size(fs.at(0) + fs.at(1) + 3, map_size.x + 2)),
-      super_weapon_info_window(box_window, Size(fs.at(3), info_size.w), pos + Size(fs.at(0) + fs.at(1) + fs.at(2) + 4, map_size.x + 2)),
-      operation_window(box_window, operation_size, pos + Size(map_size.y + 2, 1)),
-      feedback_window(box_window, feedback_size, pos + Size(map_size.y + 2, operation_size.x + 2))
+    : FrameRenderer(FrameLayout{g.get_view_size(), s, fs}), game(g), menu(m), blend(1)
 {
 }
 
-/**
- * @brief Initializes the game renderer by setting up the layout and drawing the UI components.
- * 
- * This function erases the current screen and draws the necessary UI elements, including margins, 
- * horizontal and vertical lines, and various labeled sections for the game interface. It also 
- * places specific characters at intersections and prints labels for different sections of the UI.
- * 
- * The layout is divided into the following sections:
- * - Map
- * - General Information
- * - City & Missile
- * - Technology & Research
- * - Super Weapon
- * - Operation and Feedback
- * 
- * The function uses the `box_window` object to draw the UI components and relies on the dimensions 
- * provided by `map_size`, `info_size`, `operation_size`, and `fields` to determine the positions 
- * of the elements.
- * 
- * @note The function assumes that the `fields` vector contains at least three elements, which 
- *       represent the heights of the "City & Missile", "Technology & Research", and "Super Weapon" 
- *       sections, respectively.
- */
-void GameRenderer::init(void)
-{
-    erase();
-
-    box_window.draw_margin();
-    box_window.draw_hline(Position(map_size.h + 1, 1), map_size.w);
-    box_window.draw_vline(Position(1, map_size.w + 1), info_size.h);
-    box_window.draw_vline(Position(map_size.h + 2, operation_size.w + 1), operation_size.h);
-    box_window.draw_hline(Position(fields.at(0) + 1, map_size.w + 2), info_size.w);
-    box_window.draw_hline(Position(fields.at(0) + fields.at(1) + 2, map_size.w + 2), info_size.w);
-    box_window.draw_hline(Position(fields.at(0) + fields.at(1) + fields.at(2) + 3, map_size.w + 2), info_size.w);
-
-    box_window.draw_char(Position(map_size.h + 1, 0), ACS_LTEE);
-    box_window.draw_char(Position(map_size.h + 1, map_size.w + 1), ACS_RTEE);
-    box_window.draw_char(Position(0, map_size.w + 1), ACS_TTEE);
-    box_window.draw_char(Position(info_size.h + 1, map_size.w + 1), ACS_BTEE);
-    box_window.draw_char(Position(map_size.h + 1, operation_size.w + 1), ACS_TTEE);
-    box_window.draw_char(Position(map_size.h + operation_size.h + 2, operation_size.w + 1), ACS_BTEE);
-
-    box_window.draw_char(Position(fields.at(0) + 1, map_size.w + 1), ACS_LTEE);
-    box_window.draw_char(Position(fields.at(0) + 1, map_size.w + info_size.w + 2), ACS_RTEE);
-    box_window.draw_char(Position(fields.at(0) + fields.at(1) + 2, map_size.w + 1), ACS_LTEE);
-    box_window.draw_char(Position(fields.at(0) + fields.at(1) + 2, map_size.w + info_size.w + 2), ACS_RTEE);
-    if (fields.at(0) + fields.at(1) + fields.at(2) + 3 == map_size.h + 1)
-    {
-        box_window.draw_char(Position(fields.at(0) + fields.at(1) + fields.at(2) + 3, map_size.w + 1), ACS_PLUS);
-    }
-    else
-    {
-        box_window.draw_char(Position(fields.at(0) + fields.at(1) + fields.at(2) + 3, map_size.w + 1), ACS_LTEE);
-    }
-    box_window.draw_char(Position(fields.at(0) + fields.at(1) + fields.at(2) + 3, map_size.w + info_size.w + 2), ACS_RTEE);
-
-    box_window.print(Position(0, 2), "Map");
-    box_window.print(Position(0, map_size.w + 3), "General");
-    box_window.print(Position(fields.at(0) + 1, map_size.w + 3), "City & Missile");
-    box_window.print(Position(fields.at(0) + fields.at(1) + 2, map_size.w + 3), "Technology & Research");
-    box_window.print(Position(fields.at(0) + fields.at(1) + fields.at(2) + 3, map_size.w + 3), "Super Weapon");
-    box_window.print(Position(map_size.h + 1, 2), "Operation Q/E/ENTER");
-    box_window.print(Position(map_size.h + 1, operation_size.w + 3), "Feedback");
-}
-
-/**
- * @brief Renders the game interface by refreshing all the relevant windows.
- * 
- * This function updates the display of various game interface components,
- * ensuring that all windows are redrawn with the latest information.
- * It is responsible for refreshing the following windows:
- * - Map window
- * - General information window
- * - Selected information window
- * - Technology information window
- * - Super weapon information window
- * - Operation window
- * - Feedback window
- */
-void GameRenderer::render(void)
-{
-    map_window.refresh();
-    general_info_window.refresh();
-    selected_info_window.refresh();
-    tech_info_window.refresh();
-    super_weapon_info_window.refresh();
-    operation_window.refresh();
-    feedback_window.refresh();
-    // refresh();
-}
-
 /**
  * @brief Renders the entire game interface, including map, general information, 
  *        selected object information, technology tree, super weapon status, 
@@ -856,148 +700,181 @@ void GameRenderer::render(void)
 
 /// @brief Update all game interface elements
 void GameRenderer::draw(void)
-{   
-    // Clear all subwindows
-    map_window.erase();
-    general_info_window.erase();
-    selected_info_window.erase();
-    tech_info_window.erase();
-    super_weapon_info_window.erase();
-    operation_window.erase();
-    feedback_window.erase();
-
-    // NOTE: draw map window
-    for (int line = 0; line < game.get_size().h; line++)
+{
+    frame.capture(game, menu, blend);
+    FrameRenderer::draw();
+}
+
+/**
+ * @brief Records the game screen: the map view with its overlays, missiles and cursor, then every panel.
+ * The frame is reset first, keeping the layout but taking the view size from the game.
+ *
+ * @param game Game to capture.
+ * @param menu Operation menu of the game.
+ * @param blend How far missiles are drawn along their last move, 1 for where they are.
+ */
+void Frame::capture(Game &game, OperationMenu &menu, double blend)
+{
+    FrameLayout next = layout;
+    next.view = game.get_view_size();
+    reset(next);
+
+    // NOTE: map view
+    const Terrain &terrain = game.get_terrain();
+    const Position &origin = game.get_view_origin();
+    for (int line = 0; line < layout.view.h; line++)
     {
-        for (int col = 0; col < game.get_size().w; col++)
+        for (int col = 0; col < layout.view.w; col++)
         {
-            char ch = game.get_background().at(line).at(col);
-            switch (ch)
+            switch (terrain.get(origin + Position(line, col))) // Streamed maps only decode the chunks in view
             {
-            case ' ':
-                map_window.print(Position(line, col), " ", COLOR_PAIR(0));
+            case TerrainType::CITY:
+                set_cell(Position(line, col), '@', 3);
                 break;
-            case '@':
-                map_window.print(Position(line, col), "@", COLOR_PAIR(3));
+            case TerrainType::SEA:
+                set_cell(Position(line, col), ' ', 1);
                 break;
-            case '#':
-                map_window.print(Position(line, col), " ", COLOR_PAIR(1));
+            default:
+                set_cell(Position(line, col), ' ', 0);
                 break;
             }
         }
     }
 
-    // Active missiles
+    // Predicted paths of the attack missiles, a dot over the terrain. Only the rows in view
+    // of the forecast are visited, so a frame costs the same however many missiles fly.
+    if (game.en_enhanced_radar_III)
+    {
+        const std::vector<Position> &path = game.missile_manager.get_forecast(game.get_turn()).path;
+        auto cell = std::lower_bound(path.begin(), path.end(), origin,
+                                     [](const Position &a, const Position &b) { return a.y < b.y; });
+        for (; cell != path.end() && cell->y < origin.y + layout.view.h; ++cell)
+        {
+            Position position = *cell - origin;
+            if (position.x < 0 || position.x >= layout.view.w)
+            {
+                continue;
+            }
+            FrameCell &shown = map[position.y * layout.view.w + position.x];
+            if (shown.glyph != '@')
+            {
+                shown.glyph = 0x00B7; // Middle dot, keeping the terrain colour
+            }
+        }
+    }
+
+    // Threat heatmap, the background of each cell coloured by the damage heading through its block
+    if (game.get_is_heatmap_shown())
+    {
+        const ThreatMap &threat_map = game.missile_manager.get_threat_map();
+        for (int line = 0; line < layout.view.h; line++)
+        {
+            for (int col = 0; col < layout.view.w; col++)
+            {
+                int threat = threat_map.get(origin + Position(line, col));
+                FrameCell &shown = map[line * layout.view.w + col];
+                if (threat > 0 && shown.glyph != '@')
+                {
+                    shown.color = threat >= ThreatMap::HEAVY ? 2 : 3;
+                }
+            }
+        }
+    }
+
+    // Active missiles, an arrow followed by a space in the missile's colour
+    static const uint32_t arrows[] = {'O', 0x2191, 0x2197, 0x2192, 0x2198, 0x2193, 0x2199, 0x2190, 0x2196};
     for (auto missile : game.get_missiles())
     {
-        if (!game.is_in_map(missile->get_position()))
+        Position drawn = missile->get_position(blend);
+        if (!game.is_in_view(drawn) || missile->get_is_exploded())
         {
             continue;
         }
-        if (missile->get_is_exploded())
+        MissileDirection direction = missile->get_direction();
+        if (direction == MissileDirection::U)
         {
             continue;
         }
-        std::string direction;
-        switch (missile->get_direction())
+        uint8_t color = missile->get_type() == MissileType::ATTACK ? 2 : 4;
+        Position position = drawn - origin;
+        set_cell(position, arrows[int(direction)], color);
+        if (direction != MissileDirection::A)
         {
-        case MissileDirection::A://hit the object
-            direction = "O";
-            break;
-        case MissileDirection::N: // North
-            direction = "↑ ";
-            break;
-        case MissileDirection::NE:// Northeast
-            direction = "↗ ";
-            break;
-        case MissileDirection::E://East
-            direction = "→ ";
-            break;
-        case MissileDirection::SE://Southeast
-            direction = "↘ ";
-            break;
-        case MissileDirection::S://South
-            direction = "↓ ";
-            break;
-        case MissileDirection::SW://Southwest
-            direction = "↙ ";
-            break;
-        case MissileDirection::W://West
-            direction = "← ";
-            break;
-        case MissileDirection::NW:
-            direction = "↖ ";
-            break;
-        default:
-            break;
+            set_cell(position + Position(0, 1), ' ', color);
         }
-
-        map_window.print(missile->get_position(), direction, COLOR_PAIR(missile->get_type() == MissileType::ATTACK ? 2 : 4));
     }
-    int color_pair = (game.is_on_land(game.get_cursor()) ? 0 : (game.is_on_sea(game.get_cursor()) ? 1 : 3));
-    map_window.print(game.get_cursor(), "*", COLOR_PAIR(color_pair));
-
-    // NOTE: draw general windows
-    general_info_window.print_left(0, "Turn:", A_NORMAL);
-    general_info_window.print_right(0, std::to_string(game.get_turn()), A_NORMAL);
-    general_info_window.print_left(1, "Deposit:", A_NORMAL);
-    general_info_window.print_right(1, std::to_string(game.get_deposit()), A_NORMAL);
-    general_info_window.print_left(2, "Productivity:", A_NORMAL);
-    general_info_window.print_right(2, std::to_string(game.get_productivity()), A_NORMAL);
-    general_info_window.print_left(3, "Enemy HP:", A_NORMAL);
-    general_info_window.print_right(3, std::to_string(game.get_enemy_hp()), A_NORMAL);
+    uint8_t cursor_color = game.is_on_land(game.get_cursor()) ? 0 : (game.is_on_sea(game.get_cursor()) ? 1 : 3);
+    set_cell(game.get_cursor() - origin, '*', cursor_color);
+
+    // NOTE: general panel
+    print_left(PANEL_GENERAL, 0, "Turn:");
+    print_right(PANEL_GENERAL, 0, std::to_string(game.get_turn()));
+    print_left(PANEL_GENERAL, 1, "Deposit:");
+    print_right(PANEL_GENERAL, 1, std::to_string(game.get_deposit()));
+    print_left(PANEL_GENERAL, 2, "Productivity:");
+    print_right(PANEL_GENERAL, 2, std::to_string(game.get_productivity()));
+    print_left(PANEL_GENERAL, 3, "Enemy HP:");
+    print_right(PANEL_GENERAL, 3, std::to_string(game.get_enemy_hp()));
     if (game.en_self_defense_sys)
     {
-        general_info_window.print_left(4, "Self Defense System:", A_NORMAL);
-        general_info_window.print_right(4, "ON", A_NORMAL);
+        print_left(PANEL_GENERAL, 4, "Self Defense System:");
+        print_right(PANEL_GENERAL, 4, "ON");
     }
     if (game.en_enhanced_radar_I)
     {
         int missile_count = game.missile_manager.get_attack_missiles().size();
         if (missile_count == 0)
         {
-            general_info_window.print_spaces(5, COLOR_PAIR(4));
-            general_info_window.print_left(5, "No Missiles Approaching", COLOR_PAIR(4));
+            print_spaces(PANEL_GENERAL, 5, COLOR_PAIR(4));
+            print_left(PANEL_GENERAL, 5, "No Missiles Approaching", COLOR_PAIR(4));
         }
         else if (missile_count < 5)
         {
-            general_info_window.print_spaces(5, COLOR_PAIR(3));
-            general_info_window.print_left(5, std::to_string(missile_count) + " Missile Approaching", COLOR_PAIR(3));
+            print_spaces(PANEL_GENERAL, 5, COLOR_PAIR(3));
+            print_left(PANEL_GENERAL, 5, std::to_string(missile_count) + " Missile Approaching", COLOR_PAIR(3));
         }
         else
         {
-            general_info_window.print_spaces(5, COLOR_PAIR(2));
-            general_info_window.print_left(5, std::to_string(missile_count) + " Missiles Approaching !!!", COLOR_PAIR(2));
+            print_spaces(PANEL_GENERAL, 5, COLOR_PAIR(2));
+            print_left(PANEL_GENERAL, 5, std::to_string(missile_count) + " Missiles Approaching !!!", COLOR_PAIR(2));
         }
     }
 
-    // NOTE: draw selected info window
+    // NOTE: selected panel
     if (game.is_selected_missile() && game.en_enhanced_radar_III)
     {
         AttackMissile &missile = dynamic_cast<AttackMissile &>(game.select_missile());
-        selected_info_window.print_left(0, "Target:", A_NORMAL);
-        selected_info_window.print_left(1, "Speed:", A_NORMAL);
-        selected_info_window.print_left(2, "Damage:", A_NORMAL);
+        print_left(PANEL_SELECTED, 0, "Target:");
+        print_left(PANEL_SELECTED, 1, "Speed:");
+        print_left(PANEL_SELECTED, 2, "Damage:");
+        print_left(PANEL_SELECTED, 3, "Impact:");
 
-        selected_info_window.print_right(0, missile.city.name, A_NORMAL);
-        selected_info_window.print_right(1, std::to_string(missile.speed), missile.speed > 2 ? COLOR_PAIR(2) : COLOR_PAIR(3));
-        selected_info_window.print_right(2, std::to_string(missile.damage), missile.damage > 200 ? COLOR_PAIR(2) : COLOR_PAIR(3));
+        print_right(PANEL_SELECTED, 0, missile.city.name);
+        print_right(PANEL_SELECTED, 1, std::to_string(missile.speed), missile.speed > 2 ? COLOR_PAIR(2) : COLOR_PAIR(3));
+        print_right(PANEL_SELECTED, 2, std::to_string(missile.damage), missile.damage > 200 ? COLOR_PAIR(2) : COLOR_PAIR(3));
+        const Forecast &forecast = game.missile_manager.get_forecast(game.get_turn());
+        auto impact = forecast.impact_turns.find(missile.id);
+        if (impact != forecast.impact_turns.end())
+        {
+            int remaining = impact->second - game.get_turn();
+            print_right(PANEL_SELECTED, 3, "Turn " + std::to_string(impact->second), remaining < 3 ? COLOR_PAIR(2) : COLOR_PAIR(3));
+        }
     }
     else if (game.is_selected_city())
     {
         City &city = game.select_city();
 
-        selected_info_window.print_left(0, "Name:", A_NORMAL);
-        selected_info_window.print_left(1, "Hitpoint:", A_NORMAL);
-        selected_info_window.print_left(2, "Productivity:", A_NORMAL);
-        selected_info_window.print_left(3, "Countdown:", A_NORMAL);
-        selected_info_window.print_left(4, "Cruise Storage:", A_NORMAL);
+        print_left(PANEL_SELECTED, 0, "Name:");
+        print_left(PANEL_SELECTED, 1, "Hitpoint:");
+        print_left(PANEL_SELECTED, 2, "Productivity:");
+        print_left(PANEL_SELECTED, 3, "Countdown:");
+        print_left(PANEL_SELECTED, 4, "Cruise Storage:");
 
-        selected_info_window.print_right(0, city.name, A_NORMAL);
-        selected_info_window.print_right(1, std::to_string(city.hitpoint), A_NORMAL);
-        selected_info_window.print_right(2, std::to_string(city.productivity), A_NORMAL);
-        selected_info_window.print_right(3, std::to_string(city.countdown), A_NORMAL);
-        selected_info_window.print_right(4, std::to_string(city.cruise_storage), A_NORMAL);
+        print_right(PANEL_SELECTED, 0, city.name);
+        print_right(PANEL_SELECTED, 1, std::to_string(city.hitpoint));
+        print_right(PANEL_SELECTED, 2, std::to_string(city.productivity));
+        print_right(PANEL_SELECTED, 3, std::to_string(city.countdown));
+        print_right(PANEL_SELECTED, 4, std::to_string(city.cruise_storage));
 
         if (game.en_enhanced_radar_II)
         {
@@ -1012,149 +889,112 @@ void GameRenderer::draw(void)
 
             if (missile_count == 0)
             {
-                selected_info_window.print_spaces(5, COLOR_PAIR(4));
-                selected_info_window.print_left(5, "No missiles targeting the city", COLOR_PAIR(4));
+                print_spaces(PANEL_SELECTED, 5, COLOR_PAIR(4));
+                print_left(PANEL_SELECTED, 5, "No missiles targeting the city", COLOR_PAIR(4));
             }
             else if (missile_count < 3)
             {
-                selected_info_window.print_spaces(5, COLOR_PAIR(3));
-                selected_info_window.print_left(5, std::to_string(missile_count) + " approaching the city", COLOR_PAIR(3));
+                print_spaces(PANEL_SELECTED, 5, COLOR_PAIR(3));
+                print_left(PANEL_SELECTED, 5, std::to_string(missile_count) + " approaching the city", COLOR_PAIR(3));
             }
             else
             {
-                selected_info_window.print_spaces(5, COLOR_PAIR(2));
-                selected_info_window.print_left(5, std::to_string(missile_count) + " Missiles Approaching !!!", COLOR_PAIR(2));
+                print_spaces(PANEL_SELECTED, 5, COLOR_PAIR(2));
+                print_left(PANEL_SELECTED, 5, std::to_string(missile_count) + " Missiles Approaching !!!", COLOR_PAIR(2));
             }
         }
     }
     else
     {
-        selected_info_window.print_left(0, "Nothing Selected Now", A_NORMAL);
+        print_left(PANEL_SELECTED, 0, "Nothing Selected Now");
     }
 
-    // NOTE: draw tech info window
+    // NOTE: tech panel
     if (game.tech_tree.researching != nullptr)
     {
-        tech_info_window.print_left(0, "Researching:", A_NORMAL);
-        tech_info_window.print_left(1, "Remaining Time:", A_NORMAL);
+        print_left(PANEL_TECH, 0, "Researching:");
+        print_left(PANEL_TECH, 1, "Remaining Time:");
 
-        tech_info_window.print_right(0, game.tech_tree.researching->name, A_NORMAL);
-        tech_info_window.print_right(1, std::to_string(game.tech_tree.remaining_time), A_NORMAL);
+        print_right(PANEL_TECH, 0, game.tech_tree.researching->name);
+        print_right(PANEL_TECH, 1, std::to_string(game.tech_tree.remaining_time));
     }
     else
     {
-        tech_info_window.print_left(0, "Not Researching", A_NORMAL);
+        print_left(PANEL_TECH, 0, "Not Researching");
     }
 
-    tech_info_window.print_left(2, "Available:", A_NORMAL);
-    tech_info_window.print_left(3, "Researched:", A_NORMAL);
+    print_left(PANEL_TECH, 2, "Available:");
+    print_left(PANEL_TECH, 3, "Researched:");
 
-    tech_info_window.print_right(2, "    ", game.tech_tree.available.size() > 0 ? COLOR_PAIR(4) : COLOR_PAIR(3));
-    tech_info_window.print_right(2, std::to_string(game.tech_tree.available.size()), game.tech_tree.available.size() > 0 ? COLOR_PAIR(4) : COLOR_PAIR(3));
-    tech_info_window.print_right(3, std::to_string(game.tech_tree.researched.size()));
-
-    // NOTE: draw super weapon info window
-    super_weapon_info_window.print_left(0, "Standard Bomb", A_NORMAL);
-    if (game.standard_bomb_counter > 0)
-    {
-        super_weapon_info_window.print_right(0, "             ", COLOR_PAIR(3));
-        super_weapon_info_window.print_right(0, "Remains " + std::to_string(game.standard_bomb_counter), COLOR_PAIR(3));
-    }
-    else if (game.standard_bomb_counter == 0)
-    {
-        super_weapon_info_window.print_right(0, "             ", COLOR_PAIR(4));
-        super_weapon_info_window.print_right(0, "Ready", COLOR_PAIR(4));
-    }
-    else
-    {
-        super_weapon_info_window.print_right(0, "             ", COLOR_PAIR(2));
-        super_weapon_info_window.print_right(0, "Not Built", COLOR_PAIR(2));
-    }
+    attr_t available_attr = game.tech_tree.available.size() > 0 ? COLOR_PAIR(4) : COLOR_PAIR(3);
+    print_right(PANEL_TECH, 2, "    ", available_attr);
+    print_right(PANEL_TECH, 2, std::to_string(game.tech_tree.available.size()), available_attr);
+    print_right(PANEL_TECH, 3, std::to_string(game.tech_tree.researched.size()));
 
-    if (game.en_dirty_bomb)
+    // NOTE: super weapon panel, "Not Built" while the counter is negative
+    const int counters[] = {game.standard_bomb_counter, game.dirty_bomb_counter, game.hydrogen_bomb_counter};
+    const bool enabled[] = {true, game.en_dirty_bomb, game.en_hydrogen_bomb};
+    const char *names[] = {"Standard Bomb", "Dirty Bomb", "Hydrogen Bomb"};
+    const char *remains[] = {"Remains ", "Remains ", "Remains"};
+    for (int line = 0; line < 3; line++)
     {
-        super_weapon_info_window.print_left(1, "Dirty Bomb", A_NORMAL);
-        if (game.dirty_bomb_counter > 0)
-        {
-            super_weapon_info_window.print_right(1, "             ", COLOR_PAIR(3));
-            super_weapon_info_window.print_right(1, "Remains " + std::to_string(game.dirty_bomb_counter), COLOR_PAIR(3));
-        }
-        else if (game.dirty_bomb_counter == 0)
+        if (!enabled[line])
         {
-            super_weapon_info_window.print_right(1, "             ", COLOR_PAIR(4));
-            super_weapon_info_window.print_right(1, "Ready", COLOR_PAIR(4));
-        }
-        else
-        {
-            super_weapon_info_window.print_right(1, "             ", COLOR_PAIR(2));
-            super_weapon_info_window.print_right(1, "Not Built", COLOR_PAIR(2));
+            continue;
         }
-    }
-    if (game.en_hydrogen_bomb)
-    {
-        super_weapon_info_window.print_left(2, "Hydrogen Bomb", A_NORMAL);
-        if (game.hydrogen_bomb_counter > 0)
+        print_left(PANEL_SUPER_WEAPON, line, names[line]);
+        if (counters[line] > 0)
         {
-            super_weapon_info_window.print_right(2, "             ", COLOR_PAIR(3));
-            super_weapon_info_window.print_right(2, "Remains" + std::to_string(game.hydrogen_bomb_counter), COLOR_PAIR(3));
+            print_right(PANEL_SUPER_WEAPON, line, "             ", COLOR_PAIR(3));
+            print_right(PANEL_SUPER_WEAPON, line, remains[line] + std::to_string(counters[line]), COLOR_PAIR(3));
         }
-        else if (game.hydrogen_bomb_counter == 0)
+        else if (counters[line] == 0)
         {
-            super_weapon_info_window.print_right(2, "             ", COLOR_PAIR(4));
-            super_weapon_info_window.print_right(2, "Ready", COLOR_PAIR(4));
+            print_right(PANEL_SUPER_WEAPON, line, "             ", COLOR_PAIR(4));
+            print_right(PANEL_SUPER_WEAPON, line, "Ready", COLOR_PAIR(4));
         }
         else
         {
-            super_weapon_info_window.print_right(2, "             ", COLOR_PAIR(2));
-            super_weapon_info_window.print_right(2, "Not Built", COLOR_PAIR(2));
+            print_right(PANEL_SUPER_WEAPON, line, "             ", COLOR_PAIR(2));
+            print_right(PANEL_SUPER_WEAPON, line, "Not Built", COLOR_PAIR(2));
         }
     }
     if (game.en_iron_curtain)
     {
-        super_weapon_info_window.print_left(3, "Iron Curtain", A_NORMAL);
+        print_left(PANEL_SUPER_WEAPON, 3, "Iron Curtain");
         if (game.iron_curtain_counter > 40)
         {
-            super_weapon_info_window.print_right(3, "             ", COLOR_PAIR(4));
-            super_weapon_info_window.print_right(3, "Remains" + std::to_string(game.iron_curtain_counter), COLOR_PAIR(4));
+            print_right(PANEL_SUPER_WEAPON, 3, "             ", COLOR_PAIR(4));
+            print_right(PANEL_SUPER_WEAPON, 3, "Remains" + std::to_string(game.iron_curtain_counter), COLOR_PAIR(4));
         }
         else if (game.iron_curtain_counter > 0)
         {
-            super_weapon_info_window.print_right(3, "             ", COLOR_PAIR(3));
-            super_weapon_info_window.print_right(3, "Remains" + std::to_string(game.iron_curtain_counter), COLOR_PAIR(3));
+            print_right(PANEL_SUPER_WEAPON, 3, "             ", COLOR_PAIR(3));
+            print_right(PANEL_SUPER_WEAPON, 3, "Remains" + std::to_string(game.iron_curtain_counter), COLOR_PAIR(3));
         }
         else
         {
-            super_weapon_info_window.print_right(3, "             ", COLOR_PAIR(2));
-            super_weapon_info_window.print_right(3, "Not Activated", COLOR_PAIR(2));
+            print_right(PANEL_SUPER_WEAPON, 3, "             ", COLOR_PAIR(2));
+            print_right(PANEL_SUPER_WEAPON, 3, "Not Activated", COLOR_PAIR(2));
         }
     }
 
-    // NOTE: draw operation window
+    // NOTE: operation panel
     for (int index = menu.get_offset(); index < menu.get_offset() + menu.get_limit(); index++)
     {
-        if (index >= menu.get_items().size())
+        if (index >= int(menu.get_items().size()))
         {
             break;
         }
-        if (index == menu.get_cursor())
-        {
-            operation_window.print_left(index - menu.get_offset(), menu.get_item(index), A_REVERSE);
-        }
-        else
-        {
-            operation_window.print_left(index - menu.get_offset(), menu.get_item(index));
-        }
+        print_left(PANEL_OPERATION, index - menu.get_offset(), menu.get_item(index), index == menu.get_cursor() ? A_REVERSE : A_NORMAL);
     }
 
-    // NOTE: draw feedback window
-    for (int index = 0; index < game.get_feedbacks().size(); index++)
+    // NOTE: feedback panel, newest first
+    const VAttrString &feedbacks = game.get_feedbacks();
+    for (int index = 0; index < int(feedbacks.size()) && index < get_lines(PANEL_FEEDBACK); index++)
     {
-        if (index >= feedback_size.h)
-        {
-            break;
-        }
-        const AttrString &feedback = game.get_feedbacks().at(game.get_feedbacks().size() - index - 1);
-        feedback_window.print_spaces(index, feedback.attr);
-        feedback_window.print_left(index, feedback);
+        const AttrString &feedback = feedbacks.at(feedbacks.size() - index - 1);
+        print_spaces(PANEL_FEEDBACK, index, feedback.attr);
+        print_left(PANEL_FEEDBACK, index, feedback.str, feedback.attr);
     }
 }
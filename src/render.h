@@ -9,95 +9,11 @@
 #include <string>
 #include <vector>
 #include <ncurses.h>
+#include "frame.h"
+#include "screen.h"
+#include "leaderboard.h"
 #include "utils.h"
 
-/**
- * @class Window
- * @brief Encapsulates ncurses window management
- *
- * @var WINDOW *window Pointer to the ncurses window
- * @var Size size Size of the window
- * @var Position pos Position of the window on the screen
- *
- * Provides methods for drawing characters, lines, and text within the window.
- * Also includes methods for refreshing and erasing the window.
- */
-class Window
-{
-private:
-    WINDOW *window;
-    Size size;
-    Position pos;
-
-public:
-    Window(WINDOW *win, Size s, Position p);
-    Window(Window &win, Size s, Position p);
-    ~Window(void) { delwin(window); };
-
-    /// @name refresh/erase
-    /// @{
-    void refresh(void) { wrefresh(window); };
-    void erase(void) { werase(window); };
-    /// @}
-
-    /// @name margin/line drawing
-    /// @{
-    void draw_margin(void) { box(window, 0, 0); };
-    void draw_hline(Position p, int len) { mvwhline(window, p.y, p.x, ACS_HLINE, len); };
-    void draw_vline(Position p, int len) { mvwvline(window, p.y, p.x, ACS_VLINE, len); };
-    void draw_char(Position p, chtype ch) { mvwaddch(window, p.y, p.x, ch); };
-    /// @}
-
-    /// @name char/text printing
-    /// @{
-    void print(Position p, chtype ch, attr_t attr = A_NORMAL);
-    void print(Position p, const char *s, attr_t = A_NORMAL);
-    void print(Position p, const std::string &s, attr_t attr = A_NORMAL) { print(p, s.c_str(), attr); };
-    void print(Position p, const AttrString &s) { print(p, s.str, s.attr); };
-    void print_spaces(int line, attr_t = A_NORMAL);
-    void print_left(int line, const std::string &s, attr_t attr = A_NORMAL);
-    void print_left(int line, const AttrString &s) { print_left(line, s.str, s.attr); };
-    void print_center(int line, const std::string &s, attr_t attr = A_NORMAL);
-    void print_center(int line, const AttrString &s) { print_center(line, s.str, s.attr); };
-    void print_right(int line, const std::string &s, attr_t attr = A_NORMAL);
-    void print_right(int line, const AttrString &s) { print_right(line, s.str, s.attr); };
-    /// @}
-};
-
-/**
- * @class Renderer
- * @brief Abstract base class for all UI renderers
- *
- * Defines common interface for initializing, updating and drawing
- * ncurses-based UI components. Provides debug utilities.
- */
-class Renderer
-{
-public:
-    /**
-     * @brief Main rendering entry point
-     * @details Updates all visual components
-     */
-    virtual void render(void) = 0;
-    /**
-     * @brief Initialize renderer resources
-     * @details Creates windows and sets up initial UI state
-     */
-    virtual void init(void) = 0;
-    /**
-     * @brief Commit changes to physical screen
-     * @details Performs final refresh operations on all windows
-     */
-    virtual void draw(void) = 0;
-
-    /**
-     * @brief Output debug information
-     * @param str Debug message to display
-     * @param line Optional line number (0-based) in debug area
-     */
-    void debug(const std::string &str, int line = 0);
-};
-
 /**
  * @class BasicMenuRenderer
  * @brief Renders standard menu interface
@@ -123,6 +39,24 @@ public:
     void draw(void);
 };
 
+/**
+ * @class PauseMenuRenderer
+ * @brief Renders the pause menu together with charts of the game so far
+ */
+class PauseMenuRenderer : public BasicMenuRenderer
+{
+private:
+    Game &game;
+
+    Window stats_box_window;
+    Window stats_window;
+
+public:
+    PauseMenuRenderer(Menu &m, Game &g, Size s);
+
+    void init(void);
+};
+
 /**
  * @class VideoRenderer
  * @brief Renders video interface
@@ -213,6 +147,36 @@ public:
     void draw(void);
 };
 
+/**
+ * @class LeaderboardRenderer
+ * @brief Renders the best recorded games in a box beside a menu
+ *
+ * Lists the best games of one level, or the best few of every level. The leaderboard
+ * is only read when drawn, not on every frame.
+ */
+class LeaderboardRenderer : public Renderer
+{
+private:
+    Leaderboard *leaderboard; ///< Null when the leaderboard file is unavailable
+    int level;                ///< Level listed, 0 for every level
+    uint32_t highlight;       ///< Serial of the record to highlight, 0 for none
+
+    Size size;
+    Position pos;
+
+    Window box_window;
+    Window list_window;
+
+public:
+    LeaderboardRenderer(Leaderboard *l, Size s, Position shift);
+
+    void set_level(int lv) { level = lv; };
+    void set_highlight(uint32_t serial) { highlight = serial; };
+    void init(void);
+    void render(void);
+    void draw(void);
+};
+
 /**
  * @class TutorialMenuRenderer
  * @brief Specialized renderer for tutorial content
@@ -277,35 +241,18 @@ public:
  * - Operation controls
  * - Feedback system
  */
-class GameRenderer : public Renderer
+class GameRenderer : public FrameRenderer
 {
 private:
     Game &game;          ///< Game state reference
     OperationMenu &menu; ///< Operation controls data
-
-    Size map_size;
-    Size info_size;
-    Size operation_size;
-    Size feedback_size;
-    std::vector<int> fields;
-    Position pos;
-
-    Window box_window; ///< Master border window
-    Window map_window; ///< Tactical map display
-    Window info_window;
-    Window general_info_window;      ///< Player stats/status
-    Window selected_info_window;     ///< Selected entity details
-    Window tech_info_window;         ///< Research progress
-    Window super_weapon_info_window; ///< Special weapons status
-    Window operation_window;         ///< Command interface
-    Window feedback_window;          ///< System messages/notifications
+    double blend;        ///< How far missiles are drawn along their last move
 
 public:
     GameRenderer(Game &g, OperationMenu &m, Size s, const std::vector<int> &ls);
 
-    void init(void);
-    void render(void);
     void draw(void);
+    void set_blend(double b) { blend = b; }; ///< Draw missiles between turns, 1 to draw them where they are
 };
 
 #endif
@@ -0,0 +1,118 @@
+/**
+ * @file rng.h
+ * @brief Counter-based random number streams
+ *
+ * A CounterRandom stream is fully determined by its key (seed, turn, index, purpose):
+ * the n-th number of a stream is the Philox4x32-10 block cipher applied to the counter
+ * (turn, index, purpose, n / 4) under the seed. Streams hold no shared state, so work
+ * split across threads in any order draws exactly the numbers a serial run would.
+ */
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+/**
+ * @enum RandomPurpose
+ * @brief Separates the streams of different random decisions made for the same turn and index.
+ */
+enum class RandomPurpose : uint32_t
+{
+    WAVE_SPAWN = 1,    ///< Speed, damage and start of the index-th missile of a wave
+    WAVE_TARGET = 2,   ///< Target city of the index-th missile of a wave, drawn when it launches
+    CASUALTY = 3,      ///< Casualties of the impacts on the index-th city
+    DIRTY_BOMB = 4,    ///< Whether the dirty bomb misses
+    HYDROGEN_BOMB = 5  ///< Whether the hydrogen bomb misses
+};
+
+/**
+ * @class CounterRandom
+ * @brief Philox4x32-10 random stream keyed by (seed, turn, index, purpose).
+ *
+ * Satisfies the UniformRandomBitGenerator requirements, but `uniform` and `uniform_real`
+ * should be preferred over the standard distributions, whose output differs between
+ * standard library implementations.
+ */
+class CounterRandom
+{
+public:
+    typedef uint32_t result_type;
+
+private:
+    uint32_t key[2];     ///< Seed split into two words
+    uint32_t counter[4]; ///< Turn, index, purpose and block number
+    uint32_t block[4];   ///< Last generated block
+    int used;            ///< Numbers of `block` already returned
+
+    static void mulhilo(uint32_t a, uint32_t b, uint32_t &hi, uint32_t &lo)
+    {
+        uint64_t product = uint64_t(a) * b;
+        hi = uint32_t(product >> 32);
+        lo = uint32_t(product);
+    };
+    void generate(void) ///< Encrypts the counter into the next block
+    {
+        uint32_t c[4] = {counter[0], counter[1], counter[2], counter[3]};
+        uint32_t k[2] = {key[0], key[1]};
+        for (int round = 0; round < 10; round++)
+        {
+            uint32_t hi0, lo0, hi1, lo1;
+            mulhilo(0xD2511F53U, c[0], hi0, lo0);
+            mulhilo(0xCD9E8D57U, c[2], hi1, lo1);
+            uint32_t next[4] = {hi1 ^ c[1] ^ k[0], lo1, hi0 ^ c[3] ^ k[1], lo0};
+            c[0] = next[0], c[1] = next[1], c[2] = next[2], c[3] = next[3];
+            k[0] += 0x9E3779B9U;
+            k[1] += 0xBB67AE85U;
+        }
+        block[0] = c[0], block[1] = c[1], block[2] = c[2], block[3] = c[3];
+        counter[3]++;
+        used = 0;
+    };
+
+public:
+    CounterRandom(uint64_t seed, uint32_t turn, uint32_t index, RandomPurpose purpose) : used(4)
+    {
+        key[0] = uint32_t(seed);
+        key[1] = uint32_t(seed >> 32);
+        counter[0] = turn;
+        counter[1] = index;
+        counter[2] = uint32_t(purpose);
+        counter[3] = 0;
+    };
+
+    static constexpr result_type min(void) { return 0; };
+    static constexpr result_type max(void) { return 0xFFFFFFFFU; };
+    result_type operator()(void)
+    {
+        if (used == 4)
+        {
+            generate();
+        }
+        return block[used++];
+    };
+
+    /// @brief Unbiased integer in [min, max], by multiply-shift with rejection (Lemire).
+    int uniform(int min, int max)
+    {
+        uint32_t range = uint32_t(max) - uint32_t(min) + 1;
+        if (range == 0) // The whole 32-bit range
+        {
+            return int(uint32_t(min) + (*this)());
+        }
+        uint64_t product = uint64_t((*this)()) * range;
+        if (uint32_t(product) < range)
+        {
+            uint32_t threshold = (0U - range) % range;
+            while (uint32_t(product) < threshold)
+            {
+                product = uint64_t((*this)()) * range;
+            }
+        }
+        return int(uint32_t(min) + uint32_t(product >> 32));
+    };
+    /// @brief Real number in [0, 1) with 32 bits of resolution.
+    double uniform_real(void) { return (*this)() * (1.0 / 4294967296.0); };
+};
+
+#endif
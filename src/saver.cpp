@@ -14,10 +14,14 @@
  *
  * Functions:
  * - AssetLoader::load_general: Loads general game configuration from a file and initializes game settings.
- * - AssetLoader::load_background: Loads the background data from a file and stores it in the game's background container.
+ * - AssetLoader::load_background: Loads the background data, streaming "background.map" when present, into the game's terrain grid.
+ * - AssetLoader::pack_background: Converts "background.txt" into the chunked map "background.map".
+ * - AssetLoader::generate_assets: Generates a new map with its cities and writes them as the map assets.
  * - AssetLoader::load_cities: Loads city data from a file and populates the game's city list.
+ * - AssetLoader::load_waves: Loads the attack wave rules from "waves.txt" into the wave table.
  * - AssetLoader::load_title: Loads the content of the "title.txt" file into a vector of strings.
  * - AssetLoader::reset: Resets the game state by reloading assets and clearing game data.
+ * - AssetLoader::load_bundle: Loads every asset once so that many games can be reset from it.
  * - GeneralChecker::is_first_run: Checks if this is the first run of the program.
  * - GeneralChecker::save_lastrun: Creates a file named "lastrun" to indicate the first run.
  * - SaveDumper::is_slot_empty: Checks if the save slot is empty.
@@ -40,10 +44,15 @@
 #include <vector>
 #include <sstream>
 #include <fstream>
+#include <algorithm>
+#include <random>
+#include <memory>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include "saver.h"
 #include "game.h"
+#include "generator.h"
+#include "server.h"
 
 /**
  * @brief Loads general game configuration from a file and initializes game settings.
@@ -63,15 +72,33 @@ void AssetLoader::load_general(void)
     {
         throw std::runtime_error("Cannot open general.txt"); // Critical file missing
     }
+    load_general(file);
+    file.close();
+}
+
+/**
+ * @brief Applies general game configuration in the "general.txt" format.
+ *
+ * @param file Stream positioned at the first "key:value" line.
+ */
+void AssetLoader::load_general(std::istream &file)
+{
     std::string line;
     std::string word;
     std::istringstream iss;
+    Size view(0, 0); // NOTE: optional, the whole map is shown by default
+    generator_cities = 0;
+    live_stats = false;
+    telemetry.clear();
+    realtime = 0;
+    game.missile_manager.set_routing(RoutingMode::DIRECT);
+    std::random_device device; // NOTE: a fresh seed unless general.txt pins one for reproducible runs
+    game.missile_manager.seed = (uint64_t(device()) << 32) | device();
     while (getline(file, line))
     {
         if (line.empty())
         {
-            file.close();
-            return;
+            break;
         }
 
         iss.clear();
@@ -89,6 +116,51 @@ void AssetLoader::load_general(void)
             game.size.w = std::stoi(word);
             game.missile_manager.size.w = game.size.w;
         }
+        else if (word == "generator_cities")
+        {
+            getline(iss, word);
+            generator_cities = std::stoi(word);
+        }
+        else if (word == "generator_seed")
+        {
+            getline(iss, word);
+            generator_seed = std::stoul(word);
+        }
+        else if (word == "missile_routing")
+        {
+            getline(iss, word);
+            game.missile_manager.set_routing(RoutingMode(std::min(2, std::max(0, std::stoi(word)))));
+        }
+        else if (word == "live_stats")
+        {
+            getline(iss, word);
+            live_stats = std::stoi(word) != 0;
+        }
+        else if (word == "telemetry")
+        {
+            getline(iss, word);
+            telemetry = word;
+        }
+        else if (word == "realtime")
+        {
+            getline(iss, word);
+            realtime = std::min(Game::MAX_TURNS_PER_SECOND, std::max(0, std::stoi(word)));
+        }
+        else if (word == "random_seed")
+        {
+            getline(iss, word);
+            game.missile_manager.seed = std::stoull(word);
+        }
+        else if (word == "view_y")
+        {
+            getline(iss, word);
+            view.h = std::stoi(word);
+        }
+        else if (word == "view_x")
+        {
+            getline(iss, word);
+            view.w = std::stoi(word);
+        }
         else if (word == "cursor_y")
         {
             getline(iss, word);
@@ -213,31 +285,152 @@ void AssetLoader::load_general(void)
             game.en_iron_curtain = std::stoi(word);
         }
     }
+    game.fit_view(view);
 }
 
 /**
- * @brief Loads the background data from a file and stores it in the game's background container.
+ * @brief Loads the background data and compiles it into the game's terrain grid.
  *
- * This function reads the contents of "background.txt" line by line and populates the
- * `game.background` vector with the data. If the file cannot be opened, it throws a runtime error.
+ * When "general.txt" sets `generator_cities`, the map is generated in memory instead.
+ * Otherwise, if a chunked map "background.map" is present it is memory-mapped and streamed, so
+ * only the chunks touched by the view, missiles and cities are ever decoded. Otherwise
+ * "background.txt" is read line by line and each row is packed into `game.terrain`
+ * directly, so the text map is never held in memory as a whole. Either way the map
+ * must match the size given in "general.txt".
  *
- * @throws std::runtime_error If the file "background.txt" cannot be opened.
+ * @throws std::runtime_error If no background can be opened or its size does not match.
  */
 void AssetLoader::load_background(void)
+{
+    if (generator_cities > 0)
+    {
+        MapGenerator(game.size, generator_cities, generator_seed).generate_terrain(game.terrain);
+        return;
+    }
+    struct stat info;
+    if (stat("background.map", &info) == 0 && (info.st_mode & S_IFREG))
+    {
+        std::shared_ptr<const TerrainChunkFile> map = std::make_shared<const TerrainChunkFile>("background.map");
+        if (!(map->get_size() == game.size))
+        {
+            throw std::runtime_error("Size of background.map does not match general.txt");
+        }
+        game.terrain.stream(map);
+        return;
+    }
+    load_background_text();
+}
+
+/**
+ * @brief Compiles "background.txt" row by row into a flat terrain grid.
+ *
+ * @throws std::runtime_error If the file "background.txt" cannot be opened.
+ */
+void AssetLoader::load_background_text(void)
 {
     std::ifstream file("background.txt");
     if (!file.is_open())
     {
         throw std::runtime_error("Cannot open background.txt");
     }
-    game.background.clear();
-    for (std::string line; std::getline(file, line);)
+    game.terrain.reset(game.size);
+    int line_index = 0;
+    for (std::string line; std::getline(file, line); line_index++)
     {
-        game.background.push_back(line);
+        game.terrain.set_row(line_index, line);
     }
     file.close();
 }
 
+/**
+ * @brief Converts "background.txt" into the chunked map "background.map".
+ *
+ * The map size is taken from "general.txt". Once written, the chunked map takes
+ * precedence over the text background in `load_background`.
+ *
+ * @throws std::runtime_error If either file cannot be read or written.
+ */
+void AssetLoader::pack_background(void)
+{
+    load_general();
+    load_background_text();
+    game.terrain.save_chunked("background.map");
+}
+
+/**
+ * @brief Generates a new map with its cities and writes them as the map assets.
+ *
+ * Writes "background.txt", its chunked copy "background.map" and "cities.txt", then
+ * updates the map size and cursor in "general.txt" while keeping its other settings.
+ *
+ * @param s Size of the map to generate.
+ * @param n Number of cities to place.
+ * @param seed Seed of the generated map.
+ * @throws std::runtime_error If an asset file cannot be read or written.
+ */
+void AssetLoader::generate_assets(Size s, int n, uint32_t seed)
+{
+    MapGenerator generator(s, n, seed);
+    game.size = s;
+    generator.generate_terrain(game.terrain);
+    game.cities = generator.generate_cities(game.terrain);
+
+    std::ofstream background("background.txt");
+    if (!background.is_open())
+    {
+        throw std::runtime_error("Cannot write background.txt");
+    }
+    std::string row(s.w, ' ');
+    for (int y = 0; y < s.h; y++)
+    {
+        for (int x = 0; x < s.w; x++)
+        {
+            row[x] = Terrain::to_char(game.terrain.get(Position(y, x)));
+        }
+        background << row << "\n";
+    }
+    background.close();
+    game.terrain.save_chunked("background.map");
+
+    std::ofstream city_file("cities.txt");
+    if (!city_file.is_open())
+    {
+        throw std::runtime_error("Cannot write cities.txt");
+    }
+    city_file << "name,y,x,hitpoint\n";
+    for (auto &city : game.cities)
+    {
+        city_file << city.name << "," << city.position.y << "," << city.position.x << "," << city.hitpoint << "\n";
+    }
+    city_file.close();
+
+    std::vector<std::string> lines;
+    std::ifstream general_in("general.txt");
+    if (!general_in.is_open())
+    {
+        throw std::runtime_error("Cannot open general.txt");
+    }
+    for (std::string line; std::getline(general_in, line);)
+    {
+        std::string key = line.substr(0, line.find(':'));
+        if (key != "size_y" && key != "size_x" && key != "cursor_y" && key != "cursor_x")
+        {
+            lines.push_back(line);
+        }
+    }
+    general_in.close();
+    std::ofstream general_out("general.txt");
+    general_out << "size_y:" << s.h << "\n";
+    general_out << "size_x:" << s.w << "\n";
+    general_out << "cursor_y:" << s.h / 2 << "\n";
+    general_out << "cursor_x:" << s.w / 2 << "\n";
+    for (auto &line : lines)
+    {
+        general_out << line << "\n";
+    }
+    general_out.close();
+}
+
 /**
  * @brief Loads city data from a file and populates the game's city list.
  *
@@ -245,11 +438,18 @@ void AssetLoader::load_background(void)
  * Each line in the file represents a city with its attributes separated by commas.
  * The attributes include the city's name, position (x, y), and hitpoints.
  * The function clears the existing city list in the game before loading new data.
+ * When "general.txt" sets `generator_cities`, the cities are generated on the terrain
+ * produced by `load_background` instead.
  *
  * @throws std::runtime_error If the file "cities.txt" cannot be opened.
  */
 void AssetLoader::load_cities(void)
 {
+    if (generator_cities > 0)
+    {
+        game.cities = MapGenerator(game.size, generator_cities, generator_seed).generate_cities(game.terrain);
+        return;
+    }
     std::ifstream file("cities.txt");
     if (!file.is_open())
     {
@@ -280,6 +480,84 @@ void AssetLoader::load_cities(void)
     file.close();
 }
 
+/**
+ * @brief Loads the attack wave rules from "waves.txt" and compiles them into the wave table.
+ *
+ * Each line after the header is "level,start,end,interval,count_base,count_turns,speeds,
+ * damages,hitpoint_step,turn_step,target,edges", where speeds and damages are space
+ * separated lists, end is -1 for an open-ended range, target is "hitpoint" or "uniform"
+ * and edges is any of "LRTB". Without the file the built-in waves are used.
+ *
+ * @throws std::runtime_error If a rule is malformed.
+ */
+void AssetLoader::load_waves(void)
+{
+    std::ifstream file("waves.txt");
+    if (!file.is_open())
+    {
+        game.missile_manager.waves.compile(WaveTable::get_default_rules()); // NOTE: optional asset
+        return;
+    }
+    std::vector<WaveRule> rules;
+    std::string line;
+    std::vector<std::string> words;
+    std::string word;
+    std::istringstream iss;
+    std::getline(file, line);
+    while (getline(file, line))
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+        words.clear();
+        iss.clear();
+        iss.str(line);
+        while (getline(iss, word, ','))
+        {
+            words.push_back(word);
+        }
+        if (words.size() != 12)
+        {
+            throw std::runtime_error("Invalid line in waves.txt: " + line);
+        }
+
+        WaveRule rule;
+        rule.level = std::stoi(words[0]);
+        rule.start = std::stoi(words[1]);
+        rule.end = std::stoi(words[2]);
+        rule.interval = std::stoi(words[3]);
+        rule.count_base = std::stoi(words[4]);
+        rule.count_turns = std::stoi(words[5]);
+        for (std::istringstream list(words[6]); list >> word;)
+        {
+            rule.speeds.push_back(std::stoi(word));
+        }
+        for (std::istringstream list(words[7]); list >> word;)
+        {
+            rule.damages.push_back(std::stoi(word));
+        }
+        rule.hitpoint_step = std::stoi(words[8]);
+        rule.turn_step = std::stoi(words[9]);
+        if (words[10] == "hitpoint")
+        {
+            rule.target = WaveTarget::HITPOINT;
+        }
+        else if (words[10] == "uniform")
+        {
+            rule.target = WaveTarget::UNIFORM;
+        }
+        else
+        {
+            throw std::runtime_error("Unknown wave target in waves.txt: " + words[10]);
+        }
+        rule.edges = words[11];
+        rules.push_back(rule);
+    }
+    file.close();
+    game.missile_manager.waves.compile(rules);
+}
+
 /**
  * @brief Loads the content of the "title.txt" file into a vector of strings.
  *
@@ -350,23 +628,80 @@ std::vector<std::vector<std::string>> AssetLoader::load_video(void)
  * @brief Resets the game state by reloading assets and clearing game data.
  *
  * This function performs the following actions:
- * - Reloads general assets, background, and city data.
- * - Resets the missile manager's cities and clears all existing missiles.
+ * - Reloads general assets, background, city data and wave rules.
+ * - Resets the missile manager's cities, clears all existing missiles and drops the pending wave plan and forecast.
  * - Resets the technology tree, including research progress and available technologies.
  * - Clears all feedback messages.
  */
 
 void AssetLoader::reset(void)
 {
+    game.missile_manager.cancel_attack_wave(); // The pending plan belongs to the previous game
+    game.missile_manager.cancel_forecast();
     load_general();
     load_background();
     load_cities();
+    load_waves();
+    reset_state();
+}
+
+/**
+ * @brief Resets the game state from assets loaded once by load_bundle.
+ * The terrain grid is shared with the bundle rather than copied, so any number of
+ * games can be reset from one bundle cheaply.
+ *
+ * @param bundle Assets to start the game from.
+ */
+void AssetLoader::reset(const AssetBundle &bundle)
+{
+    game.missile_manager.cancel_attack_wave();
+    game.missile_manager.cancel_forecast();
+    std::istringstream general(bundle.general);
+    load_general(general);
+    game.terrain = bundle.terrain;
+    game.cities = bundle.cities;
+    game.missile_manager.waves = bundle.waves;
+    reset_state();
+}
+
+/**
+ * @brief Loads every asset once, for games to be reset from with reset(const AssetBundle &).
+ *
+ * @param bundle Receives the general settings, terrain, cities and wave rules.
+ * @throws std::runtime_error If an asset cannot be loaded.
+ */
+void AssetLoader::load_bundle(AssetBundle &bundle)
+{
+    std::ifstream file("general.txt");
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Cannot open general.txt");
+    }
+    std::ostringstream general;
+    general << file.rdbuf();
+    file.close();
+    bundle.general = general.str();
+
+    reset();
+    bundle.terrain = game.terrain;
+    bundle.cities = game.cities;
+    bundle.waves = game.missile_manager.waves;
+}
+
+/**
+ * @brief Clears the missiles, research progress, feedbacks and statistics of the previous game.
+ *
+ */
+void AssetLoader::reset_state(void)
+{
     game.missile_manager.cities = game.cities;
     for (auto missile : game.get_missiles())
     {
         delete missile;
     }
     game.missile_manager.missiles.clear();
+    game.missile_manager.threat_map.reset(game.size);
+    game.missile_manager.clear_flow_fields(); // Routes belong to the previous terrain
 
     game.tech_tree.researching = nullptr;
     game.tech_tree.prev_researching = nullptr;
@@ -375,6 +710,9 @@ void AssetLoader::reset(void)
     game.tech_tree.available.clear();
 
     game.feedbacks.clear();
+    game.series.clear(); // NOTE: saves keep no history, a loaded game starts new series
+    game.intercepted_total = 0;
+    game.landed_total = 0;
 }
 
 /**
@@ -527,6 +865,8 @@ void SaveDumper::save_general(const std::string &savepath)
         general_log << "size_x:" << game.size.w << "\n";
         general_log << "cursor_y:" << game.cursor.y << "\n";
         general_log << "cursor_x:" << game.cursor.x << "\n";
+        general_log << "view_y:" << game.view_size.h << "\n";
+        general_log << "view_x:" << game.view_size.w << "\n";
         general_log << "turn:" << game.get_turn() << "\n";
         general_log << "deposit:" << game.get_deposit() << "\n";
         general_log << "difficulty_level:" << game.difficulty_level << "\n";
@@ -534,6 +874,8 @@ void SaveDumper::save_general(const std::string &savepath)
         general_log << "score:" << game.get_score() << "\n";
         general_log << "casualty:" << game.get_casualty() << "\n";
         general_log << "missile_manager_id:" << game.missile_manager.id << "\n";
+        general_log << "missile_routing:" << int(game.missile_manager.routing) << "\n";
+        general_log << "random_seed:" << game.missile_manager.seed << "\n";
 
         // NOTE: super weapon
         general_log << "standard_bomb_counter:" << game.standard_bomb_counter << "\n";
@@ -802,12 +1144,12 @@ void SaveLoader::load_general(const std::string &savepath)
     std::string line;
     std::string word;
     std::istringstream iss;
+    Size view(0, 0); // NOTE: optional, the whole map is shown by default
     while (getline(general_log, line))
     {
         if (line.empty())
         {
-            general_log.close();
-            return;
+            break;
         }
 
         iss.clear();
@@ -825,6 +1167,26 @@ void SaveLoader::load_general(const std::string &savepath)
             game.size.w = std::stoi(word);
             game.missile_manager.size.w = game.size.w;
         }
+        else if (word == "missile_routing")
+        {
+            getline(iss, word);
+            game.missile_manager.set_routing(RoutingMode(std::min(2, std::max(0, std::stoi(word)))));
+        }
+        else if (word == "random_seed")
+        {
+            getline(iss, word);
+            game.missile_manager.seed = std::stoull(word);
+        }
+        else if (word == "view_y")
+        {
+            getline(iss, word);
+            view.h = std::stoi(word);
+        }
+        else if (word == "view_x")
+        {
+            getline(iss, word);
+            view.w = std::stoi(word);
+        }
         else if (word == "cursor_y")
         {
             getline(iss, word);
@@ -849,7 +1211,6 @@ void SaveLoader::load_general(const std::string &savepath)
         {
             getline(iss, word);
             game.difficulty_level = std::stoi(word);
-            game.missile_manager.set_difficulty(std::stoi(word));
         }
         else if (word == "enemy_hitpoint")
         {
@@ -964,6 +1325,8 @@ void SaveLoader::load_general(const std::string &savepath)
             game.en_iron_curtain = std::stoi(word);
         }
     }
+    general_log.close();
+    game.fit_view(view);
 }
 
 /**
@@ -988,6 +1351,7 @@ void SaveLoader::load_attack_missiles(const std::string &savepath)
     std::vector<std::string> words;
     std::istringstream iss;
     std::getline(attack_missile_log, line);
+    game.missile_manager.threat_map.reset(game.size); // The saved map may differ in size from "general.txt"
     while (getline(attack_missile_log, line))
     {
         if (line.empty())
@@ -1019,7 +1383,9 @@ void SaveLoader::load_attack_missiles(const std::string &savepath)
                 // NOTE: this will add missile_manager's id by 1
                 AttackMissile *attack_missile = new AttackMissile(id, position, city, damage, speed);
                 attack_missile->is_aimed = is_aimed;
+                attack_missile->route = game.missile_manager.get_flow_field(city);
                 game.missile_manager.missiles.push_back(attack_missile);
+                game.missile_manager.threat_map.add(position, damage);
             }
         }
     }
@@ -7,11 +7,15 @@
 #define SAVER_H
 #include <string>
 #include <vector>
+#include <istream>
+#include <cstdint>
+#include "utils.h"
 #include "game.h"
 
 // forward declarations
 class Game;
 class City;
+struct AssetBundle;
 
 /**
  * @class AssetLoader
@@ -25,6 +29,14 @@ class AssetLoader
 {
 private:
     Game &game;
+    int generator_cities;    ///< Cities to generate instead of loading the map assets, 0 to load them
+    uint32_t generator_seed; ///< Seed of the generated map
+    bool live_stats;         ///< Whether "general.txt" asks for the live stats segment
+    std::string telemetry;   ///< Directory of the telemetry files, empty when disabled
+    int realtime;            ///< Turns per second of the real-time mode, 0 to play turn by turn
+
+    void load_background_text(void);
+    void reset_state(void);
 
 public:
     /**
@@ -32,13 +44,22 @@ public:
      * @detail Default constructor provided for resource initialization
      * @param g Reference to the main game context
      */
-    AssetLoader(Game &g) : game(g) {};
+    AssetLoader(Game &g) : game(g), generator_cities(0), generator_seed(0), live_stats(false), realtime(0) {};
     void load_general(void);
+    void load_general(std::istream &file);
     void load_background(void);
+    void pack_background(void);
+    void generate_assets(Size s, int n, uint32_t seed);
     void load_cities(void);
+    void load_waves(void);
     std::vector<std::string> load_title(void);
     std::vector<std::vector<std::string>> load_video(void);
     void reset(void);
+    void reset(const AssetBundle &bundle);
+    void load_bundle(AssetBundle &bundle);
+    bool is_live_stats(void) const { return live_stats; };
+    const std::string &get_telemetry(void) const { return telemetry; };
+    int get_realtime(void) const { return realtime; };
 };
 
 /**
@@ -0,0 +1,410 @@
+/**
+ * @file screen.cpp
+ * @brief Implementation of the ncurses windows and of painting game frames into them.
+ *
+ * Classes:
+ * - Window: Represents a window in the terminal and provides methods to print text and manage attributes.
+ * - Renderer: Provides debugging functionalities for rendering.
+ * - FrameRenderer: Lays out the game interface and paints captured or received frames into it.
+ *
+ * Dependencies:
+ * - ncurses library for terminal-based UI rendering.
+ * - frame.h: Frames painted by FrameRenderer.
+ */
+
+#include <string>
+#include <vector>
+#include <ncurses.h>
+
+#include "screen.h"
+
+#define ALL_SIZE Size(LINES, COLS)
+
+/**
+* @brief Constructor for the Window class.
+*
+* @param win The parent window.
+* @param s The size of the window.
+* @param p The position of the window.
+*
+*/
+
+Window::Window(WINDOW *win, Size s, Position p) : size(s), pos(p)
+{
+    window = subwin(win, s.h, s.w, p.y, p.x);
+}
+
+/**
+ * @brief Constructor for the Window class.
+ * 
+ * @param win The parent window.
+ * @param s The size of the window.
+ * @param p The position of the window.
+ * 
+ */
+
+Window::Window(Window &win, Size s, Position p) : size(s), pos(p)
+{
+    window = subwin(win.window, s.h, s.w, p.y, p.x);
+}
+
+/**
+ * @brief Prints a character with specified attributes at a given position within the window.
+ * 
+ * This function places a character (`ch`) at the specified position (`p`) in the window,
+ * applying the given attributes (`attr`). If the position is outside the bounds of the
+ * window, the function returns without performing any action.
+ * 
+ * @param p The position (x, y) where the character should be printed. 
+ *          It is represented as a `Position` object.
+ * @param ch The character to be printed, represented as a `chtype`.
+ * @param attr The attributes to be applied to the character, represented as an `attr_t`.
+ *             Attributes can include color, bold, underline, etc.
+ */
+void Window::print(Position p, chtype ch, attr_t attr)
+{
+    if (p.y >= size.h || p.x >= size.w)
+    {
+        return;
+    }
+    wattron(window, attr);
+    mvwaddch(window, p.y, p.x, ch);
+    wattroff(window, attr);
+}
+
+/**
+ * @brief Prints a string with specified attributes at a given position within the window.
+ * 
+ * This function places a string (`s`) at the specified position (`p`) in the window,
+ * applying the given attributes (`attr`). If the position is outside the bounds of the
+ * window, the function returns without performing any action.
+ * 
+ * @param p The position (x, y) where the string should be printed. 
+ *          It is represented as a `Position` object.
+ * @param s The string to be printed, represented as a `const char*`.
+ * @param attr The attributes to be applied to the string, represented as an `attr_t`.
+ *             Attributes can include color, bold, underline, etc.
+ */
+void Window::print(Position p, const char *s, attr_t attr)
+{
+    if (p.y >= size.h || p.x >= size.w)
+    {
+        return;
+    }
+    wattron(window, attr);
+    mvwprintw(window, p.y, p.x, "%s", s);
+    wattroff(window, attr);
+}
+
+
+/**
+ * @brief Prints a line of spaces with the specified attributes in a window.
+ * 
+ * This function fills an entire line of the window with spaces, starting from
+ * the beginning of the line (column 0) and extending to the width of the window.
+ * The spaces are printed with the specified text attributes.
+ * 
+ * @param line The line number (row) in the window where the spaces will be printed.
+ *             If the line number is greater than or equal to the height of the window,
+ *             the function returns without performing any action.
+ * @param attr The text attributes to be applied to the spaces (e.g., color, bold).
+ *             These attributes are applied using `wattron` and removed using `wattroff`.
+ */
+void Window::print_spaces(int line, attr_t attr)
+{
+    if (line >= size.h)
+    {
+        return;
+    }
+    wattron(window, attr);
+    mvwprintw(window, line, 0, "%s", std::string(size.w, ' ').c_str());
+    wattroff(window, attr);
+}
+
+/**
+ * @brief Prints a string aligned to the left at a specified line in the window.
+ * 
+ * This function displays a string `s` starting from the leftmost position of the specified
+ * line in the window. If the string exceeds the width of the window, it is truncated to fit.
+ * The specified attributes `attr` are applied to the string while rendering.
+ * 
+ * @param line The line number (0-based index) where the string will be printed.
+ *             If the line number exceeds the height of the window, the function returns without printing.
+ * @param s The string to be printed.
+ * @param attr The attributes to be applied to the string (e.g., color, bold, etc.).
+ */
+void Window::print_left(int line, const std::string &s, attr_t attr)
+{
+    if (line >= size.h)
+    {
+        return;
+    }
+    wattron(window, attr);
+    mvwprintw(window, line, 0, "%s", s.c_str());
+    if (s.length() > size.w)
+    {
+        mvwprintw(window, line, 0, "%s", s.substr(0, size.w - 1).c_str());
+    }
+    else
+    {
+        mvwprintw(window, line, 0, "%s", s.c_str());
+    }
+    wattroff(window, attr);
+}
+
+/**
+ * @brief Prints a string centered on a specified line within the window.
+ *
+ * This function centers a given string on a specified line of the window.
+ * If the string is longer than the window's width, it truncates the string
+ * to fit within the window. The text is displayed with the specified
+ * attributes.
+ *
+ * @param line The line number (0-based index) where the string will be printed.
+ *             If the line number exceeds the window's height, the function
+ *             returns without performing any action.
+ * @param s The string to be printed.
+ * @param attr The text attributes to be applied (e.g., bold, underline).
+ */
+void Window::print_center(int line, const std::string &s, attr_t attr)
+{
+    if (line >= size.h)
+    {
+        return;
+    }
+    wattron(window, attr);
+    mvwprintw(window, line, (size.w - s.length()) / 2, "%s", s.c_str());
+    if (s.length() > size.w)
+    {
+        mvwprintw(window, line, 0, "%s", s.substr(0, size.w - 1).c_str());
+    }
+    else
+    {
+        mvwprintw(window, line, (size.w - s.length()) / 2, "%s", s.c_str());
+    }
+    wattroff(window, attr);
+}
+
+/**
+ * @brief Prints a string aligned to the right on a specified line within the window.
+ * 
+ * This function displays a string on a specified line of the window, aligning it to the right.
+ * If the string is longer than the window's width, it will be truncated to fit.
+ * The specified attributes are applied to the text during rendering.
+ * 
+ * @param line The line number (0-based index) where the string will be printed.
+ *             If the line number exceeds the window's height, the function returns without action.
+ * @param s The string to be printed. If its length exceeds the window's width, it will be truncated.
+ * @param attr The text attributes to be applied (e.g., color, bold, etc.).
+ */
+void Window::print_right(int line, const std::string &s, attr_t attr)
+{
+    if (line >= size.h)
+    {
+        return;
+    }
+
+    wattron(window, attr);
+    if (s.length() > size.w)
+    {
+        mvwprintw(window, line, 0, "%s", s.substr(0, size.w - 1).c_str());
+    }
+    else
+    {
+        mvwprintw(window, line, size.w - s.length(), "%s", s.c_str());
+    }
+    mvwprintw(window, line, size.w - s.length(), "%s", s.c_str());
+    wattroff(window, attr);
+}
+
+/**
+ * @brief Displays a debug message on the screen at a specified line.
+ * 
+ * This function uses the `mvwprintw` function to print a string to the 
+ * standard screen (`stdscr`) at the specified line number. It is useful 
+ * for debugging purposes to display messages during program execution.
+ * 
+ * @param str The debug message to be displayed.
+ * @param line The line number on the screen where the message will be printed.
+ */
+void Renderer::debug(const std::string &str, int line)
+{
+    mvwprintw(stdscr, line, 1, "%s", str.c_str());
+}
+
+
+/**
+ * @brief Constructs a FrameRenderer with the windows of a game screen layout.
+ * 
+ * @param l Layout giving the map view size, the size of the side and bottom panels,
+ *          and the heights of the information windows.
+ */
+FrameRenderer::FrameRenderer(const FrameLayout &l)
+    : map_size(l.view), info_size(map_size.h + l.side.h + 1, l.side.w),
+      operation_size(l.side.h, map_size.w / 3),
+      feedback_size(l.side.h, map_size.w - map_size.w / 3 - 1),
+      fields(l.fields),
+      pos((ALL_SIZE - map_size - l.side - Size(3, 3)) / 2),
+      box_window(stdscr, map_size + l.side + Size(3, 3), pos),
+      map_window(box_window, map_size, pos + Size(1, 1)),
+      info_window(box_window, info_size, pos + Size(1, map_size.x + 2)),
+      general_info_window(box_window, Size(fields.at(0), info_size.w), pos + Size(1, map_size.x + 2)),
+      selected_info_window(box_window, Size(fields.at(1), info_size.w), pos + Size(fields.at(0) + 2, map_size.x + 2)),
+      tech_info_window(box_window, Size(fields.at(2), info_size.w), pos + Size(fields.at(0) + fields.at(1) + 3, map_size.x + 2)),
+      super_weapon_info_window(box_window, Size(fields.at(3), info_size.w), pos + Size(fields.at(0) + fields.at(1) + fields.at(2) + 4, map_size.x + 2)),
+      operation_window(box_window, operation_size, pos + Size(map_size.y + 2, 1)),
+      feedback_window(box_window, feedback_size, pos + Size(map_size.y + 2, operation_size.x + 2)),
+      frame(l)
+{
+}
+
+/**
+ * @brief Initializes the game renderer by setting up the layout and drawing the UI components.
+ * 
+ * This function erases the current screen and draws the necessary UI elements, including margins, 
+ * horizontal and vertical lines, and various labeled sections for the game interface. It also 
+ * places specific characters at intersections and prints labels for different sections of the UI.
+ * 
+ * The layout is divided into the following sections:
+ * - Map
+ * - General Information
+ * - City & Missile
+ * - Technology & Research
+ * - Super Weapon
+ * - Operation and Feedback
+ * 
+ * The function uses the `box_window` object to draw the UI components and relies on the dimensions 
+ * provided by `map_size`, `info_size`, `operation_size`, and `fields` to determine the positions 
+ * of the elements.
+ * 
+ * @note The function assumes that the `fields` vector contains at least three elements, which 
+ *       represent the heights of the "City & Missile", "Technology & Research", and "Super Weapon" 
+ *       sections, respectively.
+ */
+void FrameRenderer::init(void)
+{
+    erase();
+
+    box_window.draw_margin();
+    box_window.draw_hline(Position(map_size.h + 1, 1), map_size.w);
+    box_window.draw_vline(Position(1, map_size.w + 1), info_size.h);
+    box_window.draw_vline(Position(map_size.h + 2, operation_size.w + 1), operation_size.h);
+    box_window.draw_hline(Position(fields.at(0) + 1, map_size.w + 2), info_size.w);
+    box_window.draw_hline(Position(fields.at(0) + fields.at(1) + 2, map_size.w + 2), info_size.w);
+    box_window.draw_hline(Position(fields.at(0) + fields.at(1) + fields.at(2) + 3, map_size.w + 2), info_size.w);
+
+    box_window.draw_char(Position(map_size.h + 1, 0), ACS_LTEE);
+    box_window.draw_char(Position(map_size.h + 1, map_size.w + 1), ACS_RTEE);
+    box_window.draw_char(Position(0, map_size.w + 1), ACS_TTEE);
+    box_window.draw_char(Position(info_size.h + 1, map_size.w + 1), ACS_BTEE);
+    box_window.draw_char(Position(map_size.h + 1, operation_size.w + 1), ACS_TTEE);
+    box_window.draw_char(Position(map_size.h + operation_size.h + 2, operation_size.w + 1), ACS_BTEE);
+
+    box_window.draw_char(Position(fields.at(0) + 1, map_size.w + 1), ACS_LTEE);
+    box_window.draw_char(Position(fields.at(0) + 1, map_size.w + info_size.w + 2), ACS_RTEE);
+    box_window.draw_char(Position(fields.at(0) + fields.at(1) + 2, map_size.w + 1), ACS_LTEE);
+    box_window.draw_char(Position(fields.at(0) + fields.at(1) + 2, map_size.w + info_size.w + 2), ACS_RTEE);
+    if (fields.at(0) + fields.at(1) + fields.at(2) + 3 == map_size.h + 1)
+    {
+        box_window.draw_char(Position(fields.at(0) + fields.at(1) + fields.at(2) + 3, map_size.w + 1), ACS_PLUS);
+    }
+    else
+    {
+        box_window.draw_char(Position(fields.at(0) + fields.at(1) + fields.at(2) + 3, map_size.w + 1), ACS_LTEE);
+    }
+    box_window.draw_char(Position(fields.at(0) + fields.at(1) + fields.at(2) + 3, map_size.w + info_size.w + 2), ACS_RTEE);
+
+    box_window.print(Position(0, 2), "Map");
+    box_window.print(Position(0, map_size.w + 3), "General");
+    box_window.print(Position(fields.at(0) + 1, map_size.w + 3), "City & Missile");
+    box_window.print(Position(fields.at(0) + fields.at(1) + 2, map_size.w + 3), "Technology & Research");
+    box_window.print(Position(fields.at(0) + fields.at(1) + fields.at(2) + 3, map_size.w + 3), "Super Weapon");
+    box_window.print(Position(map_size.h + 1, 2), "Operation Q/E/ENTER");
+    box_window.print(Position(map_size.h + 1, operation_size.w + 3), "Feedback");
+}
+
+/**
+ * @brief Renders the game interface by refreshing all the relevant windows.
+ * 
+ * This function updates the display of various game interface components,
+ * ensuring that all windows are redrawn with the latest information.
+ * It is responsible for refreshing the following windows:
+ * - Map window
+ * - General information window
+ * - Selected information window
+ * - Technology information window
+ * - Super weapon information window
+ * - Operation window
+ * - Feedback window
+ */
+void FrameRenderer::render(void)
+{
+    map_window.refresh();
+    general_info_window.refresh();
+    selected_info_window.refresh();
+    tech_info_window.refresh();
+    super_weapon_info_window.refresh();
+    operation_window.refresh();
+    feedback_window.refresh();
+    // refresh();
+}
+
+/**
+ * @brief Clears every subwindow and paints a frame into it.
+ *
+ * @param f Frame to paint, with the layout of this renderer.
+ */
+void FrameRenderer::paint(const Frame &f)
+{
+    // Clear all subwindows
+    map_window.erase();
+    general_info_window.erase();
+    selected_info_window.erase();
+    tech_info_window.erase();
+    super_weapon_info_window.erase();
+    operation_window.erase();
+    feedback_window.erase();
+
+    // NOTE: draw map window
+    const Size &view = f.get_layout().view;
+    for (int line = 0; line < view.h && line < map_size.h; line++)
+    {
+        for (int col = 0; col < view.w && col < map_size.w; col++)
+        {
+            const FrameCell &cell = f.get_cell(Position(line, col));
+            if (cell.glyph < 0x80)
+            {
+                map_window.print(Position(line, col), chtype(cell.glyph), COLOR_PAIR(cell.color));
+            }
+            else
+            {
+                map_window.print(Position(line, col), Frame::to_utf8(cell.glyph), COLOR_PAIR(cell.color));
+            }
+        }
+    }
+
+    // NOTE: draw panels span by span, later spans overwrite earlier ones
+    Window *windows[PANEL_COUNT] = {&general_info_window, &selected_info_window, &tech_info_window,
+                                    &super_weapon_info_window, &operation_window, &feedback_window};
+    for (int panel = 0; panel < PANEL_COUNT; panel++)
+    {
+        for (int line = 0; line < f.get_lines(panel); line++)
+        {
+            for (auto &span : f.get_line(panel, line))
+            {
+                switch (span.align)
+                {
+                case SpanAlign::FILL:
+                    windows[panel]->print_spaces(line, span.attr);
+                    break;
+                case SpanAlign::LEFT:
+                    windows[panel]->print_left(line, span.text, span.attr);
+                    break;
+                case SpanAlign::RIGHT:
+                    windows[panel]->print_right(line, span.text, span.attr);
+                    break;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,144 @@
+/**
+ * @file screen.h
+ * @brief Declares the ncurses windows and the renderer painting game frames into them
+ *
+ * Needs no game state, so the thin client links it without the simulation.
+ */
+
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include <string>
+#include <vector>
+#include <ncurses.h>
+#include "frame.h"
+#include "utils.h"
+
+/**
+ * @class Window
+ * @brief Encapsulates ncurses window management
+ *
+ * @var WINDOW *window Pointer to the ncurses window
+ * @var Size size Size of the window
+ * @var Position pos Position of the window on the screen
+ *
+ * Provides methods for drawing characters, lines, and text within the window.
+ * Also includes methods for refreshing and erasing the window.
+ */
+class Window
+{
+private:
+    WINDOW *window;
+    Size size;
+    Position pos;
+
+public:
+    Window(WINDOW *win, Size s, Position p);
+    Window(Window &win, Size s, Position p);
+    ~Window(void) { delwin(window); };
+
+    /// @name refresh/erase
+    /// @{
+    void refresh(void) { wrefresh(window); };
+    void erase(void) { werase(window); };
+    /// @}
+
+    /// @name margin/line drawing
+    /// @{
+    void draw_margin(void) { box(window, 0, 0); };
+    void draw_hline(Position p, int len) { mvwhline(window, p.y, p.x, ACS_HLINE, len); };
+    void draw_vline(Position p, int len) { mvwvline(window, p.y, p.x, ACS_VLINE, len); };
+    void draw_char(Position p, chtype ch) { mvwaddch(window, p.y, p.x, ch); };
+    /// @}
+
+    /// @name char/text printing
+    /// @{
+    void print(Position p, chtype ch, attr_t attr = A_NORMAL);
+    void print(Position p, const char *s, attr_t = A_NORMAL);
+    void print(Position p, const std::string &s, attr_t attr = A_NORMAL) { print(p, s.c_str(), attr); };
+    void print(Position p, const AttrString &s) { print(p, s.str, s.attr); };
+    void print_spaces(int line, attr_t = A_NORMAL);
+    void print_left(int line, const std::string &s, attr_t attr = A_NORMAL);
+    void print_left(int line, const AttrString &s) { print_left(line, s.str, s.attr); };
+    void print_center(int line, const std::string &s, attr_t attr = A_NORMAL);
+    void print_center(int line, const AttrString &s) { print_center(line, s.str, s.attr); };
+    void print_right(int line, const std::string &s, attr_t attr = A_NORMAL);
+    void print_right(int line, const AttrString &s) { print_right(line, s.str, s.attr); };
+    /// @}
+};
+
+/**
+ * @class Renderer
+ * @brief Abstract base class for all UI renderers
+ *
+ * Defines common interface for initializing, updating and drawing
+ * ncurses-based UI components. Provides debug utilities.
+ */
+class Renderer
+{
+public:
+    /**
+     * @brief Main rendering entry point
+     * @details Updates all visual components
+     */
+    virtual void render(void) = 0;
+    /**
+     * @brief Initialize renderer resources
+     * @details Creates windows and sets up initial UI state
+     */
+    virtual void init(void) = 0;
+    /**
+     * @brief Commit changes to physical screen
+     * @details Performs final refresh operations on all windows
+     */
+    virtual void draw(void) = 0;
+
+    /**
+     * @brief Output debug information
+     * @param str Debug message to display
+     * @param line Optional line number (0-based) in debug area
+     */
+    void debug(const std::string &str, int line = 0);
+};
+
+/**
+ * @class FrameRenderer
+ * @brief Game screen layout painted from a Frame
+ *
+ * Owns the windows of the game screen and paints frames into them, whether captured
+ * locally or received from a server. It needs no Game, so a thin client can use it.
+ */
+class FrameRenderer : public Renderer
+{
+protected:
+    Size map_size;
+    Size info_size;
+    Size operation_size;
+    Size feedback_size;
+    std::vector<int> fields;
+    Position pos;
+
+    Window box_window; ///< Master border window
+    Window map_window; ///< Tactical map display
+    Window info_window;
+    Window general_info_window;      ///< Player stats/status
+    Window selected_info_window;     ///< Selected entity details
+    Window tech_info_window;         ///< Research progress
+    Window super_weapon_info_window; ///< Special weapons status
+    Window operation_window;         ///< Command interface
+    Window feedback_window;          ///< System messages/notifications
+
+    Frame frame; ///< Frame painted by draw
+
+public:
+    FrameRenderer(const FrameLayout &l);
+
+    void init(void);
+    void render(void);
+    void draw(void) { paint(frame); };
+    void paint(const Frame &f); ///< Paint a captured or received frame
+    const FrameLayout &get_layout(void) const { return frame.get_layout(); };
+    const Frame &get_frame(void) const { return frame; }; ///< Frame painted by the last draw
+};
+
+#endif
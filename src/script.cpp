@@ -0,0 +1,393 @@
+/**
+ * @file script.cpp
+ * @brief Implementation of the headless script driver.
+ *
+ * Classes:
+ * - ScriptRunner: Parses script lines, applies them to the game and prints feedback,
+ *   game over and state dumps.
+ *
+ * Dependencies:
+ * - script.h: Declaration of the ScriptRunner class.
+ * - game.h: Game, cities, tech tree and missiles being driven.
+ * - saver.h: Asset, save and load handling for the level, load and save commands.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include "script.h"
+
+/**
+ * @brief Splits a script line into words. A double-quoted word may contain spaces.
+ *
+ * @param line Line to split.
+ * @return std::vector<std::string>: Words of the line, quotes removed.
+ * @throws std::runtime_error If a quote is not closed.
+ */
+static std::vector<std::string> split_line(const std::string &line)
+{
+    std::vector<std::string> words;
+    size_t index = 0;
+    while (true)
+    {
+        index = line.find_first_not_of(" \t\r", index);
+        if (index == std::string::npos)
+        {
+            break;
+        }
+        if (line[index] == '"')
+        {
+            size_t end = line.find('"', index + 1);
+            if (end == std::string::npos)
+            {
+                throw std::runtime_error("unterminated quote");
+            }
+            words.push_back(line.substr(index + 1, end - index - 1));
+            index = end + 1;
+        }
+        else
+        {
+            size_t end = line.find_first_of(" \t\r", index);
+            words.push_back(line.substr(index, end == std::string::npos ? std::string::npos : end - index));
+            index = end;
+        }
+    }
+    return words;
+}
+
+/**
+ * @brief Joins the arguments of a command back into one name, so that `select New York`
+ * works without quotes.
+ *
+ * @param arguments Arguments of the command.
+ * @return std::string: The arguments separated by single spaces.
+ */
+static std::string join_arguments(const std::vector<std::string> &arguments)
+{
+    std::string name;
+    for (const auto &argument : arguments)
+    {
+        name += (name.empty() ? "" : " ") + argument;
+    }
+    return name;
+}
+
+/**
+ * @brief Reads a whole number argument.
+ *
+ * @param word Argument to read.
+ * @return long long: Its value.
+ * @throws std::runtime_error If the argument is not a number.
+ */
+static long long parse_number(const std::string &word)
+{
+    size_t length = 0;
+    long long value = 0;
+    try
+    {
+        value = std::stoll(word, &length);
+    }
+    catch (const std::exception &e)
+    {
+        length = 0;
+    }
+    if (length == 0 || length != word.size())
+    {
+        throw std::runtime_error("not a number: " + word);
+    }
+    return value;
+}
+
+/**
+ * @brief Constructor for the ScriptRunner class.
+ *
+ * @param g Game to drive. "general.txt" must already be loaded through `a`.
+ * @param a Asset loader of the game.
+ * @param o Stream receiving the output of the commands.
+ */
+ScriptRunner::ScriptRunner(Game &g, AssetLoader &a, std::ostream &o)
+    : game(g), asset_loader(a), save_dumper(g), save_loader(g), output(o), is_started(false), is_over(false)
+{
+    operations["fix_city"] = &Game::fix_city;
+    operations["build_cruise"] = &Game::build_cruise;
+    operations["launch_cruise"] = &Game::launch_cruise;
+    operations["build_standard_bomb"] = &Game::build_standard_bomb;
+    operations["launch_standard_bomb"] = &Game::launch_standard_bomb;
+    operations["build_dirty_bomb"] = &Game::build_dirty_bomb;
+    operations["launch_dirty_bomb"] = &Game::launch_dirty_bomb;
+    operations["build_hydrogen_bomb"] = &Game::build_hydrogen_bomb;
+    operations["launch_hydrogen_bomb"] = &Game::launch_hydrogen_bomb;
+    operations["activate_iron_curtain"] = &Game::activate_iron_curtain;
+}
+
+/**
+ * @brief Marks a game as freshly started or loaded, and opens its telemetry file if
+ * "general.txt" asks for one.
+ *
+ */
+void ScriptRunner::start(void)
+{
+    if (!asset_loader.get_telemetry().empty())
+    {
+        game.set_telemetry(std::unique_ptr<TelemetryWriter>(new TelemetryWriter(asset_loader.get_telemetry())));
+    }
+    is_started = true;
+    is_over = false;
+}
+
+/**
+ * @brief Checks that a command has a game to act on.
+ *
+ * @param is_read_only Whether the command leaves the game unchanged, and so may still run
+ * once the game is over.
+ * @throws std::runtime_error If no game was started or loaded, or the game is over and
+ * the command would change it.
+ */
+void ScriptRunner::require_game(bool is_read_only) const
+{
+    if (!is_started)
+    {
+        throw std::runtime_error("no game: start one with `level` or `load` first");
+    }
+    if (is_over && !is_read_only)
+    {
+        throw std::runtime_error("the game is over");
+    }
+}
+
+/**
+ * @brief Prints the feedback messages inserted since the last call, then forgets them.
+ *
+ */
+void ScriptRunner::print_feedbacks(void)
+{
+    for (const auto &feedback : game.feedbacks)
+    {
+        output << "feedback " << feedback.str << '\n';
+    }
+    game.feedbacks.clear();
+}
+
+/**
+ * @brief Prints the state of the game, one `key value` per line, ending with `end`.
+ *
+ */
+void ScriptRunner::dump_state(void)
+{
+    output << "level " << game.difficulty_level << '\n';
+    output << "turn " << game.turn << '\n';
+    output << "deposit " << game.deposit << '\n';
+    output << "productivity " << game.get_productivity() << '\n';
+    output << "enemy_hp " << game.enemy_hitpoint << '\n';
+    output << "score " << game.score << '\n';
+    output << "casualty " << game.casualty << '\n';
+    output << "cursor " << game.cursor.y << ' ' << game.cursor.x << '\n';
+    for (const auto &city : game.cities)
+    {
+        output << "city \"" << city.name << "\" " << city.hitpoint << ' ' << city.productivity << ' '
+               << city.cruise_storage << '\n';
+    }
+    output << "attack_missiles " << game.missile_manager.get_attack_missiles().size() << '\n';
+    output << "cruise_missiles " << game.missile_manager.get_cruise_missiles().size() << '\n';
+    output << "standard_bomb " << game.standard_bomb_counter << '\n';
+    output << "dirty_bomb " << game.dirty_bomb_counter << '\n';
+    output << "hydrogen_bomb " << game.hydrogen_bomb_counter << '\n';
+    output << "iron_curtain " << game.iron_curtain_counter << '\n';
+    const TechTree &tech_tree = game.tech_tree;
+    if (tech_tree.researching != nullptr)
+    {
+        output << "researching \"" << tech_tree.researching->name << "\" " << tech_tree.remaining_time << '\n';
+    }
+    for (const auto node : tech_tree.researched)
+    {
+        output << "researched \"" << node->name << "\"" << '\n';
+    }
+    output << "hash " << std::hex << std::setw(16) << std::setfill('0') << game.get_state_hash() << std::dec
+           << std::setfill(' ') << '\n';
+    output << "end" << '\n';
+}
+
+/**
+ * @brief Runs one command.
+ *
+ * @param command Name of the command.
+ * @param arguments Its arguments.
+ * @return bool: False if the script should stop.
+ * @throws std::runtime_error If the command is unknown, malformed or cannot run now.
+ */
+bool ScriptRunner::execute(const std::string &command, const std::vector<std::string> &arguments)
+{
+    auto operation = operations.find(command);
+    if (operation != operations.end())
+    {
+        require_game();
+        (game.*(operation->second))();
+    }
+    else if (command == "level")
+    {
+        if (arguments.empty() || arguments.size() > 2)
+        {
+            throw std::runtime_error("usage: level N [SEED]");
+        }
+        int level = parse_number(arguments[0]);
+        if (level < 1 || level > 3)
+        {
+            throw std::runtime_error("no such level: " + arguments[0]);
+        }
+        asset_loader.reset();
+        game.set_difficulty(level);
+        if (arguments.size() == 2)
+        {
+            game.missile_manager.set_seed(parse_number(arguments[1]));
+        }
+        start();
+    }
+    else if (command == "load" || command == "save")
+    {
+        if (arguments.size() != 1)
+        {
+            throw std::runtime_error("usage: " + command + " SLOT");
+        }
+        if (command == "load")
+        {
+            if (save_loader.is_slot_empty(arguments[0]))
+            {
+                throw std::runtime_error("slot " + arguments[0] + " is empty");
+            }
+            asset_loader.reset();
+            save_loader.load_game(arguments[0]);
+            start();
+        }
+        else
+        {
+            require_game(true);
+            if (!save_dumper.save_game(arguments[0]))
+            {
+                throw std::runtime_error("cannot save to slot " + arguments[0]);
+            }
+        }
+    }
+    else if (command == "turn")
+    {
+        long long count = arguments.empty() ? 1 : parse_number(arguments[0]);
+        require_game();
+        for (long long index = 0; index < count; index++)
+        {
+            game.pass_turn();
+            bool is_game_over = game.check_game_over();
+            print_feedbacks(); // NOTE: the game only keeps the last few messages, so print them every turn
+            if (is_game_over)
+            {
+                is_over = true;
+                output << "game_over " << (game.enemy_hitpoint <= 0 ? "win" : "lose") << '\n';
+                break;
+            }
+        }
+    }
+    else if (command == "select")
+    {
+        require_game();
+        std::string name = join_arguments(arguments);
+        size_t index = 0;
+        while (index < game.cities.size() && game.cities[index].name != name)
+        {
+            index++;
+        }
+        if (index == game.cities.size())
+        {
+            throw std::runtime_error("no such city: " + name);
+        }
+        game.move_cursor_to_city(index);
+    }
+    else if (command == "cursor")
+    {
+        if (arguments.size() != 2)
+        {
+            throw std::runtime_error("usage: cursor Y X");
+        }
+        require_game();
+        Position target(parse_number(arguments[0]), parse_number(arguments[1]));
+        if (!game.is_in_map(target))
+        {
+            throw std::runtime_error("outside of the map: " + arguments[0] + " " + arguments[1]);
+        }
+        game.move_cursor(target - game.cursor);
+    }
+    else if (command == "research")
+    {
+        require_game();
+        std::string name = join_arguments(arguments);
+        TechTree &tech_tree = game.tech_tree;
+        TechNode *node = nullptr;
+        for (auto candidate : tech_tree.nodes)
+        {
+            if (candidate->name == name)
+            {
+                node = candidate;
+            }
+        }
+        if (node == nullptr)
+        {
+            throw std::runtime_error("no such technology: " + name);
+        }
+        tech_tree.update_available(game.deposit);
+        game.start_research(node);
+        game.check_research();
+        if (tech_tree.researching != node && !tech_tree.is_researched(node))
+        {
+            // NOTE: a refused research is part of the game, like an order on a wrong selection
+            output << "rejected research \"" << name << "\"" << '\n';
+        }
+    }
+    else if (command == "dump-state")
+    {
+        require_game(true);
+        dump_state();
+    }
+    else if (command == "quit")
+    {
+        return false;
+    }
+    else
+    {
+        throw std::runtime_error("unknown command: " + command);
+    }
+    print_feedbacks();
+    return true;
+}
+
+/**
+ * @brief Runs a script until its end or a `quit` command.
+ *
+ * @param input Script to run.
+ * @throws std::runtime_error On the first failing command, with its line number.
+ */
+void ScriptRunner::run(std::istream &input)
+{
+    std::string line;
+    int number = 0;
+    while (std::getline(input, line))
+    {
+        number++;
+        try
+        {
+            std::vector<std::string> words = split_line(line);
+            if (words.empty() || words[0][0] == '#')
+            {
+                continue;
+            }
+            if (!execute(words[0], std::vector<std::string>(words.begin() + 1, words.end())))
+            {
+                break;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            throw std::runtime_error("line " + std::to_string(number) + ": " + e.what());
+        }
+    }
+}
@@ -0,0 +1,65 @@
+/**
+ * @file script.h
+ * @brief Headless command driver for regression and load scripts
+ *
+ * `main --script [FILE]` reads one command per line from FILE, or from stdin when FILE
+ * is omitted or `-`, and runs it against Game directly: no terminal, no rendering and no
+ * frame delay between turns. Blank lines and lines starting with `#` are skipped; an
+ * argument made of several words may be quoted.
+ *
+ * Commands:
+ * - `level N [SEED]`: Start a new game at difficulty N, optionally with a fixed seed.
+ * - `load SLOT` / `save SLOT`: Load or save a game slot, as the load and save menus do.
+ * - `turn [N]`: Pass N turns (1 by default), stopping early when the game is over.
+ * - `select CITY` / `cursor Y X`: Move the cursor onto a city, or to a map cell.
+ * - `fix_city`, `build_cruise`, `launch_cruise`, `build_standard_bomb`, `launch_standard_bomb`,
+ *   `build_dirty_bomb`, `launch_dirty_bomb`, `build_hydrogen_bomb`, `launch_hydrogen_bomb`,
+ *   `activate_iron_curtain`: Give the order on the selection under the cursor.
+ * - `research NAME`: Start researching a technology.
+ * - `dump-state`: Print the state of the game, one `key value` per line.
+ * - `quit`: Stop reading the script.
+ *
+ * Every feedback message a command causes is printed as `feedback <message>`, and the end
+ * of the game as `game_over win|lose`. After that, only `dump-state`, `save`, `level`,
+ * `load` and `quit` are accepted, so a script can still read the final state.
+ */
+
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include "game.h"
+#include "saver.h"
+
+/**
+ * @class ScriptRunner
+ * @brief Runs script commands against a game and reports their outcome on a stream.
+ */
+class ScriptRunner
+{
+private:
+    Game &game;
+    AssetLoader &asset_loader;
+    SaveDumper save_dumper;
+    SaveLoader save_loader;
+    std::ostream &output;
+    std::map<std::string, void (Game::*)(void)> operations; ///< Orders given on the selection
+    bool is_started; ///< A game was started or loaded
+    bool is_over;    ///< The game has ended, no more turns can be passed
+
+    void start(void);
+    void require_game(bool is_read_only = false) const;
+    void print_feedbacks(void);
+    void dump_state(void);
+    bool execute(const std::string &command, const std::vector<std::string> &arguments);
+
+public:
+    ScriptRunner(Game &g, AssetLoader &a, std::ostream &o);
+
+    void run(std::istream &input); ///< Run every command of a script
+};
+
+#endif
@@ -0,0 +1,642 @@
+/**
+ * @file server.cpp
+ * @brief Implementation of the multi-session game server.
+ *
+ * Classes:
+ * - GameSession: Runs one client's game and streams frame deltas to it.
+ * - ServerWorker: Waits on the sessions of one shard with epoll and handles their I/O.
+ * - GameServer: Loads the shared assets, accepts clients and deals them out to workers.
+ * - FrameBroadcaster: Fans the frames of a game out to read-only spectators.
+ *
+ * Dependencies:
+ * - server.h: Declarations of the server classes and the AssetBundle.
+ * - frame.h: Frame capture, delta encoding and message framing.
+ * - POSIX sockets, epoll and eventfd (Linux).
+ */
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include "server.h"
+
+/**
+ * @brief Constructs a session on an accepted, non-blocking connection.
+ *
+ * @param f Connection socket, owned and closed by the session.
+ * @param b Assets the game is reset from.
+ * @param layout Screen layout of the clients.
+ */
+GameSession::GameSession(int f, const AssetBundle &b, const FrameLayout &layout)
+    : fd(f), bundle(b), game(), loader(game), menu(game), next(layout), is_started(false), is_closing(false)
+{
+    game.get_missile_manager().set_async(false); // NOTE: the session already runs on a server worker
+}
+
+/**
+ * @brief Waits for the game's pending wave plan and forecast, and closes the connection.
+ *
+ */
+GameSession::~GameSession(void)
+{
+    game.get_missile_manager().cancel_attack_wave();
+    game.get_missile_manager().cancel_forecast();
+    close(fd);
+}
+
+/**
+ * @brief Reads everything the client sent and handles each complete message.
+ * The screen is captured once per batch of messages, not once per key.
+ *
+ * @return bool: False if the client disconnected or sent a malformed stream.
+ */
+bool GameSession::receive(void)
+{
+    char buffer[4096];
+    while (true)
+    {
+        ssize_t length = read(fd, buffer, sizeof(buffer));
+        if (length > 0)
+        {
+            inbox.append(buffer, length);
+        }
+        else if (length == 0)
+        {
+            return false;
+        }
+        else if (errno == EINTR)
+        {
+            continue;
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            break;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    try
+    {
+        MessageType type;
+        std::string payload;
+        bool is_handled = false;
+        while (!is_closing && Message::unpack(inbox, type, payload))
+        {
+            handle(type, payload);
+            is_handled = true;
+        }
+        if (is_handled && is_started)
+        {
+            send_frame();
+            if (!is_closing && game.check_game_over())
+            {
+                std::string result;
+                Message::put_u32(result, game.get_score());
+                Message::put_u32(result, game.get_turn());
+                Message::put_u32(result, game.get_casualty());
+                outbox += Message::pack(MessageType::END, result);
+                is_closing = true;
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Handles one message from the client.
+ *
+ * @param type Kind of the message.
+ * @param payload Message body.
+ */
+void GameSession::handle(MessageType type, const std::string &payload)
+{
+    if (type == MessageType::HELLO && !is_started)
+    {
+        int level = payload.empty() ? 1 : uint8_t(payload[0]);
+        loader.reset(bundle);
+        game.set_difficulty(level);
+        menu.update_items();
+        sent = Frame(); // NOTE: no layout yet, so the first frame goes out as a keyframe
+        is_started = true;
+    }
+    else if (type == MessageType::KEY && is_started && payload.size() == 4)
+    {
+        if (menu.handle_key(int32_t(Message::get_u32(payload, 0))) == GameCommand::QUIT)
+        {
+            is_closing = true;
+        }
+        menu.update_items(); // Research and pause menus are not served, their keys do nothing
+    }
+}
+
+/**
+ * @brief Captures the screen and queues its difference from the frame the client holds.
+ * Nothing is queued when the screen did not change.
+ *
+ */
+void GameSession::send_frame(void)
+{
+    next.capture(game, menu);
+    std::string delta = Frame::encode_delta(sent, next);
+    if (!Frame::is_empty_delta(delta))
+    {
+        outbox += Message::pack(MessageType::FRAME, delta);
+    }
+    sent = next; // NOTE: a copy, `next` keeps the layout for the following captures
+}
+
+/**
+ * @brief Writes queued output until the socket would block.
+ *
+ * @return bool: False if the connection failed.
+ */
+bool GameSession::flush(void)
+{
+    size_t written = 0;
+    while (written < outbox.size())
+    {
+        ssize_t length = send(fd, outbox.data() + written, outbox.size() - written, MSG_NOSIGNAL);
+        if (length > 0)
+        {
+            written += length;
+        }
+        else if (length < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        else if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            break;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    outbox.erase(0, written);
+    return true;
+}
+
+/**
+ * @brief Creates the worker's epoll instance and wake-up eventfd. The thread starts with start().
+ *
+ * @param b Assets the sessions are reset from.
+ * @param l Screen layout of the clients.
+ * @throws std::runtime_error If the descriptors cannot be created.
+ */
+ServerWorker::ServerWorker(const AssetBundle &b, const FrameLayout &l)
+    : bundle(b), layout(l), is_stopping(false)
+{
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd < 0 || wake_fd < 0)
+    {
+        throw std::runtime_error(std::string("Cannot create server worker: ") + std::strerror(errno));
+    }
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.fd = wake_fd;
+    epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+}
+
+/**
+ * @brief Stops the thread, then closes every session and descriptor.
+ *
+ */
+ServerWorker::~ServerWorker(void)
+{
+    if (thread.joinable())
+    {
+        is_stopping = true;
+        uint64_t one = 1;
+        if (write(wake_fd, &one, sizeof(one)) < 0)
+        {
+            // NOTE: the counter is already non-zero, the thread wakes up anyway
+        }
+        thread.join();
+    }
+    sessions.clear();
+    for (int fd : incoming)
+    {
+        close(fd);
+    }
+    close(wake_fd);
+    close(epoll_fd);
+}
+
+/**
+ * @brief Hands an accepted connection over to this worker. Safe to call from any thread.
+ *
+ * @param fd Connection socket.
+ */
+void ServerWorker::add(int fd)
+{
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        incoming.push_back(fd);
+    }
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0)
+    {
+        // NOTE: the counter is already non-zero, the thread wakes up anyway
+    }
+}
+
+/**
+ * @brief Registers a session with epoll, or updates its interest in writability.
+ *
+ * @param session Session to watch.
+ * @param is_new Whether the session is not registered yet.
+ */
+void ServerWorker::watch(GameSession &session, bool is_new)
+{
+    epoll_event event;
+    event.events = EPOLLIN | (session.is_pending() ? uint32_t(EPOLLOUT) : 0);
+    event.data.fd = session.get_fd();
+    epoll_ctl(epoll_fd, is_new ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, session.get_fd(), &event);
+}
+
+/**
+ * @brief Unregisters and destroys a session.
+ *
+ * @param fd Connection socket of the session.
+ */
+void ServerWorker::drop(int fd)
+{
+    epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    sessions.erase(fd);
+}
+
+/**
+ * @brief Event loop of the worker thread.
+ * Output is written straight after handling input; EPOLLOUT is only watched while a
+ * slow client leaves output pending.
+ *
+ */
+void ServerWorker::run(void)
+{
+    epoll_event events[64];
+    while (!is_stopping)
+    {
+        int count = epoll_wait(epoll_fd, events, 64, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        for (int index = 0; index < count; index++)
+        {
+            int fd = events[index].data.fd;
+            if (fd == wake_fd)
+            {
+                uint64_t counter;
+                if (read(wake_fd, &counter, sizeof(counter)) < 0)
+                {
+                    // NOTE: spurious wake-up, nothing to reset
+                }
+                std::vector<int> accepted;
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    accepted.swap(incoming);
+                }
+                for (int client : accepted)
+                {
+                    std::unique_ptr<GameSession> session(new GameSession(client, bundle, layout));
+                    watch(*session, true);
+                    sessions[client] = std::move(session);
+                }
+                continue;
+            }
+
+            auto found = sessions.find(fd);
+            if (found == sessions.end())
+            {
+                continue;
+            }
+            GameSession &session = *found->second;
+            bool is_alive = true;
+            if (events[index].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+            {
+                is_alive = session.receive();
+            }
+            bool was_pending = session.is_pending();
+            if (is_alive)
+            {
+                is_alive = session.flush();
+            }
+            if (!is_alive || session.is_done())
+            {
+                drop(fd);
+            }
+            else if (was_pending != session.is_pending() || (events[index].events & EPOLLOUT))
+            {
+                watch(session, false);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Loads the shared assets, binds the socket and starts the workers.
+ *
+ * @param p Path of the UNIX socket, replaced if it exists.
+ * @param worker_count Number of worker threads, at least one.
+ * @param layout Screen layout of the clients.
+ * @throws std::runtime_error If an asset cannot be loaded or the socket cannot be bound.
+ */
+GameServer::GameServer(const std::string &p, int worker_count, const FrameLayout &layout)
+    : path(p), listener(-1)
+{
+    Game scratch;
+    AssetLoader(scratch).load_bundle(bundle);
+    scratch.get_missile_manager().cancel_attack_wave();
+
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    std::strcpy(address.sun_path, path.c_str());
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    unlink(path.c_str());
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(listener, 128) < 0)
+    {
+        throw std::runtime_error("Cannot listen on " + path + ": " + std::strerror(errno));
+    }
+
+    for (int index = 0; index < std::max(1, worker_count); index++)
+    {
+        workers.push_back(std::unique_ptr<ServerWorker>(new ServerWorker(bundle, layout)));
+        workers.back()->start();
+    }
+}
+
+/**
+ * @brief Stops the workers and removes the socket.
+ *
+ */
+GameServer::~GameServer(void)
+{
+    workers.clear();
+    if (listener >= 0)
+    {
+        close(listener);
+        unlink(path.c_str());
+    }
+}
+
+/**
+ * @brief Accepts connections and deals them out to the workers round-robin.
+ *
+ * @throws std::runtime_error If accepting fails for a reason other than an interrupt.
+ */
+void GameServer::run(void)
+{
+    for (size_t next = 0;; next++)
+    {
+        int client = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            throw std::runtime_error(std::string("Cannot accept client: ") + std::strerror(errno));
+        }
+        workers[next % workers.size()]->add(client);
+    }
+}
+
+/**
+ * @brief Listens for spectators on a UNIX socket. Connections are accepted by publish().
+ *
+ * @param p Path of the UNIX socket, replaced if it exists.
+ * @throws std::runtime_error If the socket cannot be bound.
+ */
+FrameBroadcaster::FrameBroadcaster(const std::string &p)
+    : path(p), listener(-1)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+        throw std::runtime_error("Socket path too long: " + path);
+    }
+    std::strcpy(address.sun_path, path.c_str());
+    listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(path.c_str());
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(listener, 16) < 0)
+    {
+        throw std::runtime_error("Cannot listen on " + path + ": " + std::strerror(errno));
+    }
+}
+
+/**
+ * @brief Disconnects every spectator and removes the socket.
+ *
+ */
+FrameBroadcaster::~FrameBroadcaster(void)
+{
+    for (auto &spectator : spectators)
+    {
+        close(spectator.fd);
+    }
+    if (listener >= 0)
+    {
+        close(listener);
+        unlink(path.c_str());
+    }
+}
+
+/**
+ * @brief Accepts every waiting spectator. New spectators are sent a keyframe first.
+ *
+ */
+void FrameBroadcaster::accept_spectators(void)
+{
+    int fd;
+    while ((fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+    {
+        Spectator spectator = {fd, std::deque<Buffer>(), 0, 0, false};
+        spectators.push_back(spectator);
+    }
+}
+
+/**
+ * @brief Queues a message to a spectator, dropping its backlog if it lags too far behind.
+ * A message partly written already is kept, so the stream stays well-formed.
+ *
+ * @param spectator Spectator to send to.
+ * @param buffer Packed message shared with the other spectators.
+ */
+void FrameBroadcaster::queue(Spectator &spectator, const Buffer &buffer)
+{
+    if (spectator.pending > MAX_BACKLOG)
+    {
+        size_t keep = spectator.offset > 0 ? 1 : 0;
+        while (spectator.backlog.size() > keep)
+        {
+            spectator.pending -= spectator.backlog.back()->size();
+            spectator.backlog.pop_back();
+        }
+        spectator.is_synced = false;
+        return;
+    }
+    spectator.backlog.push_back(buffer);
+    spectator.pending += buffer->size();
+}
+
+/**
+ * @brief Writes as much of a spectator's backlog as its socket takes, gathering the
+ * shared messages into one sendmsg call (writev with MSG_NOSIGNAL).
+ *
+ * @param spectator Spectator to write to.
+ * @return bool: False if the spectator disconnected.
+ */
+bool FrameBroadcaster::write(Spectator &spectator)
+{
+    while (!spectator.backlog.empty())
+    {
+        iovec parts[64];
+        size_t count = 0;
+        for (auto it = spectator.backlog.begin(); it != spectator.backlog.end() && count < 64; ++it, ++count)
+        {
+            size_t skip = count == 0 ? spectator.offset : 0;
+            parts[count].iov_base = const_cast<char *>((*it)->data() + skip);
+            parts[count].iov_len = (*it)->size() - skip;
+        }
+        msghdr message;
+        std::memset(&message, 0, sizeof(message));
+        message.msg_iov = parts;
+        message.msg_iovlen = count;
+        ssize_t length = sendmsg(spectator.fd, &message, MSG_NOSIGNAL);
+        if (length < 0)
+        {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+
+        spectator.pending -= length;
+        size_t written = length + spectator.offset;
+        while (!spectator.backlog.empty() && written >= spectator.backlog.front()->size())
+        {
+            written -= spectator.backlog.front()->size();
+            spectator.backlog.pop_front();
+        }
+        spectator.offset = written;
+        if (length == 0 || spectator.offset > 0)
+        {
+            break; // The socket buffer is full
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Sends a frame to every spectator: its delta from the last frame to the synced
+ * ones, a keyframe to the others. Each is encoded at most once, however many watch.
+ *
+ * @param frame Frame just painted by the game.
+ */
+void FrameBroadcaster::publish(const Frame &frame)
+{
+    accept_spectators();
+    if (spectators.empty())
+    {
+        return; // NOTE: `last` may go stale, as every new spectator starts with a keyframe
+    }
+
+    Buffer delta, keyframe;
+    bool is_delta_encoded = false;
+    for (auto &spectator : spectators)
+    {
+        if (!spectator.is_synced)
+        {
+            if (!keyframe)
+            {
+                keyframe = std::make_shared<const std::string>(Message::pack(MessageType::FRAME, Frame::encode_keyframe(frame)));
+            }
+            if (spectator.pending <= MAX_BACKLOG) // Otherwise wait for the backlog to drain
+            {
+                queue(spectator, keyframe);
+                spectator.is_synced = true;
+            }
+        }
+        else
+        {
+            if (!is_delta_encoded)
+            {
+                std::string bytes = Frame::encode_delta(last, frame);
+                if (!Frame::is_empty_delta(bytes))
+                {
+                    delta = std::make_shared<const std::string>(Message::pack(MessageType::FRAME, bytes));
+                }
+                is_delta_encoded = true;
+            }
+            if (delta)
+            {
+                queue(spectator, delta);
+            }
+        }
+    }
+
+    auto gone = std::remove_if(spectators.begin(), spectators.end(), [this](Spectator &spectator)
+                               {
+                                   if (write(spectator))
+                                   {
+                                       return false;
+                                   }
+                                   close(spectator.fd);
+                                   return true; });
+    spectators.erase(gone, spectators.end());
+    last = frame;
+}
+
+/**
+ * @brief Sends the result of the game to every spectator and disconnects them.
+ * Output a spectator cannot take right away is dropped.
+ *
+ * @param score Final score.
+ * @param turn Turns played.
+ * @param casualty Total casualties.
+ */
+void FrameBroadcaster::finish(int score, int turn, int casualty)
+{
+    std::string result;
+    Message::put_u32(result, score);
+    Message::put_u32(result, turn);
+    Message::put_u32(result, casualty);
+    Buffer end = std::make_shared<const std::string>(Message::pack(MessageType::END, result));
+    for (auto &spectator : spectators)
+    {
+        if (spectator.is_synced)
+        {
+            queue(spectator, end);
+            write(spectator);
+        }
+        close(spectator.fd);
+    }
+    spectators.clear();
+}
@@ -0,0 +1,180 @@
+/**
+ * @file server.h
+ * @brief Multi-session game server over a UNIX domain socket
+ *
+ * One server process hosts many games. The assets are loaded once into an AssetBundle
+ * that every session resets from, so sessions share the compiled terrain instead of
+ * each reloading and recompiling the map. Connections are spread over a fixed pool of
+ * worker threads; each worker owns its sessions outright and waits on its own epoll
+ * instance, so sessions never need locking. Clients send keys and receive frame deltas
+ * (see frame.h), and do no simulation themselves.
+ *
+ * A local game can also be watched: a FrameBroadcaster encodes each frame once and
+ * fans the shared bytes out to every read-only spectator.
+ */
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include "game.h"
+#include "menu.h"
+#include "frame.h"
+#include "terrain.h"
+
+/**
+ * @struct AssetBundle
+ * @brief Read-only assets loaded once and shared by every game reset from them.
+ */
+struct AssetBundle
+{
+    std::string general;      ///< Text of "general.txt"
+    Terrain terrain;          ///< Compiled map, its grid shared by copies
+    std::vector<City> cities; ///< Cities in their initial state
+    WaveTable waves;          ///< Compiled wave rules
+};
+
+/**
+ * @class GameSession
+ * @brief One connected client playing its own game.
+ *
+ * The client starts the game with a HELLO message carrying the difficulty level, then
+ * sends keys. After every batch of keys the screen is captured and only its difference
+ * from the last frame sent is queued, so a turn typically costs a few hundred bytes.
+ */
+class GameSession
+{
+private:
+    int fd;
+    const AssetBundle &bundle;
+    Game game;
+    AssetLoader loader;
+    OperationMenu menu;
+    Frame sent;            ///< Frame the client holds
+    Frame next;            ///< Scratch frame for captures
+    bool is_started;       ///< Whether HELLO was received
+    bool is_closing;       ///< Whether to disconnect once the output is flushed
+    std::string inbox;     ///< Received bytes not yet forming a whole message
+    std::string outbox;    ///< Bytes queued for the client
+
+    void handle(MessageType type, const std::string &payload);
+    void send_frame(void);
+
+public:
+    GameSession(int f, const AssetBundle &b, const FrameLayout &layout);
+    ~GameSession(void);
+    GameSession(const GameSession &) = delete;
+    GameSession &operator=(const GameSession &) = delete;
+
+    int get_fd(void) const { return fd; };
+    bool is_pending(void) const { return !outbox.empty(); }; ///< Output waiting for the socket
+    bool is_done(void) const { return is_closing && outbox.empty(); };
+    bool receive(void); ///< Read and handle everything available, false if the client is gone
+    bool flush(void);   ///< Write as much queued output as the socket takes, false on error
+};
+
+/**
+ * @class ServerWorker
+ * @brief Thread running the sessions of its own shard of connections.
+ */
+class ServerWorker
+{
+private:
+    const AssetBundle &bundle;
+    FrameLayout layout;
+    int epoll_fd;
+    int wake_fd;                 ///< eventfd signalled when connections are handed over
+    std::mutex lock;             ///< Guards `incoming`
+    std::vector<int> incoming;   ///< Accepted connections not yet registered
+    std::unordered_map<int, std::unique_ptr<GameSession>> sessions;
+    std::atomic<bool> is_stopping;
+    std::thread thread;
+
+    void run(void);
+    void watch(GameSession &session, bool is_new);
+    void drop(int fd);
+
+public:
+    ServerWorker(const AssetBundle &b, const FrameLayout &l);
+    ~ServerWorker(void);
+    ServerWorker(const ServerWorker &) = delete;
+    ServerWorker &operator=(const ServerWorker &) = delete;
+
+    void start(void) { thread = std::thread(&ServerWorker::run, this); };
+    void add(int fd); ///< Hand over an accepted connection (any thread)
+};
+
+/**
+ * @class GameServer
+ * @brief Listens on a UNIX socket and deals connections out to the workers round-robin.
+ */
+class GameServer
+{
+private:
+    std::string path;
+    AssetBundle bundle;
+    int listener;
+    std::vector<std::unique_ptr<ServerWorker>> workers;
+
+public:
+    GameServer(const std::string &p, int worker_count, const FrameLayout &layout);
+    ~GameServer(void);
+    GameServer(const GameServer &) = delete;
+    GameServer &operator=(const GameServer &) = delete;
+
+    void run(void); ///< Accept connections until the process is stopped
+};
+
+/**
+ * @class FrameBroadcaster
+ * @brief Streams the frames of a game to read-only spectators on a UNIX socket.
+ *
+ * Each frame is encoded once into a reference-counted message queued to every spectator,
+ * so the cost of a frame does not grow with the audience beyond the writes themselves.
+ * Writes never block: a spectator whose backlog grows past MAX_BACKLOG loses it and is
+ * resynchronised with the next keyframe instead of stalling the game loop.
+ */
+class FrameBroadcaster
+{
+private:
+    typedef std::shared_ptr<const std::string> Buffer;
+
+    struct Spectator
+    {
+        int fd;
+        std::deque<Buffer> backlog; ///< Messages not yet fully written
+        size_t offset;              ///< Bytes of the front message already written
+        size_t pending;             ///< Bytes of the backlog not yet written
+        bool is_synced;             ///< Whether the spectator holds the last frame published
+    };
+
+    std::string path;
+    int listener;
+    Frame last;                       ///< Frame the synced spectators hold
+    std::vector<Spectator> spectators;
+
+    void accept_spectators(void);
+    bool write(Spectator &spectator);
+    void queue(Spectator &spectator, const Buffer &buffer);
+
+public:
+    static const size_t MAX_BACKLOG = 1 << 18; ///< Bytes a spectator may lag behind
+
+    FrameBroadcaster(const std::string &p);
+    ~FrameBroadcaster(void);
+    FrameBroadcaster(const FrameBroadcaster &) = delete;
+    FrameBroadcaster &operator=(const FrameBroadcaster &) = delete;
+
+    size_t get_spectator_count(void) const { return spectators.size(); };
+    void publish(const Frame &frame);                 ///< Send a frame to every spectator
+    void finish(int score, int turn, int casualty);   ///< Send the result and detach every spectator
+};
+
+#endif
@@ -0,0 +1,179 @@
+/**
+ * @file stats.cpp
+ * @brief Implementation of the shared memory live statistics.
+ *
+ * Classes:
+ * - LiveStats: Creates or opens a statistics segment and publishes or reads snapshots
+ *   under a seqlock.
+ *
+ * Dependencies:
+ * - stats.h: Declaration of LiveSnapshot and LiveStats.
+ * - POSIX shared memory (shm_open, mmap).
+ */
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <new>
+#include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "stats.h"
+
+/**
+ * @brief Creates the segment of this process, or opens the segment of a game read-only.
+ *
+ * @param n Name of the shared memory object, see get_name().
+ * @param writer Whether to create and publish rather than read.
+ * @throws std::runtime_error If the object cannot be created, opened or mapped, or is not
+ *         a statistics segment of this version.
+ */
+LiveStats::LiveStats(const std::string &n, bool writer)
+    : name(n), is_writer(writer), segment(nullptr)
+{
+    int fd = writer ? shm_open(name.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644) : shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open live stats " + name + ": " + std::strerror(errno));
+    }
+    struct stat info;
+    bool is_sized = writer ? ftruncate(fd, sizeof(Segment)) == 0 : fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(Segment);
+    void *memory = is_sized ? mmap(nullptr, sizeof(Segment), writer ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    close(fd);
+    if (memory == MAP_FAILED)
+    {
+        if (writer)
+        {
+            shm_unlink(name.c_str());
+        }
+        throw std::runtime_error("Cannot map live stats " + name);
+    }
+
+    if (writer)
+    {
+        segment = new (memory) Segment;
+        segment->version = VERSION;
+        segment->sequence.store(0, std::memory_order_relaxed);
+        for (auto &word : segment->words)
+        {
+            word.store(0, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+        segment->magic = MAGIC;
+    }
+    else
+    {
+        segment = static_cast<Segment *>(memory);
+        if (segment->magic != MAGIC || segment->version != VERSION)
+        {
+            munmap(memory, sizeof(Segment));
+            throw std::runtime_error("Not a live stats segment of this version: " + name);
+        }
+    }
+}
+
+/**
+ * @brief Unmaps the segment; the writer also removes it.
+ *
+ */
+LiveStats::~LiveStats(void)
+{
+    munmap(segment, sizeof(Segment));
+    if (is_writer)
+    {
+        shm_unlink(name.c_str());
+    }
+}
+
+/**
+ * @brief Publishes a snapshot: sequence to odd, the words, then sequence to even.
+ *
+ * @param snapshot Statistics of the turn just played.
+ */
+void LiveStats::publish(const LiveSnapshot &snapshot)
+{
+    uint32_t words[WORDS];
+    std::memcpy(words, &snapshot, sizeof(words));
+    uint32_t sequence = segment->sequence.load(std::memory_order_relaxed);
+    segment->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int index = 0; index < WORDS; index++)
+    {
+        segment->words[index].store(words[index], std::memory_order_relaxed);
+    }
+    segment->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+/**
+ * @brief Copies a consistent snapshot, retrying while the writer is in the middle of one.
+ *
+ * @param snapshot Receives the snapshot.
+ * @return bool: False if nothing was published yet or the writer kept interrupting.
+ */
+bool LiveStats::read(LiveSnapshot &snapshot) const
+{
+    for (int attempt = 0; attempt < 1000; attempt++)
+    {
+        uint32_t before = segment->sequence.load(std::memory_order_acquire);
+        if (before & 1)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        uint32_t words[WORDS];
+        for (int index = 0; index < WORDS; index++)
+        {
+            words[index] = segment->words[index].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (segment->sequence.load(std::memory_order_relaxed) == before)
+        {
+            std::memcpy(&snapshot, words, sizeof(words));
+            return before != 0;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Builds the shared memory object name of a game process.
+ *
+ * @param pid Process of the game.
+ * @return std::string: "/counter-attack.<pid>".
+ */
+std::string LiveStats::get_name(int pid)
+{
+    return "/counter-attack." + std::to_string(pid);
+}
+
+/**
+ * @brief Lists the statistics segments currently published, via the shm mount.
+ *
+ * @return std::vector<std::string>: Object names, usable with the constructor.
+ */
+std::vector<std::string> LiveStats::list(void)
+{
+    std::vector<std::string> names;
+    DIR *directory = opendir("/dev/shm");
+    if (directory == nullptr)
+    {
+        return names;
+    }
+    const std::string prefix = "counter-attack.";
+    while (dirent *entry = readdir(directory))
+    {
+        std::string file = entry->d_name;
+        if (file.compare(0, prefix.size(), prefix) == 0)
+        {
+            names.push_back("/" + file);
+        }
+    }
+    closedir(directory);
+    return names;
+}
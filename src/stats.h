@@ -0,0 +1,103 @@
+/**
+ * @file stats.h
+ * @brief Live game statistics exported through POSIX shared memory
+ *
+ * A game with `live_stats:1` in "general.txt" publishes a LiveSnapshot once per turn
+ * into the shared memory object "/counter-attack.<pid>". Readers such as `cs-top` map
+ * the object read-only and poll it. The snapshot is guarded by a seqlock: the writer
+ * bumps a sequence number to odd before writing and back to even after, and a reader
+ * retries whenever it saw an odd number or the number changed under it. The game never
+ * waits for a reader, and readers never write to the segment.
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @enum TurnPhase
+ * @brief Timed phases of Game::pass_turn, in execution order.
+ */
+enum TurnPhase
+{
+    PHASE_MISSILES = 0, ///< Moving missiles
+    PHASE_IMPACTS = 1,  ///< Resolving impacts on cities
+    PHASE_ECONOMY = 2,  ///< City production and super weapon counters
+    PHASE_RESEARCH = 3, ///< Research progress
+    PHASE_DEFENSE = 4,  ///< Iron curtain and self defense system
+    PHASE_WAVE = 5,     ///< Launching and planning attack waves
+    PHASE_COUNT = 6
+};
+
+/**
+ * @struct LiveSnapshot
+ * @brief Fixed-layout game statistics of the last turn. Only 32-bit fields, no padding.
+ */
+struct LiveSnapshot
+{
+    int32_t pid;              ///< Process of the game
+    int32_t level;            ///< Difficulty level
+    int32_t turn;
+    int32_t deposit;
+    int32_t productivity;
+    int32_t enemy_hp;
+    int32_t score;
+    int32_t casualty;
+    int32_t cities;           ///< Cities on the map
+    int32_t cities_alive;     ///< Cities with hitpoints left
+    int32_t city_hp;          ///< Total hitpoints of every city
+    int32_t attack_missiles;  ///< Attack missiles in flight
+    int32_t cruise_missiles;  ///< Cruise missiles in flight
+    uint32_t turn_ns;         ///< Duration of the whole last pass_turn
+    uint32_t phase_ns[PHASE_COUNT]; ///< Duration of each phase of the last pass_turn
+    uint32_t time_s;          ///< Wall clock time of publication, seconds since the epoch
+};
+
+/**
+ * @class LiveStats
+ * @brief Seqlock-guarded LiveSnapshot in a POSIX shared memory object.
+ */
+class LiveStats
+{
+public:
+    static const uint32_t MAGIC = 0x43414C53;   ///< "SLAC", marks an initialised segment
+    static const uint32_t VERSION = 1;          ///< Bumped when LiveSnapshot changes
+    static const int WORDS = sizeof(LiveSnapshot) / 4;
+
+private:
+    /**
+     * @struct Segment
+     * @brief Layout of the shared memory object. The snapshot is copied word by word with
+     * relaxed atomics, so concurrent access is well-defined; the seqlock makes it consistent.
+     */
+    struct Segment
+    {
+        uint32_t magic;
+        uint32_t version;
+        std::atomic<uint32_t> sequence;      ///< Odd while a snapshot is being written
+        std::atomic<uint32_t> words[WORDS];  ///< Snapshot of the last turn
+    };
+
+    std::string name;
+    bool is_writer;
+    Segment *segment;
+
+public:
+    LiveStats(const std::string &n, bool writer);
+    ~LiveStats(void);
+    LiveStats(const LiveStats &) = delete;
+    LiveStats &operator=(const LiveStats &) = delete;
+
+    const std::string &get_name(void) const { return name; };
+    void publish(const LiveSnapshot &snapshot); ///< Write a snapshot (writer only, never blocks)
+    bool read(LiveSnapshot &snapshot) const;    ///< Copy a consistent snapshot, false if none yet
+
+    static std::string get_name(int pid);          ///< Object name of a game process
+    static std::vector<std::string> list(void);    ///< Names of every published game
+};
+
+#endif
@@ -0,0 +1,184 @@
+/**
+ * @file telemetry.cpp
+ * @brief Implementation of the per-turn telemetry writer.
+ *
+ * Classes:
+ * - TelemetryWriter: Creates the telemetry file of a game, queues records in a
+ *   single-producer single-consumer ring and writes them out on its own thread.
+ *
+ * Dependencies:
+ * - telemetry.h: Declaration of TelemetryHeader, TelemetryRecord and TelemetryWriter.
+ * - POSIX file I/O (open, write, pwrite).
+ */
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "telemetry.h"
+
+static_assert(sizeof(TelemetryHeader) == 32, "TelemetryHeader must not be padded");
+static_assert(sizeof(TelemetryRecord) == 68, "TelemetryRecord must not be padded");
+
+/**
+ * @brief Creates a new telemetry file in a directory, creating the directory if needed.
+ *
+ * @param directory Directory of the telemetry files.
+ * @throws std::runtime_error If the file cannot be created.
+ */
+TelemetryWriter::TelemetryWriter(const std::string &directory)
+    : fd(-1), record_size(0), head(0), tail(0), dropped(0), is_stopping(false)
+{
+    static std::atomic<int> serial(0); // NOTE: several games may start within a second
+    mkdir(directory.c_str(), 0755);
+    path = directory + "/" + std::to_string(long(std::time(nullptr))) + "-" + std::to_string(getpid()) +
+           "-" + std::to_string(serial++) + ".tlm";
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot create telemetry file " + path + ": " + std::strerror(errno));
+    }
+}
+
+/**
+ * @brief Writes out every queued record, stops the writer and records the drop count.
+ *
+ */
+TelemetryWriter::~TelemetryWriter(void)
+{
+    if (thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            is_stopping = true;
+        }
+        wake.notify_one();
+        thread.join();
+
+        uint32_t count = dropped.load(std::memory_order_relaxed);
+        pwrite(fd, &count, sizeof(count), offsetof(TelemetryHeader, dropped));
+    }
+    close(fd);
+}
+
+/**
+ * @brief Writes the header once the game is set up, then starts the writer thread.
+ *
+ * @param level Difficulty level of the game.
+ * @param seed Seed of the game.
+ * @param cities Number of cities, fixing the record size.
+ */
+void TelemetryWriter::begin(int level, uint64_t seed, int cities)
+{
+    record_size = sizeof(TelemetryRecord) + cities * sizeof(int32_t);
+    ring.assign(SLOTS * record_size, 0);
+
+    TelemetryHeader header;
+    std::memcpy(header.magic, "CATL", 4);
+    header.version = VERSION;
+    header.record_size = record_size;
+    header.level = level;
+    header.cities = cities;
+    header.dropped = 0;
+    header.seed = seed;
+    write_all(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    thread = std::thread(&TelemetryWriter::run, this);
+}
+
+/**
+ * @brief Copies a record into the ring. The writer is only woken once the ring is half
+ * full; otherwise it picks the records up on its next periodic flush.
+ *
+ * @param record Fixed part of the record.
+ * @param hitpoints Hitpoint of every city.
+ * @return bool: False if the ring was full and the record was dropped.
+ */
+bool TelemetryWriter::push(const TelemetryRecord &record, const int32_t *hitpoints)
+{
+    size_t index = head.load(std::memory_order_relaxed);
+    size_t used = index - tail.load(std::memory_order_acquire);
+    if (record_size == 0 || used == SLOTS)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    char *slot = ring.data() + (index % SLOTS) * record_size;
+    std::memcpy(slot, &record, sizeof(record));
+    std::memcpy(slot + sizeof(record), hitpoints, record_size - sizeof(record));
+    head.store(index + 1, std::memory_order_release);
+    if (used + 1 == SLOTS / 2)
+    {
+        wake.notify_one();
+    }
+    return true;
+}
+
+/**
+ * @brief Writes a buffer completely.
+ *
+ * @param data Bytes to write.
+ * @param length Number of bytes.
+ * @return bool: False on a write error, the rest of the buffer is then lost.
+ */
+bool TelemetryWriter::write_all(const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = write(fd, data, length);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (written <= 0)
+        {
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+/**
+ * @brief Writer loop: writes every contiguous run of queued records at once, then waits
+ * for the next flush. Exits once stopped and drained.
+ *
+ */
+void TelemetryWriter::run(void)
+{
+    std::unique_lock<std::mutex> guard(lock);
+    while (true)
+    {
+        size_t first = tail.load(std::memory_order_relaxed);
+        size_t last = head.load(std::memory_order_acquire);
+        if (first == last)
+        {
+            if (is_stopping)
+            {
+                break;
+            }
+            wake.wait_for(guard, std::chrono::milliseconds(250));
+            continue;
+        }
+
+        guard.unlock();
+        size_t offset = first % SLOTS;
+        size_t count = std::min(last - first, SLOTS - offset); // NOTE: up to the end of the ring, the rest on the next pass
+        write_all(ring.data() + offset * record_size, count * record_size);
+        tail.store(first + count, std::memory_order_release);
+        guard.lock();
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ * @file telemetry.h
+ * @brief Per-turn telemetry records streamed to a file by a background writer
+ *
+ * A game with `telemetry:<directory>` in "general.txt" writes one fixed-size record per
+ * turn into a new file of that directory for every game it starts. The game thread only
+ * copies the record into a bounded single-producer single-consumer ring and never waits:
+ * when the ring is full the record is dropped and counted. A writer thread drains the
+ * ring in batches, one write() per contiguous run of records, a few times a second.
+ *
+ * File layout (native byte order): one TelemetryHeader, then records of
+ * `header.record_size` bytes, each a TelemetryRecord followed by one int32_t hitpoint
+ * per city, in the order of "cities.txt".
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+#include "stats.h"
+
+/**
+ * @struct TelemetryHeader
+ * @brief First bytes of a telemetry file. `dropped` is filled in when the file is closed.
+ */
+struct TelemetryHeader
+{
+    char magic[4];        ///< "CATL"
+    uint32_t version;     ///< Bumped when the layout changes
+    uint32_t record_size; ///< Bytes per record, city hitpoints included
+    int32_t level;        ///< Difficulty level
+    int32_t cities;       ///< Hitpoints per record
+    uint32_t dropped;     ///< Records lost because the ring was full
+    uint64_t seed;        ///< Seed of the game, to replay it
+};
+
+/**
+ * @struct TelemetryRecord
+ * @brief Fixed part of the record of one turn. Only 32-bit fields, no padding.
+ */
+struct TelemetryRecord
+{
+    int32_t turn;           ///< Turn just played
+    int32_t deposit;
+    int32_t productivity;
+    int32_t enemy_hp;
+    int32_t score;
+    int32_t casualty_delta; ///< Casualties caused during the turn
+    int32_t spawned;        ///< Attack missiles launched by the wave of the turn
+    int32_t intercepted;    ///< Attack missiles destroyed since the last turn without reaching a city
+    int32_t impacted;       ///< Attack missiles that hit a city during the turn
+    uint32_t researched;    ///< Bit i is set once node i of the tech tree is researched
+    uint32_t turn_ns;       ///< Duration of pass_turn
+    uint32_t phase_ns[PHASE_COUNT]; ///< Duration of each phase of pass_turn
+};
+
+/**
+ * @class TelemetryWriter
+ * @brief Telemetry file of one game, fed through a lock-free ring to a writer thread.
+ */
+class TelemetryWriter
+{
+public:
+    static const uint32_t VERSION = 2;
+    static const size_t SLOTS = 1024; ///< Records the ring holds
+
+private:
+    int fd;
+    std::string path;
+    size_t record_size;
+    std::vector<char> ring;        ///< SLOTS records of record_size bytes
+    std::atomic<size_t> head;      ///< Records pushed, only written by the game thread
+    std::atomic<size_t> tail;      ///< Records written out, only written by the writer thread
+    std::atomic<uint32_t> dropped;
+    std::mutex lock;               ///< Guards `is_stopping`, and the wait of the writer
+    std::condition_variable wake;
+    bool is_stopping;
+    std::thread thread;
+
+    void run(void);
+    bool write_all(const char *data, size_t length);
+
+public:
+    TelemetryWriter(const std::string &directory);
+    ~TelemetryWriter(void);
+    TelemetryWriter(const TelemetryWriter &) = delete;
+    TelemetryWriter &operator=(const TelemetryWriter &) = delete;
+
+    const std::string &get_path(void) const { return path; };
+    uint32_t get_dropped(void) const { return dropped.load(std::memory_order_relaxed); };
+
+    void begin(int level, uint64_t seed, int cities);                    ///< Write the header and start the writer
+    bool push(const TelemetryRecord &record, const int32_t *hitpoints); ///< Queue a record, false if dropped (never blocks)
+};
+
+#endif
@@ -0,0 +1,445 @@
+/**
+ * @file terrain.cpp
+ * @brief Implementation of the bit-packed terrain grid.
+ *
+ * Classes:
+ * - TerrainChunkFile: Memory-maps a chunked map file and decodes individual chunks.
+ * - Terrain: Compiles background text into 2-bit cells and answers classification queries,
+ *   either from an in-memory grid or from chunks streamed out of a TerrainChunkFile.
+ * - FlowField: Routes every cell of the map towards one target over terrain costs.
+ *
+ * Chunked map format:
+ * - TerrainChunkHeader, then one TerrainChunkEntry per 64x64 chunk in row-major order.
+ * - Each chunk payload is a run-length encoding of its cells in row-major order, one byte
+ *   per run: the terrain type in the top 2 bits and the run length minus one in the low 6.
+ *   Cells of edge chunks that lie outside the map are encoded as LAND.
+ *
+ * Dependencies:
+ * - terrain.h: Declaration of the Terrain class and the TerrainType enum.
+ */
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "terrain.h"
+
+static const char CHUNK_MAGIC[8] = {'C', 'S', 'M', 'A', 'P', '0', '1', '\0'};
+
+/**
+ * @brief Memory-maps a chunked map file and validates its header and index.
+ *
+ * @param path Path of the chunked map file.
+ * @throws std::runtime_error If the file cannot be mapped or is malformed.
+ */
+TerrainChunkFile::TerrainChunkFile(const std::string &path) : base(nullptr), length(0), index(nullptr)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(TerrainChunkHeader)))
+    {
+        close(fd);
+        throw std::runtime_error("Invalid chunked map " + path);
+    }
+    length = info.st_size;
+    void *mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // NOTE: the mapping stays valid after the descriptor is closed
+    if (mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("Cannot map " + path);
+    }
+    base = static_cast<const unsigned char *>(mapping);
+
+    const TerrainChunkHeader *header = reinterpret_cast<const TerrainChunkHeader *>(base);
+    if (std::memcmp(header->magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0 || header->chunk_size != Terrain::CHUNK_SIZE)
+    {
+        munmap(mapping, length);
+        throw std::runtime_error("Invalid chunked map " + path);
+    }
+    size = Size(header->height, header->width);
+    chunks = Size((size.h + Terrain::CHUNK_SIZE - 1) / Terrain::CHUNK_SIZE, (size.w + Terrain::CHUNK_SIZE - 1) / Terrain::CHUNK_SIZE);
+    size_t index_end = sizeof(TerrainChunkHeader) + sizeof(TerrainChunkEntry) * chunks.h * chunks.w;
+    if (index_end > length)
+    {
+        munmap(mapping, length);
+        throw std::runtime_error("Truncated chunked map " + path);
+    }
+    index = reinterpret_cast<const TerrainChunkEntry *>(base + sizeof(TerrainChunkHeader));
+    for (int chunk = 0; chunk < chunks.h * chunks.w; chunk++) // Validate once so decoding never reads past the mapping
+    {
+        if (index[chunk].offset < index_end || index[chunk].offset + index[chunk].length > length)
+        {
+            munmap(mapping, length);
+            throw std::runtime_error("Corrupted chunked map " + path);
+        }
+    }
+}
+
+/**
+ * @brief Releases the mapping of the chunked map file.
+ */
+TerrainChunkFile::~TerrainChunkFile(void)
+{
+    munmap(const_cast<unsigned char *>(base), length);
+}
+
+/**
+ * @brief Decodes one chunk into packed cells.
+ *
+ * @param chunk Row-major chunk index.
+ * @param out Destination of Terrain::CHUNK_WORDS packed words, two words per chunk row.
+ */
+void TerrainChunkFile::decode(int chunk, uint64_t *out) const
+{
+    std::fill(out, out + Terrain::CHUNK_WORDS, 0);
+    const unsigned char *payload = base + index[chunk].offset;
+    int cell = 0;
+    for (uint32_t offset = 0; offset < index[chunk].length && cell < Terrain::CHUNK_SIZE * Terrain::CHUNK_SIZE; offset++)
+    {
+        uint64_t type = payload[offset] >> 6;
+        int run = (payload[offset] & 63) + 1;
+        for (int end = std::min(cell + run, Terrain::CHUNK_SIZE * Terrain::CHUNK_SIZE); cell < end; cell++)
+        {
+            out[cell / Terrain::CELLS_PER_WORD] |= type << ((cell % Terrain::CELLS_PER_WORD) * 2);
+        }
+    }
+}
+
+/**
+ * @brief Maps a background character to its terrain type.
+ *
+ * @param ch Character read from a background file.
+ * @return TerrainType: The matching terrain type, UNKNOWN for unrecognised characters.
+ */
+TerrainType Terrain::classify(char ch)
+{
+    switch (ch)
+    {
+    case ' ':
+        return TerrainType::LAND;
+    case '#':
+        return TerrainType::SEA;
+    case '@':
+        return TerrainType::CITY;
+    default:
+        return TerrainType::UNKNOWN;
+    }
+}
+
+/**
+ * @brief Maps a terrain type back to its background character.
+ *
+ * @param type Terrain type of a cell.
+ * @return char: Character used in background files.
+ */
+char Terrain::to_char(TerrainType type)
+{
+    switch (type)
+    {
+    case TerrainType::LAND:
+        return ' ';
+    case TerrainType::SEA:
+        return '#';
+    case TerrainType::CITY:
+        return '@';
+    default:
+        return '?';
+    }
+}
+
+/**
+ * @brief Resizes the grid and clears every cell to LAND.
+ * A streamed terrain is detached from its chunked map file and becomes flat again.
+ *
+ * @param s New map size.
+ */
+void Terrain::reset(Size s)
+{
+    source.reset();
+    cache.clear();
+    cache_chunk.clear();
+    cache_referenced.clear();
+    cache_slot.clear();
+    last_chunk = -1;
+    size = s;
+    stride = (s.w + CELLS_PER_WORD - 1) / CELLS_PER_WORD;
+    data = std::make_shared<std::vector<uint64_t>>(static_cast<size_t>(stride) * s.h, 0);
+}
+
+/**
+ * @brief Compiles one line of background text into the grid.
+ * Characters beyond the map width are ignored, missing ones stay LAND.
+ *
+ * @param line Row index to fill.
+ * @param row Background text of the row.
+ */
+void Terrain::set_row(int line, const std::string &row)
+{
+    if (line < 0 || line >= size.h)
+    {
+        return;
+    }
+    unshare();
+    uint64_t *words = data->data() + line * stride;
+    int width = std::min<int>(row.size(), size.w);
+    for (int col = 0; col < width; col++)
+    {
+        words[col / CELLS_PER_WORD] |= uint64_t(classify(row[col])) << ((col % CELLS_PER_WORD) * 2);
+    }
+}
+
+/**
+ * @brief Compiles a complete background, sizing the grid from the text itself.
+ *
+ * @param lines Background text, one string per row.
+ */
+void Terrain::compile(const std::vector<std::string> &lines)
+{
+    int width = 0;
+    for (auto &line : lines)
+    {
+        width = std::max<int>(width, line.size());
+    }
+    reset(Size(lines.size(), width));
+    for (size_t line = 0; line < lines.size(); line++)
+    {
+        set_row(line, lines.at(line));
+    }
+}
+
+/**
+ * @brief Bounds-checked cell lookup.
+ *
+ * @param p Position to classify.
+ * @return TerrainType: Terrain type of the cell.
+ * @throws std::out_of_range When the position lies outside the map.
+ */
+TerrainType Terrain::at(Position p) const
+{
+    if (!is_in_map(p))
+    {
+        throw std::out_of_range("Terrain position out of range");
+    }
+    return get(p);
+}
+
+/**
+ * @brief Switches the terrain to streaming mode backed by a chunked map file.
+ * Any in-memory grid is released; chunks are decoded lazily on first access.
+ *
+ * @param file Shared chunked map file to read from.
+ */
+void Terrain::stream(const std::shared_ptr<const TerrainChunkFile> &file)
+{
+    size = file->get_size();
+    stride = 0;
+    data.reset(); // NOTE: never allocate the flat grid for a streamed map
+    cache_slot.clear();
+    source = file;
+    cache.assign(static_cast<size_t>(CACHE_CHUNKS) * CHUNK_WORDS, 0);
+    cache_chunk.assign(CACHE_CHUNKS, -1);
+    cache_referenced.assign(CACHE_CHUNKS, false);
+    cache_hand = 0;
+    last_chunk = -1;
+}
+
+/**
+ * @brief Returns the decoded cells of a chunk, decoding it into the cache on a miss.
+ * Victim slots are chosen with the CLOCK (second chance) policy.
+ *
+ * @param chunk Row-major chunk index.
+ * @return const uint64_t*: Packed cells of the chunk, two words per chunk row.
+ */
+const uint64_t *Terrain::load_chunk(int chunk) const
+{
+    std::unordered_map<int, int>::const_iterator iter = cache_slot.find(chunk);
+    if (iter != cache_slot.end()) // Cache hit
+    {
+        cache_referenced[iter->second] = true;
+        last_chunk = chunk;
+        last_slot = iter->second;
+        return cache.data() + last_slot * CHUNK_WORDS;
+    }
+
+    while (cache_chunk[cache_hand] != -1 && cache_referenced[cache_hand]) // Give referenced slots a second chance
+    {
+        cache_referenced[cache_hand] = false;
+        cache_hand = (cache_hand + 1) % CACHE_CHUNKS;
+    }
+    int slot = cache_hand;
+    cache_hand = (cache_hand + 1) % CACHE_CHUNKS;
+    if (cache_chunk[slot] != -1)
+    {
+        cache_slot.erase(cache_chunk[slot]); // Evict the previous chunk
+    }
+    source->decode(chunk, cache.data() + slot * CHUNK_WORDS);
+    cache_chunk[slot] = chunk;
+    cache_referenced[slot] = true;
+    cache_slot[chunk] = slot;
+    last_chunk = chunk;
+    last_slot = slot;
+    return cache.data() + slot * CHUNK_WORDS;
+}
+
+/**
+ * @brief Writes the terrain as a chunked map file that can later be streamed.
+ *
+ * @param path Destination path of the chunked map file.
+ * @throws std::runtime_error If the file cannot be written.
+ */
+void Terrain::save_chunked(const std::string &path) const
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    Size chunks((size.h + CHUNK_SIZE - 1) / CHUNK_SIZE, (size.w + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    TerrainChunkHeader header;
+    std::memcpy(header.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+    header.height = size.h;
+    header.width = size.w;
+    header.chunk_size = CHUNK_SIZE;
+    header.reserved = 0;
+    std::vector<TerrainChunkEntry> index(chunks.h * chunks.w);
+    uint64_t offset = sizeof(TerrainChunkHeader) + sizeof(TerrainChunkEntry) * index.size();
+    file.seekp(offset); // NOTE: the index is written last, once payload offsets are known
+
+    std::vector<unsigned char> payload;
+    for (int chunk = 0; chunk < chunks.h * chunks.w; chunk++)
+    {
+        Position origin((chunk / chunks.w) * CHUNK_SIZE, (chunk % chunks.w) * CHUNK_SIZE);
+        payload.clear();
+        int run = 0;
+        TerrainType run_type = TerrainType::LAND;
+        for (int cell = 0; cell < CHUNK_SIZE * CHUNK_SIZE; cell++)
+        {
+            Position p = origin + Position(cell / CHUNK_SIZE, cell % CHUNK_SIZE);
+            TerrainType type = is_in_map(p) ? get(p) : TerrainType::LAND;
+            if (run > 0 && (type != run_type || run == 64))
+            {
+                payload.push_back((uint8_t(run_type) << 6) | (run - 1));
+                run = 0;
+            }
+            run_type = type;
+            run++;
+        }
+        payload.push_back((uint8_t(run_type) << 6) | (run - 1));
+
+        index.at(chunk).offset = offset;
+        index.at(chunk).length = payload.size();
+        index.at(chunk).reserved = 0;
+        file.write(reinterpret_cast<const char *>(payload.data()), payload.size());
+        offset += payload.size();
+    }
+
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(index.data()), sizeof(TerrainChunkEntry) * index.size());
+    if (!file)
+    {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    file.close();
+}
+
+const uint8_t FlowField::STAY;
+const Position FlowField::STEPS[8] = {Position(-1, 0), Position(-1, 1), Position(0, 1), Position(1, 1),
+                                      Position(1, 0), Position(1, -1), Position(0, -1), Position(-1, -1)};
+
+/**
+ * @brief Cost of entering a cell of the given terrain.
+ *
+ * @param type Terrain type of the entered cell.
+ * @param mode Routing mode in use.
+ * @return int: Step cost, between 1 and 4.
+ */
+int FlowField::cost(TerrainType type, RoutingMode mode)
+{
+    switch (mode)
+    {
+    case RoutingMode::AVOID_SEA:
+        return type == TerrainType::SEA ? 4 : 1;
+    case RoutingMode::PREFER_SEA:
+        return type == TerrainType::SEA ? 1 : 3;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * @brief Checks that a terrain is flat and small enough for its costs to fit in 16 bits.
+ *
+ * @param terrain Terrain to route over.
+ * @return bool: Whether flow fields can be built over it.
+ */
+bool FlowField::is_routable(const Terrain &terrain)
+{
+    const Size &size = terrain.get_size();
+    return !terrain.is_streamed() && size.h > 0 && size.w > 0 && size.h <= MAX_SIDE && size.w <= MAX_SIDE;
+}
+
+/**
+ * @brief Builds the flow field of a target with a bucketed Dijkstra search.
+ * Step costs are small integers, so a ring of cost buckets replaces the heap and the
+ * whole field is computed in time linear in the number of cells. Only reads the terrain,
+ * so fields of a flat terrain can be built on worker threads.
+ *
+ * @param terrain Terrain to route over, see is_routable.
+ * @param t Target cell, must lie within the map.
+ * @param mode Routing mode deciding the step costs.
+ */
+FlowField::FlowField(const Terrain &terrain, Position t, RoutingMode mode)
+    : size(terrain.get_size()), target(t), next(static_cast<size_t>(size.h) * size.w, STAY)
+{
+    const int max_cost = 4;
+    const uint16_t unreached = UINT16_MAX; // NOTE: paths cost at most max_cost * MAX_SIDE
+    std::vector<uint16_t> distance(next.size(), unreached);
+
+    std::vector<std::vector<int>> buckets(max_cost + 1);
+    distance[target.y * size.w + target.x] = 0;
+    buckets[0].push_back(target.y * size.w + target.x);
+    size_t pending = 1;
+    for (int current = 0; pending > 0; current++)
+    {
+        std::vector<int> &bucket = buckets[current % (max_cost + 1)];
+        for (size_t index = 0; index < bucket.size(); index++)
+        {
+            int cell = bucket[index];
+            if (distance[cell] != current) // Stale entry, already settled with a lower distance
+            {
+                continue;
+            }
+            Position p(cell / size.w, cell % size.w);
+            int reached = current + cost(terrain.get(p), mode); // Neighbours pay for entering this cell
+            for (int step = 0; step < 8; step++)
+            {
+                Position q = p + STEPS[step];
+                if (!is_in_field(q))
+                {
+                    continue;
+                }
+                int neighbour = q.y * size.w + q.x;
+                if (reached < distance[neighbour])
+                {
+                    distance[neighbour] = reached;
+                    next[neighbour] = (step + 4) % 8; // The opposite step leads back to this cell
+                    buckets[reached % (max_cost + 1)].push_back(neighbour);
+                    pending++;
+                }
+            }
+        }
+        pending -= bucket.size();
+        bucket.clear();
+    }
+}
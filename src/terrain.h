@@ -0,0 +1,232 @@
+/**
+ * @file terrain.h
+ * @brief Compact terrain grid used for map classification
+ *
+ * The map background is compiled at load time into a grid of 2-bit cells. Each row
+ * starts on a 64-bit word boundary, so a 4096x4096 map occupies 4 MiB and a whole
+ * row can be scanned word by word.
+ *
+ * Very large maps can instead be streamed from a chunked map file: the file is
+ * memory-mapped and 64x64 chunks are decoded on demand into a fixed-size cache, so
+ * resident memory stays bounded whatever the size of the map.
+ */
+
+#ifndef TERRAIN_H
+#define TERRAIN_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include "utils.h"
+
+/**
+ * @enum TerrainType
+ * @brief Classification of a single map cell, stored in 2 bits.
+ */
+enum class TerrainType : uint8_t
+{
+    LAND = 0,   ///< ' ' in background files
+    SEA = 1,    ///< '#' in background files
+    CITY = 2,   ///< '@' in background files
+    UNKNOWN = 3 ///< Any other character
+};
+
+/**
+ * @struct TerrainChunkHeader
+ * @brief Fixed header at the start of a chunked map file.
+ *
+ * The header is followed by one TerrainChunkEntry per chunk (row-major), then by the
+ * run-length encoded chunk payloads. All fields are stored little-endian.
+ */
+struct TerrainChunkHeader
+{
+    char magic[8];       ///< "CSMAP01" with a trailing NUL
+    uint32_t height;     ///< Map height in cells
+    uint32_t width;      ///< Map width in cells
+    uint32_t chunk_size; ///< Edge length of a square chunk
+    uint32_t reserved;   ///< Always zero
+};
+
+/**
+ * @struct TerrainChunkEntry
+ * @brief Index entry locating one encoded chunk inside a chunked map file.
+ */
+struct TerrainChunkEntry
+{
+    uint64_t offset;   ///< Byte offset of the payload from the start of the file
+    uint32_t length;   ///< Payload length in bytes
+    uint32_t reserved; ///< Always zero
+};
+
+/**
+ * @class TerrainChunkFile
+ * @brief Read-only, memory-mapped chunked map file.
+ *
+ * Validates the header and index once when opened. Decoding a chunk only reads the
+ * pages backing that chunk's payload. Instances are immutable and can be shared
+ * between terrains.
+ */
+class TerrainChunkFile
+{
+private:
+    const unsigned char *base;       ///< Start of the mapping
+    size_t length;                   ///< Length of the mapping
+    Size size;                       ///< Map size in cells
+    Size chunks;                     ///< Map size in chunks
+    const TerrainChunkEntry *index;  ///< Chunk index inside the mapping
+
+public:
+    TerrainChunkFile(const std::string &path);
+    ~TerrainChunkFile(void);
+    TerrainChunkFile(const TerrainChunkFile &) = delete;
+    TerrainChunkFile &operator=(const TerrainChunkFile &) = delete;
+
+    const Size &get_size(void) const { return size; };
+    const Size &get_chunks(void) const { return chunks; };
+    void decode(int chunk, uint64_t *out) const;
+};
+
+/**
+ * @class Terrain
+ * @brief Bit-packed, row-aligned terrain grid with O(1) classification.
+ *
+ * Cells are packed 32 per 64-bit word, lowest bits first. `get` performs no bounds
+ * checking and is intended for hot loops that already iterate within the map, while
+ * `at` mirrors `std::vector::at` and throws on out-of-range positions.
+ *
+ * A terrain is either flat (the whole grid lives in memory and can be edited with
+ * `set`) or streamed from a TerrainChunkFile, in which case it is read-only and only
+ * the most recently touched chunks are kept decoded.
+ *
+ * Copies of a flat terrain share its grid until one of them is edited (copy-on-write),
+ * so many games can be served from one compiled map.
+ */
+class Terrain
+{
+public:
+    static const int CELLS_PER_WORD = 32; ///< 2 bits per cell in a 64-bit word
+    static const int CHUNK_SIZE = 64;     ///< Edge length of a streamed chunk
+    static const int CHUNK_WORDS = CHUNK_SIZE * CHUNK_SIZE / CELLS_PER_WORD;
+    static const int CACHE_CHUNKS = 256;  ///< Decoded chunks kept resident (256 KiB)
+
+private:
+    Size size;                  ///< Map dimensions
+    int stride;                 ///< Words per row
+    std::shared_ptr<std::vector<uint64_t>> data; ///< Packed cells, row-major (flat terrain only)
+
+    // NOTE: streamed terrain only, decoded chunks are evicted with the CLOCK policy
+    std::shared_ptr<const TerrainChunkFile> source;
+    mutable std::vector<uint64_t> cache;             ///< CACHE_CHUNKS decoded chunks
+    mutable std::vector<int> cache_chunk;            ///< Chunk held by each slot, -1 if none
+    mutable std::vector<bool> cache_referenced;      ///< Second-chance bit of each slot
+    mutable std::unordered_map<int, int> cache_slot; ///< Chunk to slot lookup
+    mutable int cache_hand;                          ///< Next slot considered for eviction
+    mutable int last_chunk;                          ///< Most recently used chunk
+    mutable int last_slot;                           ///< Slot of the most recently used chunk
+
+    const uint64_t *load_chunk(int chunk) const;
+    void unshare(void) ///< Takes a private copy of a grid still shared with other terrains
+    {
+        if (data.use_count() > 1)
+        {
+            data = std::make_shared<std::vector<uint64_t>>(*data);
+        }
+    };
+    TerrainType get_streamed(Position p) const
+    {
+        int chunk = (p.y / CHUNK_SIZE) * source->get_chunks().w + p.x / CHUNK_SIZE;
+        const uint64_t *words = chunk == last_chunk ? cache.data() + last_slot * CHUNK_WORDS : load_chunk(chunk);
+        int x = p.x % CHUNK_SIZE;
+        return TerrainType((words[(p.y % CHUNK_SIZE) * (CHUNK_SIZE / CELLS_PER_WORD) + x / CELLS_PER_WORD] >> ((x % CELLS_PER_WORD) * 2)) & 3);
+    };
+
+public:
+    Terrain(void) : size(0, 0), stride(0), cache_hand(0), last_chunk(-1), last_slot(0) {};
+
+    static TerrainType classify(char ch);
+    static char to_char(TerrainType type);
+
+    /// @name Construction
+    /// @{
+    void reset(Size s);
+    void set_row(int line, const std::string &row);
+    void compile(const std::vector<std::string> &lines);
+    void stream(const std::shared_ptr<const TerrainChunkFile> &file);
+    void save_chunked(const std::string &path) const;
+    void set(Position p, TerrainType type) ///< Unchecked cell update (flat terrain only)
+    {
+        unshare();
+        uint64_t &word = (*data)[p.y * stride + p.x / CELLS_PER_WORD];
+        int shift = (p.x % CELLS_PER_WORD) * 2;
+        word = (word & ~(uint64_t(3) << shift)) | (uint64_t(type) << shift);
+    };
+    /// @}
+
+    /// @name Access
+    /// @{
+    const Size &get_size(void) const { return size; };
+    bool is_streamed(void) const { return source != nullptr; };
+    size_t get_bytes(void) const { return ((data ? data->size() : 0) + cache.size()) * sizeof(uint64_t); }; ///< Resident cell storage
+    TerrainType get(Position p) const                                                         ///< Unchecked cell lookup
+    {
+        if (source != nullptr)
+        {
+            return get_streamed(p);
+        }
+        return TerrainType(((*data)[p.y * stride + p.x / CELLS_PER_WORD] >> ((p.x % CELLS_PER_WORD) * 2)) & 3);
+    };
+    TerrainType at(Position p) const; ///< Bounds-checked cell lookup
+    bool is_in_map(Position p) const { return p.y >= 0 && p.y < size.h && p.x >= 0 && p.x < size.w; };
+    /// @}
+};
+
+/**
+ * @enum RoutingMode
+ * @brief Cost model used when routing attack missiles over the terrain.
+ */
+enum class RoutingMode : int
+{
+    DIRECT = 0,     ///< Straight lines, terrain is ignored
+    AVOID_SEA = 1,  ///< Crossing sea costs more than crossing land
+    PREFER_SEA = 2  ///< Crossing land costs more than crossing sea
+};
+
+/**
+ * @class FlowField
+ * @brief Shortest-path directions from every cell of the map towards one target.
+ *
+ * Built once per target with a bucketed Dijkstra (Dial's algorithm) running outward from
+ * the target over the 8-connected grid, where entering a cell costs according to its
+ * terrain and the routing mode. Each cell then stores the neighbour to step to, so any
+ * number of missiles sharing the target can follow it at O(1) per step.
+ *
+ * A field takes one byte per cell, plus two more per cell while it is built. Only flat
+ * terrains with no side longer than MAX_SIDE can be routed: a streamed map would have to
+ * decode every chunk, and longer paths would overflow the 16-bit distances.
+ */
+class FlowField
+{
+public:
+    static const uint8_t STAY = 8;  ///< Stored at the target itself
+    static const int MAX_SIDE = 16000; ///< Longest routable map side
+    static const Position STEPS[8]; ///< N, NE, E, SE, S, SW, W, NW
+
+private:
+    Size size;                 ///< Map dimensions
+    Position target;           ///< Cell every path leads to
+    std::vector<uint8_t> next; ///< Index into STEPS of each cell, row-major
+
+public:
+    FlowField(const Terrain &terrain, Position t, RoutingMode mode);
+
+    static int cost(TerrainType type, RoutingMode mode);
+    static bool is_routable(const Terrain &terrain); ///< Whether fields can be built over a terrain
+    size_t get_bytes(void) const { return next.size(); };
+    const Position &get_target(void) const { return target; };
+    bool is_in_field(Position p) const { return p.y >= 0 && p.y < size.h && p.x >= 0 && p.x < size.w; };
+    uint8_t get_next(Position p) const { return next[p.y * size.w + p.x]; }; ///< Unchecked step lookup
+};
+
+#endif